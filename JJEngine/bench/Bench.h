@@ -0,0 +1,80 @@
+#pragma once
+
+#include <chrono>
+#include <vector>
+#include <algorithm>
+#include <glad/glad.h>
+
+namespace JJEngine {
+	class Window;
+}
+
+// Shared helpers of the JJBench benchmarks. Each benchmark prints its own table and
+// returns false if a correctness check failed or it couldn't run.
+namespace Bench {
+	struct Options {
+		// Smaller workloads and fewer repetitions, enough to exercise the code in CI
+		bool quick = false;
+	};
+
+	// Median wall time of repetitions calls, after one warm-up call, in milliseconds
+	template<typename F>
+	double MeasureMilliseconds(int repetitions, F&& function)
+	{
+		function();
+
+		std::vector<double> times;
+		for(int i = 0; i < repetitions; i++)
+		{
+			auto start = std::chrono::high_resolution_clock::now();
+			function();
+			auto end = std::chrono::high_resolution_clock::now();
+			times.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+		}
+
+		std::sort(times.begin(), times.end());
+		return times[times.size() / 2];
+	}
+
+	struct GpuTiming {
+		double submit = 0.0; // CPU time spent issuing the work
+		double total = 0.0;  // Until the GPU finished it
+	};
+
+	// Medians of draw's CPU submit time and of its time to completion, in milliseconds. The GPU is
+	// drained before every repetition so work queued by one doesn't slow down the next.
+	template<typename F>
+	GpuTiming MeasureGpu(int repetitions, F&& draw)
+	{
+		draw();
+		glFinish();
+
+		std::vector<double> submitTimes, totalTimes;
+		for(int i = 0; i < repetitions; i++)
+		{
+			auto start = std::chrono::high_resolution_clock::now();
+			draw();
+			auto submitted = std::chrono::high_resolution_clock::now();
+			glFinish();
+			auto end = std::chrono::high_resolution_clock::now();
+
+			submitTimes.push_back(std::chrono::duration<double, std::milli>(submitted - start).count());
+			totalTimes.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+		}
+
+		std::sort(submitTimes.begin(), submitTimes.end());
+		std::sort(totalTimes.begin(), totalTimes.end());
+		return { submitTimes[submitTimes.size() / 2], totalTimes[totalTimes.size() / 2] };
+	}
+
+	// Headless window shared by the GPU benchmarks, created on first use with the context current
+	// on the calling thread and RenderThread initialised but not started, so recorded work runs inline.
+	// Returns a null pointer if no GL 4.5 context is available.
+	JJEngine::Window* GetGpuContext();
+
+	bool RunJobSystem(const Options& options);
+	bool RunInstancing(const Options& options);
+	bool RunIndirect(const Options& options);
+	bool RunCulling(const Options& options);
+	bool RunFileRead(const Options& options);
+}
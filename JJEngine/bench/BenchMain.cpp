@@ -0,0 +1,109 @@
+// JJBench: micro-benchmarks for engine subsystems.
+//
+//   JJBench [benchmark...] [--quick]
+//
+// Runs the named benchmarks, or all of them. --quick shrinks the workloads so the correctness
+// checks can run in CI. The exit code is non-zero if any check failed. GPU benchmarks render
+// into a headless window, without a display through surfaceless EGL.
+
+#include <string>
+#include <memory>
+#include <iterator>
+#include <algorithm>
+#include <vector>
+#include <iostream>
+#include <string_view>
+
+#include "Bench.h"
+#include "JJEngine/Window.h"
+#include "JJEngine/RenderThread.h"
+
+namespace {
+	struct Benchmark {
+		std::string_view name;
+		bool (*run)(const Bench::Options& options);
+	};
+
+	const Benchmark Benchmarks[] = {
+		{ "jobs", Bench::RunJobSystem },
+		{ "instancing", Bench::RunInstancing },
+		{ "indirect", Bench::RunIndirect },
+		{ "culling", Bench::RunCulling },
+		{ "files", Bench::RunFileRead }
+	};
+
+	std::unique_ptr<JJEngine::Window> s_window;
+	bool s_windowFailed = false;
+
+	void PrintUsage()
+	{
+		std::cerr << "Usage: JJBench [benchmark...] [--quick]\nBenchmarks:";
+		for(const Benchmark& benchmark : Benchmarks)
+			std::cerr << " " << benchmark.name;
+		std::cerr << "\n";
+	}
+}
+
+namespace Bench {
+	JJEngine::Window* GetGpuContext()
+	{
+		if(s_window == nullptr && !s_windowFailed)
+		{
+			try
+			{
+				s_window = std::make_unique<JJEngine::Window>("JJBench", 512, 512, glm::vec4(0, 0, 0, 1), JJEngine::WindowMode::Headless);
+				JJEngine::RenderThread::Init(s_window->GetGLFWWindow());
+			}
+			catch(const std::exception& exception)
+			{
+				std::cout << "  Error: " << exception.what() << "\n";
+				s_windowFailed = true;
+			}
+		}
+		return s_window.get();
+	}
+}
+
+int main(int argc, char** argv)
+{
+	Bench::Options options;
+	std::vector<const Benchmark*> selected;
+	for(int i = 1; i < argc; i++)
+	{
+		std::string_view argument = argv[i];
+		if(argument == "--quick")
+		{
+			options.quick = true;
+			continue;
+		}
+
+		auto it = std::find_if(std::begin(Benchmarks), std::end(Benchmarks), [argument](const Benchmark& benchmark) { return benchmark.name == argument; });
+		if(it == std::end(Benchmarks))
+		{
+			PrintUsage();
+			return 1;
+		}
+		selected.push_back(&*it);
+	}
+
+	if(selected.empty())
+	{
+		for(const Benchmark& benchmark : Benchmarks)
+			selected.push_back(&benchmark);
+	}
+
+	int failed = 0;
+	for(const Benchmark* benchmark : selected)
+	{
+		if(!benchmark->run(options))
+			failed++;
+		std::cout << "\n";
+	}
+
+	if(s_window != nullptr)
+	{
+		JJEngine::RenderThread::Shutdown();
+		s_window.reset();
+	}
+	return failed == 0 ? 0 : 1;
+}
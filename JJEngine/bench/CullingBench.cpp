@@ -0,0 +1,99 @@
+#include <random>
+#include <iomanip>
+#include <iostream>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "Bench.h"
+#include "JJEngine/CpuCulling.h"
+
+using namespace JJEngine;
+
+namespace {
+	const char* GetPathName(CpuCuller::Path path)
+	{
+		switch(path)
+		{
+		case CpuCuller::Path::SSE4: return "SSE4.1";
+		case CpuCuller::Path::AVX2: return "AVX2";
+		default:                    return "scalar";
+		}
+	}
+}
+
+namespace Bench {
+	bool RunCulling(const Options& options)
+	{
+		const uint32_t objectCount = options.quick ? 50000 : 1000000;
+		const int repetitions = options.quick ? 3 : 15;
+
+		// Spheres and boxes scattered through a cube the camera looks into, about a fifth end up visible
+		std::mt19937 random(1234);
+		std::uniform_real_distribution<float> position(-100.0f, 100.0f);
+		std::uniform_real_distribution<float> size(0.1f, 2.0f);
+
+		CpuCuller culler;
+		culler.Reserve(objectCount);
+		for(uint32_t i = 0; i < objectCount; i++)
+		{
+			glm::vec3 center(position(random), position(random), position(random));
+			if(i % 2 == 0)
+			{
+				culler.AddSphere(center, size(random));
+			}
+			else
+			{
+				glm::vec3 extents(size(random), size(random), size(random));
+				culler.AddBox(center - extents, center + extents);
+			}
+		}
+
+		glm::mat4 projection = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 150.0f);
+		glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+		Frustum frustum = Frustum::FromMatrix(projection * view);
+
+		std::cout << "Culling: " << objectCount << " spheres and boxes against one frustum, every path checked against scalar\n";
+		std::cout << "  path      jobs  visible  cull ms  objects/us\n";
+
+		JobSystem jobSystem;
+		std::vector<uint32_t> reference;
+		bool haveReference = false;
+		bool matches = true;
+
+		auto run = [&](CpuCuller::Path path, JobSystem* jobs)
+		{
+			culler.SetPath(path);
+			double time = MeasureMilliseconds(repetitions, [&]() { culler.Cull(frustum, jobs); });
+
+			const std::vector<uint32_t>& visible = culler.GetVisible();
+			if(!haveReference)
+			{
+				reference = visible;
+				haveReference = true;
+			}
+			else if(visible != reference)
+				matches = false;
+
+			std::cout << std::fixed
+				<< "  " << std::left << std::setw(8) << GetPathName(path) << std::right
+				<< "  " << std::setw(4) << (jobs != nullptr ? "yes" : "no")
+				<< "  " << std::setw(7) << visible.size()
+				<< "  " << std::setw(7) << std::setprecision(3) << time
+				<< "  " << std::setw(10) << std::setprecision(1) << objectCount / (time * 1000.0) << "\n";
+		};
+
+		CpuCuller::Path widest = CpuCuller::GetSupportedPath();
+		for(CpuCuller::Path path : { CpuCuller::Path::Scalar, CpuCuller::Path::SSE4, CpuCuller::Path::AVX2 })
+		{
+			if(path <= widest)
+				run(path, nullptr);
+		}
+		run(widest, &jobSystem);
+
+		if(reference.empty())
+			std::cout << "  Warning: nothing was visible, the comparison proves little\n";
+		if(!matches)
+			std::cout << "  Error: SIMD or threaded culling disagrees with the scalar reference\n";
+		return matches;
+	}
+}
@@ -0,0 +1,126 @@
+#include <random>
+#include <sstream>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <filesystem>
+
+#include "Bench.h"
+#include "JJEngine/MappedFile.h"
+
+using namespace JJEngine;
+
+namespace {
+	// Stands in for parsing, touches every byte once. Kept cheap so the read dominates.
+	uint64_t Checksum(const std::byte* data, size_t size)
+	{
+		uint64_t sum = 0;
+		for(size_t i = 0; i < size; i++)
+			sum += (uint64_t)data[i];
+		return sum;
+	}
+
+	// What shader and asset loading did before MappedFile
+	std::string ReadWithStringStream(const std::string& path)
+	{
+		std::ifstream in(path, std::ios::binary);
+		std::stringstream stream;
+		stream << in.rdbuf();
+		return stream.str();
+	}
+
+	// The best case for ifstream, one read into a buffer of the right size
+	std::string ReadWithIfstream(const std::string& path)
+	{
+		std::ifstream in(path, std::ios::binary | std::ios::ate);
+		std::string contents((size_t)in.tellg(), '\0');
+		in.seekg(0);
+		in.read(contents.data(), (std::streamsize)contents.size());
+		return contents;
+	}
+}
+
+namespace Bench {
+	bool RunFileRead(const Options& options)
+	{
+		const size_t fileSize = options.quick ? (size_t)16 << 20 : (size_t)256 << 20;
+		const int repetitions = options.quick ? 3 : 9;
+
+		std::filesystem::path path = std::filesystem::temp_directory_path() / "JJBench-FileRead.bin";
+		{
+			std::mt19937 random(1234);
+			std::vector<uint32_t> block(1 << 16);
+			std::ofstream out(path, std::ios::binary | std::ios::trunc);
+			for(size_t written = 0; written < fileSize; written += block.size() * sizeof(uint32_t))
+			{
+				for(uint32_t& value : block)
+					value = random();
+				out.write((const char*)block.data(), (std::streamsize)std::min(block.size() * sizeof(uint32_t), fileSize - written));
+			}
+			if(!out)
+			{
+				std::cout << "  Error: could not write " << path.string() << "\n";
+				return false;
+			}
+		}
+
+		std::cout << "FileRead: " << (fileSize >> 20) << " MiB file from a warm page cache, read and scanned once\n";
+		std::cout << "  path                     ms  speedup\n";
+
+		const std::string pathString = path.string();
+		uint64_t reference = 0;
+		uint64_t checksum = 0;
+		bool matches = true;
+		double baseline = 0.0;
+
+		auto print = [&](const char* name, double time)
+		{
+			if(baseline == 0.0)
+			{
+				baseline = time;
+				reference = checksum;
+			}
+			else if(checksum != reference)
+				matches = false;
+
+			std::cout << std::fixed
+				<< "  " << std::left << std::setw(18) << name << std::right
+				<< "  " << std::setw(7) << std::setprecision(1) << time
+				<< "  " << std::setw(6) << std::setprecision(2) << baseline / time << "x\n";
+		};
+
+		print("ifstream+sstream", MeasureMilliseconds(repetitions, [&]()
+		{
+			std::string contents = ReadWithStringStream(pathString);
+			checksum = Checksum((const std::byte*)contents.data(), contents.size());
+		}));
+
+		print("ifstream read", MeasureMilliseconds(repetitions, [&]()
+		{
+			std::string contents = ReadWithIfstream(pathString);
+			checksum = Checksum((const std::byte*)contents.data(), contents.size());
+		}));
+
+		bool mapped = true;
+		print("MappedFile", MeasureMilliseconds(repetitions, [&]()
+		{
+			MappedFile file(pathString);
+			mapped = file.IsMapped();
+			checksum = file.GetSize() == fileSize ? Checksum(file.GetData().data(), file.GetSize()) : 0;
+		}));
+
+		// The checksums only catch most mistakes, compare the bytes once
+		{
+			MappedFile file(pathString);
+			if(file.GetText() != ReadWithStringStream(pathString))
+				matches = false;
+		}
+		std::filesystem::remove(path);
+
+		if(!mapped)
+			std::cout << "  Warning: the file was streamed, not mapped\n";
+		if(!matches)
+			std::cout << "  Error: the mapped contents differ from what ifstream read\n";
+		return matches;
+	}
+}
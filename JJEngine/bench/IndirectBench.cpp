@@ -0,0 +1,146 @@
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+
+#include "Bench.h"
+#include "JJEngine/Window.h"
+#include "JJEngine/Shader.h"
+#include "JJEngine/GLState.h"
+#include "JJEngine/IndirectDraw.h"
+
+using namespace JJEngine;
+
+namespace {
+	struct ObjectData {
+		glm::vec4 offsetScale;
+		glm::vec4 color;
+	};
+
+	// Both paths draw with this shader, only the submission differs
+	const char* VertexSource = R"(#version 450 core
+#extension GL_ARB_shader_draw_parameters : enable
+layout (location = 0) in vec2 aPosition;
+layout (location = 15) in uint aObjectIndex;
+
+struct ObjectData
+{
+    vec4 offsetScale;
+    vec4 color;
+};
+
+layout (std430) readonly buffer Objects
+{
+    ObjectData uObjects[];
+};
+
+out vec4 vColor;
+
+void main()
+{
+#ifdef GL_ARB_shader_draw_parameters
+    uint objectIndex = gl_BaseInstanceARB;
+#else
+    uint objectIndex = aObjectIndex;
+#endif
+    ObjectData object = uObjects[objectIndex];
+    vColor = object.color;
+    gl_Position = vec4(aPosition * object.offsetScale.z + object.offsetScale.xy, 0.0, 1.0);
+}
+)";
+
+	const char* FragmentSource = R"(#version 450 core
+in vec4 vColor;
+out vec4 oColor;
+
+void main()
+{
+    oColor = vColor;
+}
+)";
+}
+
+namespace Bench {
+	bool RunIndirect(const Options& options)
+	{
+		const uint32_t objectCount = options.quick ? 1000 : 20000;
+		const int repetitions = options.quick ? 3 : 15;
+
+		std::cout << "Indirect: " << objectCount << " objects of two meshes, one glDrawElements per object vs one glMultiDrawElementsIndirect\n";
+
+		Window* window = GetGpuContext();
+		if(window == nullptr)
+			return false;
+
+		const glm::vec2 trianglePositions[3] = { { 0.0f, 0.0f }, { 1.0f, 0.0f }, { 0.0f, 1.0f } };
+		const uint32_t triangleIndices[3] = { 0, 1, 2 };
+		const glm::vec2 quadPositions[4] = { { 0.0f, 0.0f }, { 1.0f, 0.0f }, { 1.0f, 1.0f }, { 0.0f, 1.0f } };
+		const uint32_t quadIndices[6] = { 0, 1, 2, 2, 3, 0 };
+
+		GeometryPool pool(VertexLayout({ VertexAttribute::Float2 }), 16, 16);
+		const GeometryPool::MeshRange meshes[2] = {
+			pool.Add(trianglePositions, 3, triangleIndices, 3),
+			pool.Add(quadPositions, 4, quadIndices, 6)
+		};
+
+		// One object per cell of a grid covering the viewport
+		uint32_t columns = (uint32_t)std::ceil(std::sqrt((double)objectCount));
+		float cell = 2.0f / (float)columns;
+
+		IndirectDrawList drawList(pool, sizeof(ObjectData));
+		std::vector<DrawElementsIndirectCommand> commands;
+		for(uint32_t i = 0; i < objectCount; i++)
+		{
+			float t = (float)i / (float)objectCount;
+			ObjectData object = { glm::vec4(-1.0f + (float)(i % columns) * cell, -1.0f + (float)(i / columns) * cell, cell * 0.8f, 0.0f), glm::vec4(t, 1.0f - t, 0.5f, 1.0f) };
+
+			const GeometryPool::MeshRange& mesh = meshes[i % 2];
+			drawList.Add(mesh, object);
+			commands.push_back({ mesh.indexCount, 1, mesh.firstIndex, mesh.baseVertex, i });
+		}
+		drawList.Upload();
+
+		Shader shader;
+		shader.LoadFromSource(VertexSource, FragmentSource);
+
+		// What submitting without MDI costs: the same draws and object buffer, one call each
+		auto drawPerObject = [&]()
+		{
+			window->Clear();
+			shader.Use();
+			GLState::BindVertexArray(pool.GetVertexArray());
+			GLState::BindBufferBase(GL_SHADER_STORAGE_BUFFER, drawList.GetBindingPoint(), drawList.GetObjectBuffer());
+			for(const DrawElementsIndirectCommand& command : commands)
+			{
+				glDrawElementsInstancedBaseVertexBaseInstance(GL_TRIANGLES, command.count, GL_UNSIGNED_INT, (const void*)(command.firstIndex * sizeof(uint32_t)),
+					command.instanceCount, command.baseVertex, command.baseInstance);
+			}
+		};
+
+		auto drawIndirect = [&]()
+		{
+			window->Clear();
+			drawList.Draw(shader);
+		};
+
+		GpuTiming perObject = MeasureGpu(repetitions, drawPerObject);
+		std::vector<uint8_t> perObjectPixels;
+		window->ReadPixels(perObjectPixels);
+
+		GpuTiming indirect = MeasureGpu(repetitions, drawIndirect);
+		std::vector<uint8_t> indirectPixels;
+		window->ReadPixels(indirectPixels);
+
+		std::cout << "  path        API calls  submit ms  total ms\n";
+		std::cout << std::fixed << std::setprecision(3)
+			<< "  per-object  " << std::setw(9) << objectCount << "  " << std::setw(9) << perObject.submit << "  " << std::setw(8) << perObject.total << "\n"
+			<< "  indirect    " << std::setw(9) << 1 << "  " << std::setw(9) << indirect.submit << "  " << std::setw(8) << indirect.total << "\n"
+			<< "  submit speedup " << std::setprecision(1) << perObject.submit / indirect.submit << "x\n";
+
+		if(perObjectPixels != indirectPixels)
+		{
+			std::cout << "  Error: the indirect draw rendered a different image than the per-object loop\n";
+			return false;
+		}
+		return true;
+	}
+}
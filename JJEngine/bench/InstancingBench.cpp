@@ -0,0 +1,111 @@
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+
+#include "Bench.h"
+#include "JJEngine/Window.h"
+#include "JJEngine/Mesh.h"
+#include "JJEngine/Shader.h"
+
+using namespace JJEngine;
+
+namespace {
+	const char* FragmentSource = R"(#version 450 core
+out vec4 oColor;
+
+void main()
+{
+    oColor = vec4(1.0);
+}
+)";
+
+	const char* LoopVertexSource = R"(#version 450 core
+layout (location = 0) in vec2 aPosition;
+
+uniform vec2 uOffset;
+
+void main()
+{
+    gl_Position = vec4(aPosition + uOffset, 0.0, 1.0);
+}
+)";
+
+	const char* InstancedVertexSource = R"(#version 450 core
+layout (location = 0) in vec2 aPosition;
+layout (location = 1) in vec2 aOffset;
+
+void main()
+{
+    gl_Position = vec4(aPosition + aOffset, 0.0, 1.0);
+}
+)";
+}
+
+namespace Bench {
+	bool RunInstancing(const Options& options)
+	{
+		const uint32_t objectCount = options.quick ? 1000 : 20000;
+		const int repetitions = options.quick ? 3 : 15;
+
+		std::cout << "Instancing: " << objectCount << " triangles, one Draw per object with a uniform vs one DrawInstanced\n";
+
+		Window* window = GetGpuContext();
+		if(window == nullptr)
+			return false;
+
+		// One triangle per cell of a grid covering the viewport
+		uint32_t columns = (uint32_t)std::ceil(std::sqrt((double)objectCount));
+		float cell = 2.0f / (float)columns;
+		const glm::vec2 vertices[3] = { { 0.0f, 0.0f }, { cell * 0.8f, 0.0f }, { 0.0f, cell * 0.8f } };
+
+		std::vector<glm::vec2> offsets(objectCount);
+		for(uint32_t i = 0; i < objectCount; i++)
+			offsets[i] = glm::vec2(-1.0f + (float)(i % columns) * cell, -1.0f + (float)(i / columns) * cell);
+
+		Mesh mesh(VertexLayout({ VertexAttribute::Float2 }), vertices, 3);
+		mesh.SetInstanceLayout({ VertexAttribute::Float2 }, objectCount);
+
+		Shader loopShader, instancedShader;
+		loopShader.LoadFromSource(LoopVertexSource, FragmentSource);
+		instancedShader.LoadFromSource(InstancedVertexSource, FragmentSource);
+
+		auto drawLoop = [&]()
+		{
+			window->Clear();
+			loopShader.Use();
+			for(const glm::vec2& offset : offsets)
+			{
+				loopShader.SetUniformVec2("uOffset", offset);
+				mesh.Draw(loopShader);
+			}
+		};
+
+		auto drawInstanced = [&]()
+		{
+			window->Clear();
+			mesh.DrawInstanced(instancedShader, offsets.data(), objectCount);
+			Mesh::EndFrame();
+		};
+
+		GpuTiming loop = MeasureGpu(repetitions, drawLoop);
+		std::vector<uint8_t> loopPixels;
+		window->ReadPixels(loopPixels);
+
+		GpuTiming instanced = MeasureGpu(repetitions, drawInstanced);
+		std::vector<uint8_t> instancedPixels;
+		window->ReadPixels(instancedPixels);
+
+		std::cout << "  path       draw calls  submit ms  total ms\n";
+		std::cout << std::fixed << std::setprecision(3)
+			<< "  loop       " << std::setw(10) << objectCount << "  " << std::setw(9) << loop.submit << "  " << std::setw(8) << loop.total << "\n"
+			<< "  instanced  " << std::setw(10) << 1 << "  " << std::setw(9) << instanced.submit << "  " << std::setw(8) << instanced.total << "\n"
+			<< "  submit speedup " << std::setprecision(1) << loop.submit / instanced.submit << "x\n";
+
+		if(loopPixels != instancedPixels)
+		{
+			std::cout << "  Error: the instanced draw rendered a different image than the loop\n";
+			return false;
+		}
+		return true;
+	}
+}
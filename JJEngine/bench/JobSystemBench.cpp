@@ -0,0 +1,94 @@
+#include <cmath>
+#include <atomic>
+#include <thread>
+#include <iomanip>
+#include <iostream>
+
+#include "Bench.h"
+#include "JJEngine/JobSystem.h"
+
+using namespace JJEngine;
+
+namespace {
+	// Enough arithmetic per element that scheduling overhead doesn't dominate
+	float Work(uint32_t index)
+	{
+		float value = (float)index;
+		for(int i = 0; i < 64; i++)
+			value = value * 0.999f + std::sin(value) * 0.5f;
+		return value;
+	}
+
+	std::vector<uint32_t> GetWorkerCounts()
+	{
+		uint32_t hardwareThreads = std::max(1u, std::thread::hardware_concurrency());
+		std::vector<uint32_t> counts;
+		for(uint32_t count = 1; count < hardwareThreads; count *= 2)
+			counts.push_back(count);
+		counts.push_back(hardwareThreads);
+		return counts;
+	}
+}
+
+namespace Bench {
+	bool RunJobSystem(const Options& options)
+	{
+		const uint32_t elementCount = options.quick ? 1 << 16 : 1 << 21;
+		const uint32_t jobCount = options.quick ? 1000 : 20000;
+		const int repetitions = options.quick ? 3 : 9;
+
+		std::vector<float> output(elementCount);
+		float reference = 0.0f;
+
+		std::cout << "JobSystem: ParallelFor over " << elementCount << " elements, then " << jobCount << " small jobs waited on by one counter\n";
+		std::cout << "  workers  parallel-for ms  speedup  small jobs ms  jobs/ms\n";
+
+		double baseline = 0.0;
+		bool matches = true;
+		for(uint32_t workerCount : GetWorkerCounts())
+		{
+			JobSystem jobSystem(workerCount);
+
+			double parallelTime = MeasureMilliseconds(repetitions, [&]()
+			{
+				jobSystem.ParallelFor(elementCount, 0, [&output](uint32_t begin, uint32_t end)
+				{
+					for(uint32_t i = begin; i < end; i++)
+						output[i] = Work(i);
+				});
+			});
+
+			// Every worker count has to produce the same result
+			float checksum = 0.0f;
+			for(float value : output)
+				checksum += value;
+			if(baseline == 0.0)
+				reference = checksum;
+			else if(checksum != reference)
+				matches = false;
+
+			std::atomic<uint32_t> completed = 0;
+			double jobTime = MeasureMilliseconds(repetitions, [&]()
+			{
+				JobCounter counter;
+				for(uint32_t i = 0; i < jobCount; i++)
+					jobSystem.Run([&completed]() { completed.fetch_add(1, std::memory_order_relaxed); }, &counter);
+				jobSystem.Wait(counter);
+			});
+
+			if(baseline == 0.0)
+				baseline = parallelTime;
+
+			std::cout << std::fixed << std::setprecision(3)
+				<< "  " << std::setw(7) << workerCount
+				<< "  " << std::setw(15) << parallelTime
+				<< "  " << std::setw(6) << std::setprecision(2) << baseline / parallelTime << "x"
+				<< "  " << std::setw(13) << std::setprecision(3) << jobTime
+				<< "  " << std::setw(7) << std::setprecision(0) << jobCount / jobTime << "\n";
+		}
+
+		if(!matches)
+			std::cout << "  Error: results differ between worker counts\n";
+		return matches;
+	}
+}
@@ -0,0 +1,170 @@
+#pragma once
+
+#include <mutex>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <utility>
+#include <memory>
+#include <memory_resource>
+
+namespace JJEngine {
+	struct AllocationStats {
+		size_t bytes = 0;
+		size_t allocations = 0;
+		size_t overflowBytes = 0; // Served by the upstream resource because the arena was full
+	};
+
+	// Bump allocator over a fixed block. Allocation is a single atomic add, so any thread may allocate;
+	// deallocation is a no-op and everything is released at once by Reset.
+	class LinearAllocator : public std::pmr::memory_resource {
+	public:
+		LinearAllocator(size_t capacity, std::pmr::memory_resource* upstream = std::pmr::new_delete_resource());
+		~LinearAllocator() override;
+
+		LinearAllocator(const LinearAllocator&) = delete;
+		LinearAllocator& operator=(const LinearAllocator&) = delete;
+
+		void* Allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+
+		template<typename T, typename... Args>
+		T* New(Args&&... args)
+		{
+			return new (Allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+		}
+
+		// Not thread safe, nothing may allocate while resetting
+		void Reset();
+
+		// Swaps in a block of at least capacity bytes, only allowed while empty (right after Reset)
+		void Reserve(size_t capacity);
+
+		size_t GetCapacity() const { return m_capacity; }
+		AllocationStats GetStats() const;
+
+	protected:
+		void* do_allocate(size_t bytes, size_t alignment) override { return Allocate(bytes, alignment); }
+		void do_deallocate(void*, size_t, size_t) override {}
+		bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+	private:
+		void* AllocateOverflow(size_t size, size_t alignment);
+
+		std::unique_ptr<std::byte[]> m_buffer;
+		size_t m_capacity;
+		std::atomic<size_t> m_offset = 0;
+		std::atomic<size_t> m_allocations = 0;
+
+		struct OverflowBlock {
+			void* pointer;
+			size_t size;
+			size_t alignment;
+		};
+
+		std::pmr::memory_resource* m_upstream;
+		std::mutex m_overflowMutex;
+		std::vector<OverflowBlock> m_overflow;
+		size_t m_overflowBytes = 0;
+	};
+
+	// Two frame arenas used alternately. Data written during frame N stays valid through frame N+1,
+	// so a consumer running one frame behind (e.g. a render thread) can still read it.
+	class FrameAllocator {
+	public:
+		FrameAllocator(size_t capacityPerFrame);
+
+		// Call at the start of every frame, resets the arena last used two frames ago
+		void BeginFrame();
+
+		LinearAllocator& GetCurrent() { return *m_arenas[m_current]; }
+		LinearAllocator& GetPrevious() { return *m_arenas[m_current ^ 1]; }
+
+		void* Allocate(size_t size, size_t alignment = alignof(std::max_align_t)) { return GetCurrent().Allocate(size, alignment); }
+
+		template<typename T, typename... Args>
+		T* New(Args&&... args) { return GetCurrent().New<T>(std::forward<Args>(args)...); }
+
+		// Usage of the last completed frame
+		const AllocationStats& GetLastFrameStats() const { return m_lastFrameStats; }
+
+	private:
+		std::array<std::unique_ptr<LinearAllocator>, 2> m_arenas;
+		uint32_t m_current = 0;
+		AllocationStats m_lastFrameStats;
+	};
+
+	// Fixed-size blocks with an intrusive free list. Not thread safe, give each thread or subsystem its own pool.
+	// Requests larger than the block size, or made once the pool is exhausted, go to the upstream resource.
+	class PoolAllocator : public std::pmr::memory_resource {
+	public:
+		PoolAllocator(size_t blockSize, size_t blockCount, size_t alignment = alignof(std::max_align_t),
+			std::pmr::memory_resource* upstream = std::pmr::new_delete_resource());
+
+		PoolAllocator(const PoolAllocator&) = delete;
+		PoolAllocator& operator=(const PoolAllocator&) = delete;
+
+		// Returns a null pointer once every block is in use
+		void* Allocate();
+		void Free(void* block);
+
+		size_t GetBlockSize() const { return m_blockSize; }
+		size_t GetBlockCount() const { return m_blockCount; }
+		size_t GetUsedBlocks() const { return m_usedBlocks; }
+
+		// Allocations since the last ResetStats
+		const AllocationStats& GetStats() const { return m_stats; }
+		void ResetStats() { m_stats = AllocationStats(); }
+
+	protected:
+		void* do_allocate(size_t bytes, size_t alignment) override;
+		void do_deallocate(void* pointer, size_t bytes, size_t alignment) override;
+		bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+	private:
+		struct FreeBlock {
+			FreeBlock* next;
+		};
+
+		bool Owns(void* pointer) const;
+
+		std::unique_ptr<std::byte[]> m_buffer;
+		std::byte* m_blocks;
+		size_t m_blockSize;
+		size_t m_blockCount;
+		size_t m_alignment;
+		size_t m_usedBlocks = 0;
+		FreeBlock* m_freeList = nullptr;
+
+		std::pmr::memory_resource* m_upstream;
+		AllocationStats m_stats;
+	};
+
+	// Typed pool, New/Delete construct and destroy objects in place
+	template<typename T>
+	class ObjectPool {
+	public:
+		ObjectPool(size_t capacity) : m_pool(sizeof(T) < sizeof(void*) ? sizeof(void*) : sizeof(T), capacity, alignof(T) < alignof(void*) ? alignof(void*) : alignof(T)) {}
+
+		template<typename... Args>
+		T* New(Args&&... args)
+		{
+			return new (m_pool.allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+		}
+
+		void Delete(T* object)
+		{
+			if(object == nullptr)
+				return;
+			object->~T();
+			m_pool.deallocate(object, sizeof(T), alignof(T));
+		}
+
+		PoolAllocator& GetAllocator() { return m_pool; }
+
+	private:
+		PoolAllocator m_pool;
+	};
+}
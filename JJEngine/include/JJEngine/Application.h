@@ -1,25 +1,79 @@
 #pragma once
 
-namespace JJEngine {
-	class Window;
+#include <memory>
+#include <string>
+
+#include "FrameStats.h"
+#include "Allocators.h"
+#include "JobSystem.h"
+#include "Profiler.h"
+#include "Window.h"
 
+namespace JJEngine {
 
 	class Application {
 	public:
 		static Application* GetInstance() { return s_instance; }
 
-		Application(const char* windowTitle,  bool createConsoleOnDebug = true);
-		~Application();
+		Application(const char* windowTitle,  bool createConsoleOnDebug = true, WindowMode windowMode = WindowMode::Windowed);
+		virtual ~Application();
+
+		// Runs until the window closes or Close is called.
+		// OnUpdate is called at the fixed timestep, OnRender once per frame with the
+		// interpolation alpha between the last two simulation states.
+		void Run();
+		void Close() { m_running = false; }
 
 		Window& GetWindow() const { return *m_window; }
+		JobSystem& GetJobSystem() const { return *m_jobSystem; }
+
+		// Transient memory for the current frame, released two frames later. Render commands
+		// may read it with one frame in flight, use RenderThread::Allocate beyond that.
+		FrameAllocator& GetFrameAllocator() { return m_frameAllocator; }
 
 		bool IsRunning() const { return m_running; }
 
+		double GetFixedTimestep() const { return m_fixedTimestep; }
+		void SetFixedTimestep(double seconds) { m_fixedTimestep = seconds; }
+
+		// Frame times above this are clamped so a long stall can't trigger
+		// more catch-up updates than the next frame can afford
+		double GetMaxFrameTime() const { return m_maxFrameTime; }
+		void SetMaxFrameTime(double seconds) { m_maxFrameTime = seconds; }
+
+		const FrameStats& GetFrameStats() const { return m_frameStats; }
+
+		// Frames the main thread may run ahead of the render thread, applied when Run starts.
+		// 0 renders on the main thread, 1 overlaps simulation with submission at one frame of latency,
+		// 2 trades another frame of latency for throughput. With a render thread, GL calls made
+		// from OnRender have to go through RenderThread::Submit.
+		uint32_t GetFramesInFlight() const { return m_framesInFlight; }
+		void SetFramesInFlight(uint32_t frames) { m_framesInFlight = frames; }
+
+		// Records JJ_PROFILE_* scopes from every thread and writes them as Chrome trace JSON on end
+		void BeginProfileSession(const std::string& filePath) { Profiler::BeginSession(filePath); }
+		void EndProfileSession() { Profiler::EndSession(); }
+
+	protected:
+		virtual void OnUpdate(double /*timestep*/) {}
+		virtual void OnRender(double /*alpha*/) {}
+
 	private:
 		static Application* s_instance;
 
 		std::unique_ptr<Window> m_window;
+		std::unique_ptr<JobSystem> m_jobSystem;
 
 		bool m_running;
+
+		double m_fixedTimestep = 1.0 / 60.0;
+		double m_maxFrameTime = 0.25;
+
+		uint32_t m_framesInFlight = 1;
+
+		FrameStats m_frameStats;
+
+		static constexpr size_t FrameArenaSize = 8 * 1024 * 1024;
+		FrameAllocator m_frameAllocator = FrameAllocator(FrameArenaSize);
 	};
-}
\ No newline at end of file
+}
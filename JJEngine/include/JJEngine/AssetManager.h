@@ -0,0 +1,152 @@
+#pragma once
+
+#include <span>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <type_traits>
+#include <glad/glad.h>
+
+namespace JJEngine {
+	class JobSystem;
+	struct AssetPipeline;
+
+	// Something loaded from one file in three steps: read by the asset I/O threads, decoded on the
+	// job system, then uploaded on the context thread a slice at a time. Subclasses implement the
+	// last two and are created through AssetManager::Load.
+	class Asset {
+	public:
+		enum class State : uint8_t { Loading, Ready, Failed };
+
+		virtual ~Asset() = default;
+
+		State GetState() const { return m_state.load(std::memory_order_acquire); }
+		bool IsReady() const { return GetState() == State::Ready; }
+		const std::string& GetPath() const { return m_path; }
+
+	private:
+		friend struct AssetPipeline;
+
+		// Worker thread. data is the whole file, it may be moved from to keep it for Upload.
+		// Returning false fails the asset.
+		virtual bool Decode(std::vector<std::byte>& data) = 0;
+
+		// Context thread, called once per slice until it returns true. A slice should take a small
+		// fraction of the upload budget, later slices run in the same or following frames.
+		virtual bool Upload() = 0;
+
+		// Bytes the next Upload call will transfer, checked against the per-frame byte budget
+		virtual size_t GetNextUploadSize() const { return 0; }
+
+		std::string m_path;
+		std::atomic<State> m_state = State::Loading;
+	};
+
+	// Shared reference to an asset that may still be loading. Get returns null until it is ready,
+	// so drawing code can skip the asset or use a placeholder without ever waiting for it.
+	template<typename T>
+	class AssetHandle {
+	public:
+		AssetHandle() = default;
+		explicit AssetHandle(std::shared_ptr<T> asset) : m_asset(std::move(asset)) {}
+
+		bool IsValid() const { return m_asset != nullptr; }
+		bool IsReady() const { return m_asset != nullptr && m_asset->IsReady(); }
+		bool IsFailed() const { return m_asset != nullptr && m_asset->GetState() == Asset::State::Failed; }
+
+		T* Get() const { return IsReady() ? m_asset.get() : nullptr; }
+		T* operator->() const { return Get(); }
+		explicit operator bool() const { return IsReady(); }
+
+		void Reset() { m_asset.reset(); }
+
+	private:
+		std::shared_ptr<T> m_asset;
+	};
+
+	// Loads assets in the background so level loads and streaming never stall a frame. Files are
+	// read with io_uring where the kernel allows it and by a small pool of pread threads otherwise,
+	// decoded on the job system, and uploaded through RenderThread within a time and byte budget per frame.
+	// Mounted packs are searched before loose files, their entries are copied or decompressed
+	// straight from the mapped pack on the job system, or on the I/O threads without one.
+	// Only the main thread may call into the manager, assets are released on it as well.
+	class AssetManager {
+	public:
+		enum class IoBackend { None, IoUring, ThreadPool };
+
+		struct Statistics {
+			uint32_t pending = 0;    // Loading, anywhere in the pipeline
+			uint32_t loaded = 0;     // Became ready since Init
+			uint32_t failed = 0;
+			uint32_t packLoads = 0;  // Loads started from a mounted pack rather than a loose file
+			uint64_t bytesRead = 0;
+			double uploadTime = 0.0; // Spent uploading in the last frame that had uploads, ms
+			size_t uploadBytes = 0;  // Transferred in that frame
+		};
+
+		// Without a job system, or one with only the calling thread as worker, assets are decoded on the I/O threads
+		static void Init(JobSystem* jobSystem = nullptr, uint32_t ioThreads = 2);
+		static void Shutdown();
+
+		// Paths starting with mountPoint are looked up in the pack, with the mount point removed.
+		// Packs mounted later take precedence. Returns false if the pack can't be opened.
+		static bool Mount(const std::string& packPath, const std::string& mountPoint = {});
+
+		// Loading the same path again returns the same asset while anything still holds it, the
+		// constructor arguments only apply to the first load. Before Init the asset is loaded synchronously.
+		template<typename T, typename... Args>
+		static AssetHandle<T> Load(const std::string& path, Args&&... args)
+		{
+			static_assert(std::is_base_of_v<Asset, T>, "Assets must derive from Asset");
+
+			if(std::shared_ptr<T> existing = std::dynamic_pointer_cast<T>(Find(path)))
+				return AssetHandle<T>(std::move(existing));
+
+			auto asset = std::make_shared<T>(std::forward<Args>(args)...);
+			Enqueue(asset, path);
+			return AssetHandle<T>(std::move(asset));
+		}
+
+		// Starts this frame's uploads and releases finished loads, once per frame on the main thread
+		static void Update();
+
+		// Context thread time and bytes transferred per frame for uploads, whichever runs out first
+		// ends the frame's uploads. At least one slice runs every frame regardless.
+		static void SetUploadBudget(double milliseconds);
+		static double GetUploadBudget();
+		static void SetUploadByteBudget(size_t bytes);
+		static size_t GetUploadByteBudget();
+
+		static IoBackend GetIoBackend();
+		static Statistics GetStats();
+
+	private:
+		static std::shared_ptr<Asset> Find(const std::string& path);
+		static void Enqueue(std::shared_ptr<Asset> asset, const std::string& path);
+	};
+
+	// File contents in an immutable GL buffer, for data baked offline such as vertices or indices
+	class BufferAsset : public Asset {
+	public:
+		~BufferAsset() override;
+
+		GLuint GetBuffer() const { return m_buffer; }
+		size_t GetSize() const { return m_size; }
+
+	private:
+		static constexpr size_t UploadSliceSize = 4 * 1024 * 1024;
+
+		bool Decode(std::vector<std::byte>& data) override;
+		bool Upload() override;
+		size_t GetNextUploadSize() const override;
+
+		std::vector<std::byte> m_data;
+		size_t m_size = 0;
+		size_t m_uploaded = 0;
+		GLuint m_buffer = 0;
+	};
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <array>
+#include <vector>
+#include <cstdint>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "Shader.h"
+
+namespace JJEngine {
+	// State shared by draws of the same surface. Bound once per run of consecutive draws using it.
+	struct Material {
+		static constexpr uint32_t MaxTextures = 8;
+
+		uint16_t id = 0; // Sort key bits, materials that should batch together need distinct ids
+		std::array<GLuint, MaxTextures> textures{};
+		uint32_t textureCount = 0;
+		glm::vec4 color = glm::vec4(1.0f); // Uploaded to uColor when the shader has it, once per run of the material
+	};
+
+	// Draws submitted with a 64-bit sort key, radix sorted and dispatched in key order.
+	// The key only decides the order; state is compared directly, so key collisions cost
+	// batching but never correctness.
+	class CommandBucket {
+	public:
+		struct Draw {
+			Shader* shader = nullptr;
+			const Material* material = nullptr;
+			GLuint vertexArray = 0;
+
+			GLenum mode = GL_TRIANGLES;
+			GLenum indexType = GL_NONE; // GL_NONE draws arrays
+			uint32_t first = 0;         // First vertex, or first index for indexed draws
+			uint32_t count = 0;
+			int32_t baseVertex = 0;
+			uint32_t instanceCount = 1;
+
+			glm::mat4 transform = glm::mat4(1.0f); // Uploaded to uModel when the shader has it and it differs from the previous draw
+		};
+
+		struct Statistics {
+			uint32_t draws = 0;
+			uint32_t stateChanges = 0;
+			uint32_t stateChangesAvoided = 0; // Compared to rebinding shader, vertex array and material every draw
+		};
+
+		// Most significant first: layer 8 bits, shader 16, material 16, depth 24.
+		// Depth is clamped to [0, 1], backToFront inverts it for blended layers.
+		static uint64_t MakeKey(uint8_t layer, uint16_t shader, uint16_t material, float depth, bool backToFront = false);
+		static uint64_t MakeKey(uint8_t layer, const Shader& shader, const Material* material, float depth, bool backToFront = false);
+
+		CommandBucket(uint32_t reserve = 1024);
+
+		// Shader and material must stay alive until the dispatched frame has executed
+		void Submit(uint64_t key, const Draw& draw);
+
+		// Sorts, records the draws through RenderThread and clears the bucket
+		void Dispatch();
+
+		uint32_t GetDrawCount() const { return (uint32_t)m_draws.size(); }
+
+		// Counters of the last Dispatch
+		const Statistics& GetStats() const { return m_stats; }
+
+	private:
+		struct SortEntry {
+			uint64_t key;
+			uint32_t index;
+		};
+
+		void Sort();
+
+		std::vector<Draw> m_draws;
+		std::vector<SortEntry> m_entries;
+		std::vector<SortEntry> m_scratch;
+
+		Statistics m_stats;
+	};
+}
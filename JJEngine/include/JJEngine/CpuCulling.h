@@ -0,0 +1,74 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <glm/glm.hpp>
+
+#include "Frustum.h"
+#include "JobSystem.h"
+
+namespace JJEngine {
+	// Frustum culling of spheres and axis-aligned boxes on the CPU. Bounds are kept as structure of
+	// arrays so eight objects are tested per AVX2 iteration (four with SSE4.1), the widest path the
+	// CPU supports is picked at runtime and the scalar path is the reference for both.
+	class CpuCuller {
+	public:
+		enum class Path { Scalar, SSE4, AVX2 };
+
+		struct Statistics {
+			uint32_t objects = 0;
+			uint32_t visible = 0;
+			double cullTime = 0.0;             // Wall time of the last Cull, ms
+			double objectsPerMicrosecond = 0.0;
+			Path path = Path::Scalar;
+		};
+
+		CpuCuller();
+
+		// Return the object index, which is what Cull reports for visible objects
+		uint32_t AddSphere(const glm::vec3& center, float radius);
+		uint32_t AddBox(const glm::vec3& min, const glm::vec3& max);
+
+		void SetSphere(uint32_t index, const glm::vec3& center, float radius);
+		void SetBox(uint32_t index, const glm::vec3& min, const glm::vec3& max);
+
+		void Reserve(uint32_t objectCount);
+		void Clear();
+
+		// Returns the indices of objects touching the frustum in ascending order. With a job
+		// system the objects are split into batches across its workers, the call still blocks.
+		const std::vector<uint32_t>& Cull(const Frustum& frustum, JobSystem* jobSystem = nullptr);
+
+		const std::vector<uint32_t>& GetVisible() const { return m_visible; }
+		uint32_t GetObjectCount() const { return m_count; }
+		Statistics GetStats() const { return m_stats; }
+
+		// Widest path supported by this CPU
+		static Path GetSupportedPath();
+
+		// Forces a narrower path, e.g. to compare against the scalar reference. Clamped to what is supported.
+		void SetPath(Path path);
+		Path GetPath() const { return m_path; }
+
+	private:
+		// Lanes per iteration of the widest path, storage is padded to a multiple of it
+		static constexpr uint32_t Width = 8;
+
+		uint32_t Allocate();
+		void Set(uint32_t index, const glm::vec3& center, float radius, const glm::vec3& extents);
+		uint32_t CullRange(const Frustum& frustum, uint32_t begin, uint32_t end, uint32_t* output) const;
+
+		// A sphere has zero extents and a box zero radius, so one test covers both:
+		// an object is outside a plane when its center is further out than radius + dot(|n|, extents)
+		std::vector<float> m_centerX, m_centerY, m_centerZ;
+		std::vector<float> m_radius;
+		std::vector<float> m_extentX, m_extentY, m_extentZ;
+		uint32_t m_count = 0;
+
+		std::vector<uint32_t> m_visible;
+		std::vector<uint32_t> m_batchCounts;
+
+		Path m_path;
+		Statistics m_stats;
+	};
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <chrono>
+#include <filesystem>
+
+namespace JJEngine {
+	// Reports changes to a set of files. Uses inotify on Linux, watching the parent directories so
+	// editors that save by renaming a temporary file are caught too. Elsewhere, or if inotify is
+	// unavailable, modification times are compared at most every PollInterval.
+	class FileWatcher {
+	public:
+		static constexpr std::chrono::milliseconds PollInterval = std::chrono::milliseconds(250);
+
+		FileWatcher();
+		~FileWatcher();
+
+		FileWatcher(const FileWatcher&) = delete;
+		FileWatcher& operator=(const FileWatcher&) = delete;
+
+		void Watch(const std::string& path);
+		void Unwatch(const std::string& path);
+
+		// Paths as passed to Watch that changed since the last call, each reported once. Never blocks.
+		std::vector<std::string> Poll();
+
+		bool IsUsingNotifications() const { return m_notifyHandle >= 0; }
+
+	private:
+		struct WatchedFile {
+			std::string path;
+			std::filesystem::path absolutePath;
+			std::filesystem::file_time_type lastWrite;
+		};
+
+		struct WatchedDirectory {
+			int handle;
+			std::filesystem::path path;
+		};
+
+		void PollNotifications(std::vector<std::string>& changed);
+		void PollTimestamps(std::vector<std::string>& changed);
+
+		std::vector<WatchedFile> m_files;
+		std::vector<WatchedDirectory> m_directories;
+
+		int m_notifyHandle = -1;
+		std::chrono::steady_clock::time_point m_lastPoll;
+	};
+}
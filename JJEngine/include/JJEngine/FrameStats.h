@@ -0,0 +1,38 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <cstddef>
+
+namespace JJEngine {
+	// Rolling window of frame times. All queries are in milliseconds.
+	class FrameStats {
+	public:
+		static constexpr size_t SampleCount = 240;
+		static constexpr size_t HistogramBucketCount = 34;
+		static constexpr double HistogramBucketWidth = 1.0; // Milliseconds, the last bucket collects everything slower
+
+		void AddFrame(double milliseconds);
+		void Reset();
+
+		size_t GetSampleCount() const { return m_count; }
+		double GetLast() const;
+
+		double GetMin() const;
+		double GetMax() const;
+		double GetAverage() const;
+		double GetPercentile(double percentile) const;
+		double GetP99() const { return GetPercentile(99.0); }
+
+		const std::array<uint32_t, HistogramBucketCount>& GetHistogram() const { return m_histogram; }
+
+	private:
+		static size_t GetBucket(double milliseconds);
+
+		std::array<double, SampleCount> m_samples{};
+		std::array<uint32_t, HistogramBucketCount> m_histogram{};
+		size_t m_next = 0;
+		size_t m_count = 0;
+		double m_total = 0.0;
+	};
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <array>
+#include <glm/glm.hpp>
+
+namespace JJEngine {
+	// Six planes as (normal, distance) with normals pointing inwards, so a point p is inside
+	// when dot(plane.xyz, p) + plane.w >= 0 for every plane. Order: left, right, bottom, top, near, far.
+	struct Frustum {
+		std::array<glm::vec4, 6> planes;
+
+		// Gribb-Hartmann extraction, planes are in the space the matrix transforms from
+		static Frustum FromMatrix(const glm::mat4& viewProjection);
+
+		bool IntersectsSphere(const glm::vec3& center, float radius) const;
+	};
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstdint>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+namespace JJEngine {
+	// Shadow of the context's binding and fixed-function state. Calls that would not change
+	// anything are dropped before they reach the driver. Only call from the thread owning the
+	// context; code that touches state directly with gl* calls must Invalidate afterwards.
+	class GLState {
+	public:
+		static constexpr uint32_t MaxTextureUnits = 32;
+		static constexpr uint32_t MaxIndexedBindings = 32;
+
+		struct Statistics {
+			uint32_t issued = 0;
+			uint32_t filtered = 0;
+		};
+
+		static void UseProgram(GLuint program);
+		static void BindVertexArray(GLuint vertexArray);
+		static void BindFramebuffer(GLenum target, GLuint framebuffer);
+
+		// GL_ELEMENT_ARRAY_BUFFER is vertex array state and is not tracked, use glVertexArrayElementBuffer
+		static void BindBuffer(GLenum target, GLuint buffer);
+		static void BindBufferBase(GLenum target, GLuint index, GLuint buffer);
+		static void BindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size);
+
+		static void BindTextureUnit(GLuint unit, GLuint texture);
+		// Issued as a single glBindTextures when any unit differs
+		static void BindTextures(GLuint first, GLsizei count, const GLuint* textures);
+
+		static void SetBlend(bool enabled);
+		static void SetBlendFunc(GLenum source, GLenum destination);
+		static void SetDepthTest(bool enabled);
+		static void SetDepthWrite(bool enabled);
+		static void SetDepthFunc(GLenum function);
+		static void SetCullFace(bool enabled);
+		static void SetCullMode(GLenum mode);
+		static void SetClearColor(const glm::vec4& color);
+		static void SetViewport(GLint x, GLint y, GLsizei width, GLsizei height);
+
+		// Deletes the object and forgets any binding of it, so a recycled name is bound again
+		static void DeleteProgram(GLuint program);
+		static void DeleteVertexArray(GLuint vertexArray);
+		static void DeleteFramebuffer(GLuint framebuffer);
+		static void DeleteBuffer(GLuint buffer);
+		static void DeleteTexture(GLuint texture);
+
+		// Marks everything unknown, the next call of each kind is always issued
+		static void Invalidate();
+
+		// Publishes this frame's counters and starts counting the next frame
+		static void EndFrame();
+
+		// Counters of the last completed frame, safe to read from any thread
+		static Statistics GetStats();
+	};
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <cstdint>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "Shader.h"
+#include "IndirectDraw.h"
+
+namespace JJEngine {
+	// Max-depth mip chain of a depth buffer for occlusion tests. Each texel holds the farthest
+	// depth of the area it covers, odd edges fold into the last texel so no depth is lost.
+	class HiZPyramid {
+	public:
+		HiZPyramid(uint32_t width, uint32_t height);
+		~HiZPyramid();
+
+		HiZPyramid(const HiZPyramid&) = delete;
+		HiZPyramid& operator=(const HiZPyramid&) = delete;
+
+		// depthTexture must be a sampleable depth texture of the pyramid's size without compare mode.
+		// Usually last frame's depth, so occlusion lags one frame behind. Recorded through RenderThread.
+		void Build(GLuint depthTexture);
+
+		GLuint GetTextureID() const { return m_texture; }
+		uint32_t GetWidth() const { return m_width; }
+		uint32_t GetHeight() const { return m_height; }
+		uint32_t GetLevelCount() const { return m_levelCount; }
+
+	private:
+		GLuint m_texture = 0;
+		uint32_t m_width, m_height;
+		uint32_t m_levelCount;
+
+		Shader m_copyShader;
+		Shader m_downsampleShader;
+	};
+
+	// Frustum and optional Hi-Z occlusion culling of an IndirectDrawList in a compute shader.
+	// Survivors are compacted into a second command buffer with an atomic counter that
+	// glMultiDrawElementsIndirectCount reads directly, so visibility never reaches the CPU.
+	//
+	// Without 4.6 or GL_ARB_indirect_parameters culled commands keep their slot with an instance
+	// count of 0 and the full list is drawn. Compaction reorders draws, so object shaders must
+	// index their data with gl_BaseInstance (gl_BaseInstanceARB) rather than gl_DrawID, or with
+	// aObjectIndex where shader draw parameters are missing (see IndirectDrawList).
+	class GpuCuller {
+	public:
+		struct Statistics {
+			uint32_t objects = 0;     // Objects tested by the last CullAndDraw
+			bool compacting = false;  // Whether the driver supports count-driven multi-draw
+		};
+
+		GpuCuller();
+		~GpuCuller();
+
+		GpuCuller(const GpuCuller&) = delete;
+		GpuCuller& operator=(const GpuCuller&) = delete;
+
+		// World space bounding spheres (center, radius) in object index order of the draw list.
+		// Copied, only needs to be called again when objects move.
+		void SetBounds(const glm::vec4* spheres, uint32_t count);
+
+		// Uploads the list, culls it and draws the survivors. The list, shader and pyramid must outlive the frame.
+		void CullAndDraw(IndirectDrawList& list, Shader& shader, const glm::mat4& viewProjection, const HiZPyramid* hiZ = nullptr);
+
+		bool IsCompacting() const { return m_multiDrawCount != nullptr; }
+		Statistics GetStats() const { return m_stats; }
+
+	private:
+		void Reserve(uint32_t objectCount);
+
+		Shader m_cullShader;
+		PFNGLMULTIDRAWELEMENTSINDIRECTCOUNTPROC m_multiDrawCount = nullptr;
+
+		GLuint m_boundsBinding, m_commandsInBinding, m_commandsOutBinding, m_drawCountBinding;
+		uint32_t m_boundsCount = 0;
+
+		// GPU side, only touched by commands on the context thread
+		GLuint m_boundsBuffer = 0;
+		GLuint m_commandBuffer = 0;
+		GLuint m_countBuffer = 0;
+		uint32_t m_boundsCapacity = 0;
+		uint32_t m_capacity = 0;
+
+		Statistics m_stats;
+		bool m_warnedMissingBounds = false;
+	};
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <glad/glad.h>
+
+namespace JJEngine {
+	// GPU pass timings from GL_TIMESTAMP queries. Results are read back FramesInFlight frames later
+	// and only once the driver reports them available, so reading never stalls the pipeline.
+	class GpuProfiler {
+	public:
+		static constexpr uint32_t FramesInFlight = 4;
+
+		struct PassTiming {
+			std::string name;
+			double milliseconds = 0.0;
+		};
+
+		static void Init();
+		static void Shutdown();
+
+		// Collects finished results and starts recording a new frame. Queries are issued through
+		// RenderThread::Submit, so they land on whichever thread owns the context.
+		static void BeginFrame();
+
+		// Passes may nest, timings of passes with the same name within a frame are summed.
+		// The name must outlive the frame, with a render thread the pass is recorded later.
+		static void BeginPass(const char* name);
+		static void EndPass();
+
+		// Timings of the most recent frame whose results have arrived
+		static std::vector<PassTiming> GetPassTimings();
+		static double GetPassTime(const std::string& name);
+
+		// Frames whose queries weren't ready when their slot came round again and were dropped
+		static uint32_t GetDroppedFrames();
+	};
+
+	class GpuProfileScope {
+	public:
+		GpuProfileScope(const char* name) { GpuProfiler::BeginPass(name); }
+		~GpuProfileScope() { GpuProfiler::EndPass(); }
+
+		GpuProfileScope(const GpuProfileScope&) = delete;
+		GpuProfileScope& operator=(const GpuProfileScope&) = delete;
+	};
+}
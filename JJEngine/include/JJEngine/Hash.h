@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+
+namespace JJEngine {
+	// FNV-1a, usable at compile time so string literals can be hashed for free
+	constexpr uint32_t Fnv1a32Offset = 2166136261u;
+	constexpr uint32_t Fnv1a32Prime = 16777619u;
+	constexpr uint64_t Fnv1a64Offset = 14695981039346656037ull;
+	constexpr uint64_t Fnv1a64Prime = 1099511628211ull;
+
+	constexpr uint32_t HashFnv1a32(std::string_view data, uint32_t hash = Fnv1a32Offset)
+	{
+		for(char c : data)
+		{
+			hash ^= (uint8_t)c;
+			hash *= Fnv1a32Prime;
+		}
+		return hash;
+	}
+
+	constexpr uint64_t HashFnv1a64(std::string_view data, uint64_t hash = Fnv1a64Offset)
+	{
+		for(char c : data)
+		{
+			hash ^= (uint8_t)c;
+			hash *= Fnv1a64Prime;
+		}
+		return hash;
+	}
+
+	// Folds a 64 bit value into seed byte by byte, for combining hashes computed separately
+	constexpr uint64_t HashCombine64(uint64_t seed, uint64_t value)
+	{
+		for(int i = 0; i < 8; i++)
+		{
+			seed ^= (uint8_t)(value >> (i * 8));
+			seed *= Fnv1a64Prime;
+		}
+		return seed;
+	}
+}
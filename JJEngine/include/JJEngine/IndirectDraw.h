@@ -0,0 +1,143 @@
+#pragma once
+
+#include <atomic>
+#include <vector>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <glad/glad.h>
+
+#include "Mesh.h"
+#include "Shader.h"
+
+namespace JJEngine {
+	// Layout of glMultiDrawElementsIndirect commands
+	struct DrawElementsIndirectCommand {
+		uint32_t count;
+		uint32_t instanceCount;
+		uint32_t firstIndex;
+		int32_t baseVertex;
+		uint32_t baseInstance;
+	};
+
+	// One vertex and one index buffer shared by many meshes of the same layout,
+	// so a whole scene can be drawn without switching vertex arrays.
+	class GeometryPool {
+	public:
+		// Instanced attribute that reads back each draw's baseInstance, the object index, for drivers
+		// without GL_ARB_shader_draw_parameters: layout (location = 15) in uint aObjectIndex;
+		static constexpr uint32_t ObjectIndexLocation = 15;
+
+		struct MeshRange {
+			uint32_t firstIndex = 0;
+			uint32_t indexCount = 0;
+			int32_t baseVertex = 0;
+			uint32_t vertexCount = 0;
+		};
+
+		GeometryPool(const VertexLayout& layout, uint32_t maxVertices, uint32_t maxIndices);
+		~GeometryPool();
+
+		GeometryPool(const GeometryPool&) = delete;
+		GeometryPool& operator=(const GeometryPool&) = delete;
+
+		// Returns an empty range and warns once the pool is full
+		MeshRange Add(const void* vertices, uint32_t vertexCount, const uint32_t* indices, uint32_t indexCount);
+
+		// Context thread, grows the object index attribute to cover objectCount objects
+		void ReserveObjects(uint32_t objectCount);
+
+		GLuint GetVertexArray() const { return m_vertexArray; }
+		uint32_t GetVertexCount() const { return m_vertexCount; }
+		uint32_t GetIndexCount() const { return m_indexCount; }
+
+	private:
+		GLuint m_vertexArray = 0;
+		GLuint m_vertexBuffer = 0;
+		GLuint m_indexBuffer = 0;
+		GLuint m_objectIndexBuffer = 0;
+		uint32_t m_objectCapacity = 0;
+
+		uint32_t m_stride;
+		uint32_t m_maxVertices, m_maxIndices;
+		uint32_t m_vertexCount = 0, m_indexCount = 0;
+	};
+
+	// Draw commands plus per-object data for meshes of one GeometryPool, all drawn by a single
+	// glMultiDrawElementsIndirect. Object data lives in a std430 storage block indexed by gl_DrawID;
+	// baseInstance carries the same index for shaders that use gl_BaseInstance instead, which is
+	// the one that stays correct when GpuCuller compacts the command list. Without shader draw
+	// parameters neither exists, shaders then read the index from GeometryPool::ObjectIndexLocation:
+	//
+	//   #extension GL_ARB_shader_draw_parameters : enable
+	//   #ifdef GL_ARB_shader_draw_parameters
+	//       uint objectIndex = gl_BaseInstanceARB;
+	//   #else
+	//       uint objectIndex = aObjectIndex;
+	//   #endif
+	class IndirectDrawList {
+	public:
+		// Whether shaders get gl_DrawID and gl_BaseInstance, core in 4.6
+		static bool IsDrawParametersSupported();
+
+		struct Statistics {
+			uint32_t objects = 0;
+			double submitTime = 0.0; // CPU time of the last Draw on the context thread, ms
+		};
+
+		// objectDataSize is the std430 size of one element of the block's runtime array
+		IndirectDrawList(GeometryPool& pool, size_t objectDataSize, std::string_view blockName = "Objects");
+		~IndirectDrawList();
+
+		IndirectDrawList(const IndirectDrawList&) = delete;
+		IndirectDrawList& operator=(const IndirectDrawList&) = delete;
+
+		// Returns the object index, which is also its gl_DrawID
+		uint32_t Add(const GeometryPool::MeshRange& mesh, const void* objectData, uint32_t instanceCount = 1);
+
+		template<typename T>
+		uint32_t Add(const GeometryPool::MeshRange& mesh, const T& objectData, uint32_t instanceCount = 1)
+		{
+			return Add(mesh, (const void*)&objectData, instanceCount);
+		}
+
+		void SetObjectData(uint32_t index, const void* objectData);
+		void Clear();
+
+		// Sends changed commands and object data to the GPU, static scenes pay this once
+		void Upload();
+
+		// One API call for every object, the pool and shader must outlive the frame
+		void Draw(Shader& shader);
+
+		uint32_t GetObjectCount() const { return (uint32_t)m_commands.size(); }
+		Statistics GetStats() const;
+
+		// GPU side, only valid in commands on the context thread
+		GeometryPool& GetPool() const { return m_pool; }
+		GLuint GetCommandBuffer() const { return m_commandBuffer; }
+		GLuint GetObjectBuffer() const { return m_objectBuffer; }
+		GLuint GetBindingPoint() const { return m_bindingPoint; }
+		uint32_t GetUploadedCount() const { return m_uploadedCount; }
+
+	private:
+		void Reserve(uint32_t objectCount);
+		void UploadBuffers(const DrawElementsIndirectCommand* commands, const uint8_t* objectData, uint32_t count);
+
+		GeometryPool& m_pool;
+		size_t m_objectDataSize;
+		GLuint m_bindingPoint;
+
+		std::vector<DrawElementsIndirectCommand> m_commands;
+		std::vector<uint8_t> m_objectData;
+		bool m_dirty = false;
+
+		// GPU side, only touched by commands on the context thread
+		GLuint m_commandBuffer = 0;
+		GLuint m_objectBuffer = 0;
+		uint32_t m_capacity = 0;
+		uint32_t m_uploadedCount = 0;
+
+		std::atomic<double> m_submitTime = 0.0;
+	};
+}
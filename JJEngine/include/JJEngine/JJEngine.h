@@ -5,6 +5,32 @@
 #include <glm/glm.hpp>
 
 #include "Application.h"
+#include "FrameStats.h"
+#include "JobSystem.h"
+#include "Allocators.h"
+#include "MappedFile.h"
+#include "AssetManager.h"
+#include "PackFile.h"
+#include "Profiler.h"
+#include "GpuProfiler.h"
 #include "Window.h"
+#include "GLState.h"
 
-#include "Shader.h"
\ No newline at end of file
+#include "Shader.h"
+#include "Hash.h"
+#include "ShaderCache.h"
+#include "ShaderPreprocessor.h"
+#include "ShaderReloader.h"
+#include "ShaderLibrary.h"
+#include "FileWatcher.h"
+#include "StreamBuffer.h"
+#include "Texture.h"
+#include "UniformBuffer.h"
+#include "Renderer2D.h"
+#include "CommandBucket.h"
+#include "Mesh.h"
+#include "IndirectDraw.h"
+#include "Frustum.h"
+#include "GpuCulling.h"
+#include "CpuCulling.h"
+#include "RenderThread.h"
\ No newline at end of file
@@ -0,0 +1,146 @@
+#pragma once
+
+#include <new>
+#include <array>
+#include <mutex>
+#include <memory>
+#include <deque>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <utility>
+#include <algorithm>
+#include <type_traits>
+#include <condition_variable>
+
+namespace JJEngine {
+	class JobSystem;
+
+	struct Job {
+		static constexpr size_t StorageSize = 48;
+
+		void (*invoke)(Job&) = nullptr;
+		void (*destroy)(Job&) = nullptr;
+		class JobCounter* counter = nullptr;
+		std::atomic<bool> finished = true;
+		alignas(std::max_align_t) unsigned char storage[StorageSize];
+	};
+
+	// Counts unfinished jobs. Jobs can depend on a counter and are only scheduled once it reaches zero.
+	class JobCounter {
+	public:
+		JobCounter() = default;
+		JobCounter(const JobCounter&) = delete;
+		JobCounter& operator=(const JobCounter&) = delete;
+
+		bool IsDone() const { return m_value.load(std::memory_order_acquire) == 0; }
+
+	private:
+		friend class JobSystem;
+
+		std::atomic<int32_t> m_value = 0;
+		std::mutex m_mutex;
+		std::vector<Job*> m_continuations;
+	};
+
+	// Chase-Lev deque. The owning worker pushes and pops at the bottom, other threads steal from the top.
+	class WorkStealingQueue {
+	public:
+		static constexpr int64_t Capacity = 4096;
+
+		bool Push(Job* job);
+		Job* Pop();
+		Job* Steal();
+
+	private:
+		alignas(64) std::atomic<int64_t> m_top = 0;
+		alignas(64) std::atomic<int64_t> m_bottom = 0;
+		std::array<std::atomic<Job*>, Capacity> m_jobs{};
+	};
+
+	class JobSystem {
+	public:
+		// The constructing thread becomes worker 0 and runs jobs while it waits.
+		// A worker count of 0 creates one worker per hardware thread.
+		JobSystem(uint32_t workerCount = 0);
+		~JobSystem();
+
+		JobSystem(const JobSystem&) = delete;
+		JobSystem& operator=(const JobSystem&) = delete;
+
+		// Schedules function. If counter is set it is incremented now and decremented when the job completes,
+		// if dependency is set the job only becomes runnable once the dependency counter reaches zero.
+		template<typename F>
+		void Run(F&& function, JobCounter* counter = nullptr, JobCounter* dependency = nullptr)
+		{
+			using Function = std::decay_t<F>;
+			static_assert(sizeof(Function) <= Job::StorageSize, "Job captures too large, capture by reference or pointer instead");
+			static_assert(alignof(Function) <= alignof(std::max_align_t));
+
+			Job* job = AllocateJob();
+			new (job->storage) Function(std::forward<F>(function));
+			job->invoke = [](Job& job) { (*std::launder((Function*)job.storage))(); };
+			job->destroy = [](Job& job) { std::launder((Function*)job.storage)->~Function(); };
+			job->counter = counter;
+
+			if(counter != nullptr)
+				counter->m_value.fetch_add(1, std::memory_order_relaxed);
+
+			Schedule(job, dependency);
+		}
+
+		// Splits [0, count) into batches and calls function(begin, end) for each across all workers.
+		// Blocks until every batch has finished. A batch size of 0 picks one based on the worker count.
+		template<typename F>
+		void ParallelFor(uint32_t count, uint32_t batchSize, F&& function)
+		{
+			if(count == 0)
+				return;
+
+			if(batchSize == 0)
+				batchSize = std::max<uint32_t>(1, count / (GetWorkerCount() * 4));
+
+			JobCounter counter;
+			for(uint32_t begin = 0; begin < count; begin += batchSize)
+			{
+				uint32_t end = std::min(begin + batchSize, count);
+				Run([&function, begin, end]() { function(begin, end); }, &counter);
+			}
+			Wait(counter);
+		}
+
+		// Runs other jobs until counter reaches zero
+		void Wait(JobCounter& counter);
+
+		uint32_t GetWorkerCount() const { return (uint32_t)m_queues.size(); }
+
+		// Index of the calling thread, or -1 if it isn't one of this system's workers
+		static int32_t GetWorkerIndex();
+
+	private:
+		static constexpr size_t MaxJobsPerThread = 4096;
+
+		Job* AllocateJob();
+		void Schedule(Job* job, JobCounter* dependency);
+		void Push(Job* job);
+		Job* FindJob();
+		void Execute(Job* job);
+		void WorkerLoop(uint32_t index);
+
+		std::vector<std::unique_ptr<WorkStealingQueue>> m_queues;
+		std::vector<std::thread> m_threads;
+
+		// Jobs scheduled from threads that aren't workers
+		std::mutex m_injectionMutex;
+		std::deque<Job*> m_injectionQueue;
+
+		std::atomic<int32_t> m_queuedJobs = 0;
+		std::atomic<int32_t> m_sleepingWorkers = 0;
+		std::mutex m_sleepMutex;
+		std::condition_variable m_wakeCondition;
+
+		std::atomic<bool> m_stopping = false;
+	};
+}
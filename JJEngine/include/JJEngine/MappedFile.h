@@ -0,0 +1,60 @@
+#pragma once
+
+#include <span>
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <string_view>
+
+namespace JJEngine {
+	// Read-only view of a whole file. Regular files are memory mapped, so parsing reads straight
+	// from the page cache without a copy or an allocation. Files that can't be mapped (pipes,
+	// special files, platforms without mapping) are streamed into a buffer instead, the view
+	// looks the same either way.
+	//
+	// A mapped file truncated by another process faults when the removed pages are touched.
+	// Editors that save by renaming are safe, files rewritten in place should be closed first.
+	class MappedFile {
+	public:
+		enum class AccessPattern {
+			Normal,
+			Sequential, // Read front to back once, read ahead aggressively and drop pages behind
+			Random      // Small scattered reads, read ahead would only waste memory
+		};
+
+		MappedFile() = default;
+		// Check IsOpen afterwards, a missing file is not an error for most callers
+		explicit MappedFile(const std::string& path, AccessPattern pattern = AccessPattern::Sequential);
+		~MappedFile();
+
+		MappedFile(MappedFile&& other) noexcept;
+		MappedFile& operator=(MappedFile&& other) noexcept;
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+
+		bool Open(const std::string& path, AccessPattern pattern = AccessPattern::Sequential);
+		void Close();
+
+		// Asks the OS to start reading a range in the background, e.g. the next chunk of a stream.
+		// No-op for streamed files, they are in memory already.
+		void Prefetch(size_t offset, size_t size) const;
+
+		bool IsOpen() const { return m_open; }
+		bool IsMapped() const { return m_mapped; }
+
+		std::span<const std::byte> GetData() const { return { m_data, m_size }; }
+		std::string_view GetText() const { return { (const char*)m_data, m_size }; }
+		size_t GetSize() const { return m_size; }
+
+	private:
+		bool Map(const std::string& path, AccessPattern pattern);
+		bool Stream(const std::string& path);
+
+		const std::byte* m_data = nullptr;
+		size_t m_size = 0;
+		bool m_open = false;
+		bool m_mapped = false;
+
+		std::vector<std::byte> m_buffer; // Streaming fallback
+	};
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <initializer_list>
+#include <glad/glad.h>
+
+#include "Shader.h"
+#include "StreamBuffer.h"
+
+namespace JJEngine {
+	enum class VertexAttribute {
+		Float, Float2, Float3, Float4,
+		Int, UInt,
+		UByte4Norm, // Packed RGBA8 color, read as vec4 in [0, 1]
+		Mat4        // Takes four consecutive locations
+	};
+
+	// Attributes are tightly packed in declaration order, the vertex struct must match with no padding
+	class VertexLayout {
+	public:
+		struct Element {
+			VertexAttribute type;
+			uint32_t offset;
+		};
+
+		VertexLayout(std::initializer_list<VertexAttribute> attributes);
+
+		// Sets up the attribute formats on a vertex array, starting at firstLocation and sourcing from binding
+		void Apply(GLuint vertexArray, uint32_t firstLocation, GLuint binding) const;
+
+		const std::vector<Element>& GetElements() const { return m_elements; }
+		uint32_t GetStride() const { return m_stride; }
+		uint32_t GetLocationCount() const { return m_locationCount; }
+
+	private:
+		std::vector<Element> m_elements;
+		uint32_t m_stride = 0;
+		uint32_t m_locationCount = 0;
+	};
+
+	// Static vertex and optional 32-bit index data in GPU memory, plus an optional per-instance
+	// attribute stream. Instance data is written into a persistently mapped ring each draw and
+	// addressed with baseInstance, so N copies cost one draw call and no vertex array changes.
+	class Mesh {
+	public:
+		// Fences the instance streams written this frame, on the context thread once per frame
+		static void EndFrame();
+
+		Mesh(const VertexLayout& layout, const void* vertices, uint32_t vertexCount, const uint32_t* indices = nullptr, uint32_t indexCount = 0);
+		~Mesh();
+
+		Mesh(const Mesh&) = delete;
+		Mesh& operator=(const Mesh&) = delete;
+
+		// Instance attributes take the locations after the vertex attributes and advance once per instance.
+		// Each ring region holds several draws of maxInstancesPerDraw instances, larger draws are split.
+		void SetInstanceLayout(const VertexLayout& layout, uint32_t maxInstancesPerDraw);
+
+		// Recorded through RenderThread, the mesh and shader must outlive the frame
+		void Draw(Shader& shader);
+
+		// Instance data is copied, the caller may reuse it as soon as this returns
+		void DrawInstanced(Shader& shader, const void* instances, uint32_t instanceCount);
+
+		GLuint GetVertexArray() const { return m_vertexArray; }
+		uint32_t GetVertexCount() const { return m_vertexCount; }
+		uint32_t GetIndexCount() const { return m_indexCount; }
+
+		// Null until an instance layout is set
+		StreamBuffer* GetInstanceStream() const { return m_instanceStream.get(); }
+
+	private:
+		void IssueDraw(uint32_t instanceCount, uint32_t baseInstance) const;
+
+		GLuint m_vertexArray = 0;
+		GLuint m_vertexBuffer = 0;
+		GLuint m_indexBuffer = 0;
+		uint32_t m_vertexCount;
+		uint32_t m_indexCount;
+		uint32_t m_vertexLocationCount;
+
+		std::unique_ptr<StreamBuffer> m_instanceStream;
+		uint32_t m_instanceStride = 0;
+		uint32_t m_maxInstancesPerDraw = 0;
+		bool m_streamed = false; // Since the last EndFrame
+	};
+}
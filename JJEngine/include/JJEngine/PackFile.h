@@ -0,0 +1,101 @@
+#pragma once
+
+#include <span>
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+#include "Hash.h"
+#include "MappedFile.h"
+
+namespace JJEngine {
+	// On-disk layout of a pack, shared with the JJPack tool. Entry data comes first, each entry
+	// starting at a multiple of the pack's alignment, sorted by path so files from one directory are
+	// adjacent on disk. The table of contents and the path strings follow the data.
+	// Little endian, offsets are from the start of the file.
+	namespace PackFormat {
+		constexpr uint32_t Magic = 0x4b504a4a; // "JJPK"
+		constexpr uint32_t Version = 1;
+
+		enum class Compression : uint32_t { None, LZ4, Zstd };
+
+		struct Header {
+			uint32_t magic;
+			uint32_t version;
+			uint32_t entryCount;
+			uint32_t alignment;
+			uint64_t tocOffset;
+			uint64_t namesOffset;
+			uint64_t namesSize;
+		};
+
+		// Sorted by pathHash, lookups are a binary search
+		struct Entry {
+			uint64_t pathHash;
+			uint64_t offset;
+			uint64_t size;         // As stored
+			uint64_t originalSize; // After decompression
+			uint32_t nameOffset;   // Into the path strings, for listing and telling colliding hashes apart
+			uint32_t nameLength;
+			Compression compression;
+			uint32_t reserved;
+		};
+
+		// Paths are relative to the packed directory and use '/'
+		constexpr uint64_t HashPath(std::string_view path) { return HashFnv1a64(path); }
+
+		// Whether this build can read or write entries compressed with compression
+		constexpr bool IsSupported(Compression compression)
+		{
+			switch(compression)
+			{
+			case Compression::None: return true;
+#if defined(JJ_PACK_LZ4)
+			case Compression::LZ4: return true;
+#endif
+#if defined(JJ_PACK_ZSTD)
+			case Compression::Zstd: return true;
+#endif
+			default: return false;
+			}
+		}
+	}
+
+	// Read-only access to a pack. The file is memory mapped, uncompressed entries are used in place
+	// and finding one costs no system call at all, instead of an open per loose file.
+	class PackFile {
+	public:
+		using Entry = PackFormat::Entry;
+
+		PackFile() = default;
+		PackFile(const PackFile&) = delete;
+		PackFile& operator=(const PackFile&) = delete;
+
+		// Returns false and prints why if the file is missing or not a valid pack
+		bool Open(const std::string& path);
+		void Close();
+		bool IsOpen() const { return m_file.IsOpen(); }
+
+		// Null if the pack has no such file
+		const Entry* Find(std::string_view path) const;
+
+		// Entry data as stored, compressed entries are still compressed
+		std::span<const std::byte> GetStoredData(const Entry& entry) const;
+
+		// Copies or decompresses the entry into data
+		bool Read(const Entry& entry, std::vector<std::byte>& data) const;
+
+		// Starts reading the entry from disk in the background
+		void Prefetch(const Entry& entry) const;
+
+		std::span<const Entry> GetEntries() const { return m_entries; }
+		std::string_view GetPath(const Entry& entry) const { return m_names.substr(entry.nameOffset, entry.nameLength); }
+
+	private:
+		MappedFile m_file;
+		std::span<const Entry> m_entries;
+		std::string_view m_names;
+	};
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <string>
+#include <cstdint>
+
+namespace JJEngine {
+	// CPU profiler writing chrome://tracing / Perfetto compatible JSON.
+	// Each thread records complete events into its own ring buffer, so recording never takes a lock.
+	class Profiler {
+	public:
+		static void BeginSession(const std::string& filePath);
+		// Safe while other threads are still recording, events that race with it are dropped
+		static void EndSession();
+		static bool IsSessionActive();
+
+		// Shown as the track name in the trace
+		static void SetThreadName(const std::string& name);
+
+		// name must outlive the session, scopes pass string literals
+		static void RecordEvent(const char* name, int64_t startNanoseconds, int64_t endNanoseconds);
+
+		static int64_t GetTime();
+	};
+
+	class ProfileScope {
+	public:
+		ProfileScope(const char* name) : m_name(name), m_start(Profiler::IsSessionActive() ? Profiler::GetTime() : -1) {}
+
+		~ProfileScope()
+		{
+			if(m_start >= 0)
+				Profiler::RecordEvent(m_name, m_start, Profiler::GetTime());
+		}
+
+		ProfileScope(const ProfileScope&) = delete;
+		ProfileScope& operator=(const ProfileScope&) = delete;
+
+	private:
+		const char* m_name;
+		int64_t m_start;
+	};
+}
+
+// JJ_PROFILE is defined for non-release builds, see JJEngine/CMakeLists.txt
+#ifdef JJ_PROFILE
+	#if defined(_MSC_VER)
+		#define JJ_PROFILE_FUNCTION_NAME __FUNCSIG__
+	#else
+		#define JJ_PROFILE_FUNCTION_NAME __PRETTY_FUNCTION__
+	#endif
+
+	#define JJ_PROFILE_CONCAT_INNER(a, b) a##b
+	#define JJ_PROFILE_CONCAT(a, b) JJ_PROFILE_CONCAT_INNER(a, b)
+
+	#define JJ_PROFILE_SCOPE(name) ::JJEngine::ProfileScope JJ_PROFILE_CONCAT(profileScope, __LINE__)(name)
+	#define JJ_PROFILE_FUNCTION() JJ_PROFILE_SCOPE(JJ_PROFILE_FUNCTION_NAME)
+#else
+	#define JJ_PROFILE_SCOPE(name)
+	#define JJ_PROFILE_FUNCTION()
+#endif
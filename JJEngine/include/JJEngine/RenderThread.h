@@ -0,0 +1,115 @@
+#pragma once
+
+#include <new>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <utility>
+#include <type_traits>
+
+#include "Allocators.h"
+
+class GLFWwindow;
+
+namespace JJEngine {
+	// Commands recorded during one frame. Captures and payloads live in the list's arena, which grows
+	// on Reset after a frame overflowed it, so recording allocates nothing once it holds a frame's worth.
+	class RenderCommandList {
+	public:
+		RenderCommandList(size_t capacity);
+		~RenderCommandList();
+
+		RenderCommandList(const RenderCommandList&) = delete;
+		RenderCommandList& operator=(const RenderCommandList&) = delete;
+
+		template<typename F>
+		void Record(F&& function)
+		{
+			using Function = std::decay_t<F>;
+
+			void* payload = m_allocator.Allocate(sizeof(Function), alignof(Function));
+			new (payload) Function(std::forward<F>(function));
+			m_commands.push_back({
+				[](void* payload) { (*std::launder((Function*)payload))(); },
+				[](void* payload) { std::launder((Function*)payload)->~Function(); },
+				payload
+			});
+		}
+
+		void* Allocate(size_t size, size_t alignment = alignof(std::max_align_t)) { return m_allocator.Allocate(size, alignment); }
+
+		// Runs every command in recording order and destroys it
+		void Execute();
+
+		// Destroys commands that never ran and releases the arena
+		void Reset();
+
+		size_t GetCommandCount() const { return m_commands.size(); }
+		size_t GetCapacity() const { return m_allocator.GetCapacity(); }
+		AllocationStats GetAllocationStats() const { return m_allocator.GetStats(); }
+
+	private:
+		struct Command {
+			void (*execute)(void*);
+			void (*destroy)(void*);
+			void* payload;
+		};
+
+		LinearAllocator m_allocator;
+		std::vector<Command> m_commands;
+	};
+
+	// Owns the GL context while running. The main thread records GL work with Submit and hands
+	// the list over at EndFrame, so simulating frame N+1 overlaps the render thread submitting frame N.
+	// When not running, or when called from the render thread itself, Submit executes immediately.
+	class RenderThread {
+	public:
+		static constexpr uint32_t MaxFramesInFlight = 2;
+
+		struct Statistics {
+			uint32_t commands = 0;
+			size_t commandBytes = 0;     // Arena memory the frame's commands used
+			size_t overflowBytes = 0;    // Part of it that did not fit the arena, the arena grows to cover it
+			size_t arenaCapacity = 0;
+			double submitWaitTime = 0.0; // Main thread blocked on the render thread in EndFrame, ms
+			double executeTime = 0.0;    // Render thread executing the frame's commands, ms
+		};
+
+		static void Init(GLFWwindow* window);
+		static void Shutdown();
+
+		// Moves the context to a new render thread. framesInFlight is how many frames the main thread
+		// may run ahead: 1 keeps latency low, 2 absorbs spikes on either side. 0 keeps rendering on the calling thread.
+		static void Start(uint32_t framesInFlight);
+
+		// Executes everything recorded so far, joins the thread and makes the context current here again
+		static void Stop();
+
+		static bool IsRunning();
+		static bool IsRenderThread();
+
+		// Recording is only allowed from the main thread
+		template<typename F>
+		static void Submit(F&& function)
+		{
+			if(RenderCommandList* list = GetRecordingList())
+				list->Record(std::forward<F>(function));
+			else
+				function();
+		}
+
+		// Memory for command payloads, valid until the commands recorded this frame have executed
+		static void* Allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+
+		// Hands the recorded frame to the render thread, blocking while it is framesInFlight frames behind
+		static void EndFrame();
+
+		static uint32_t GetFramesInFlight();
+
+		// Counters of the last frame the render thread completed
+		static Statistics GetStats();
+
+	private:
+		static RenderCommandList* GetRecordingList();
+	};
+}
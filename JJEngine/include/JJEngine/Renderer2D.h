@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdint>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "StreamBuffer.h"
+
+namespace JJEngine {
+	class Texture;
+
+	// Batched quad renderer. Quads are accumulated into a CPU-side vertex buffer
+	// and flushed with one indexed draw per batch. A batch ends when it is full,
+	// when it runs out of texture slots, or at EndScene. Batches are built on the calling thread
+	// and their GL work is submitted through RenderThread.
+	// With ARB_bindless_texture, batches whose textures are all Texture objects sample resident
+	// handles instead of binding texture units. Raw texture names are always bound.
+	class Renderer2D {
+	public:
+		struct Statistics {
+			uint32_t drawCalls = 0;
+			uint32_t bindlessDrawCalls = 0; // Of drawCalls, the ones sampling through bindless handles
+			uint32_t quadCount = 0;
+		};
+
+		static constexpr uint32_t MaxQuadsPerBatch = 16384;
+		static constexpr uint32_t MaxTextureSlots = 16;
+
+		static void Init();
+		static void Shutdown();
+
+		static void BeginScene(const glm::mat4& viewProjection);
+		static void EndScene();
+		static void Flush();
+
+		static void DrawQuad(const glm::vec2& position, const glm::vec2& size, const glm::vec4& color);
+		static void DrawQuad(const glm::vec3& position, const glm::vec2& size, const glm::vec4& color);
+		static void DrawQuad(const glm::vec3& position, const glm::vec2& size, GLuint textureID, const glm::vec4& tint = glm::vec4(1.0f));
+		// The texture must outlive the frame, TextureAsset releases its texture through RenderThread for this
+		static void DrawQuad(const glm::vec3& position, const glm::vec2& size, Texture& texture, const glm::vec4& tint = glm::vec4(1.0f));
+		static void DrawQuad(const glm::mat4& transform, const glm::vec4& color, GLuint textureID = 0);
+
+		// Counters accumulate until ResetStats, call it once per frame
+		static const Statistics& GetStats();
+		static void ResetStats();
+
+		// Vertex upload statistics of the last completed scene, a copy published by whichever thread owns the context
+		static StreamBuffer::Statistics GetStreamStats();
+	};
+}
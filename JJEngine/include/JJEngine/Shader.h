@@ -1,43 +1,124 @@
 #pragma once
 
-#include <unordered_map>
+#include <string>
+#include <vector>
+#include <string_view>
 #include <glad/glad.h>
 #include <glm/glm.hpp>
 
+#include "Hash.h"
+
 namespace JJEngine {
+	// Uniform name with a precomputed hash. String literals convert implicitly and are hashed at compile time.
+	// The hash is 64 bits so a name missing from a program practically never matches an active uniform.
+	class UniformName {
+	public:
+		template<size_t N>
+		consteval UniformName(const char (&name)[N]) : m_name(name, N - 1), m_hash(HashFnv1a64(std::string_view(name, N - 1))) {}
+		explicit constexpr UniformName(std::string_view name) : m_name(name), m_hash(HashFnv1a64(name)) {}
+
+		constexpr std::string_view GetName() const { return m_name; }
+		constexpr uint64_t GetHash() const { return m_hash; }
+
+	private:
+		std::string_view m_name;
+		uint64_t m_hash;
+	};
+
 	class Shader {
 	public:
-		Shader(const char* vertexPath, const char* fragmentPath);
+		Shader();
+		// defines is a block of #define lines inserted after #version in every stage
+		Shader(const char* vertexPath, const char* fragmentPath, std::string defines = {});
 		~Shader();
 
-		GLint GetUniformLocation(const char* name);
+		// Hot reload and command lists refer to shaders by address
+		Shader(const Shader&) = delete;
+		Shader& operator=(const Shader&) = delete;
+
+		// Returns -1 for uniforms that are not active in the program
+		GLint GetUniformLocation(UniformName name) const
+		{
+			// Linear probing, the table is at most half full so every miss soon reaches an empty slot
+			for(uint64_t index = name.GetHash() & m_uniformTableMask;; index = (index + 1) & m_uniformTableMask)
+			{
+				const UniformSlot& slot = m_uniformTable[index];
+				if(slot.location == -1)
+					return -1;
+				if(slot.hash != name.GetHash())
+					continue;
+#ifndef NDEBUG
+				// Debug builds also compare the reflected name, a collision would write the wrong uniform
+				if(slot.name != name.GetName())
+					continue;
+#endif
+				return slot.location;
+			}
+		}
 
 		void Use() const;
+		// Loading from files resolves #include through ShaderPreprocessor and registers the shader
+		// with ShaderReloader, so edits to the files or anything they include are picked up while running
 		void Load();
 		void Load(const char* vertexPath, const char* fragmentPath);
+		void LoadFromSource(const char* vertexSource, const char* fragmentSource);
+		void LoadComputeFromSource(const char* computeSource);
 
-		void SetUniform1i(const char* name, int value);
-		void SetUniform2i(const char* name, int x, int y);
-		void SetUniform3i(const char* name, int x, int y, int z);
-		void SetUniform4i(const char* name, int x, int y, int z, int w);
+		void SetUniform1i(UniformName name, int value);
+		void SetUniform2i(UniformName name, int x, int y);
+		void SetUniform3i(UniformName name, int x, int y, int z);
+		void SetUniform4i(UniformName name, int x, int y, int z, int w);
 
-		void SetUniform1f(const char* name, float value);
-		void SetUniform2f(const char* name, float x, float y);
-		void SetUniform3f(const char* name, float x, float y, float z);
-		void SetUniform4f(const char* name, float x, float y, float z, float w);
+		void SetUniform1f(UniformName name, float value);
+		void SetUniform2f(UniformName name, float x, float y);
+		void SetUniform3f(UniformName name, float x, float y, float z);
+		void SetUniform4f(UniformName name, float x, float y, float z, float w);
 
-		void SetUniformVec2(const char* name, const glm::vec2& value);
-		void SetUniformVec3(const char* name, const glm::vec3& value);
-		void SetUniformVec4(const char* name, const glm::vec4& value);
+		void SetUniformVec2(UniformName name, const glm::vec2& value);
+		void SetUniformVec3(UniformName name, const glm::vec3& value);
+		void SetUniformVec4(UniformName name, const glm::vec4& value);
 
-		const char* GetVertexPath() const { return m_vertexPath; }
-		const char* GetFragmentPath() const { return m_fragmentPath; }
+		void SetUniformMat4(UniformName name, const glm::mat4& value);
+
+		// Takes ownership of a program linked elsewhere and replaces the current one.
+		// Context thread only, typically from a render command so the swap lands between draws.
+		void AdoptProgram(GLuint program);
+
+		GLuint GetRendererID() const { return m_rendererID; }
+
+		const std::string& GetVertexPath() const { return m_vertexPath; }
+		const std::string& GetFragmentPath() const { return m_fragmentPath; }
+		const std::string& GetDefines() const { return m_defines; }
+
+		// Inserts defines after the #version line, followed by a #line directive so errors keep their line numbers
+		static std::string InjectDefines(std::string_view source, std::string_view defines);
 
 	private:
-		const char* m_vertexPath;
-		const char* m_fragmentPath;
+		struct UniformSlot {
+			uint64_t hash = 0;
+			GLint location = -1;
+			std::string name;
+		};
+
+		struct ShaderStage {
+			const char* source;
+			GLenum type;
+		};
+
+		// sourceHash stands in for the sources in the cache key
+		void LoadVertexFragment(std::string vertexSource, std::string fragmentSource, uint64_t sourceHash);
+		void LoadStages(const ShaderStage* stages, uint32_t stageCount, uint64_t cacheKey);
+		void ReflectUniforms();
+		void ReflectBlocks();
+
+		std::string m_vertexPath;
+		std::string m_fragmentPath;
+		std::string m_defines;
+
+		GLuint m_rendererID = 0;
 
-		GLuint m_rendererID;
-		std::unordered_map<const char*, GLint> m_uniformLocationCache;
+		// Open addressing sized at link time to at least twice the active uniforms, empty slots have location -1
+		std::vector<UniformSlot> m_uniformTable = std::vector<UniformSlot>(1);
+		uint64_t m_uniformTableMask = 0;
 	};
 }
\ No newline at end of file
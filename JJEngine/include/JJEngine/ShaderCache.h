@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <initializer_list>
+#include <glad/glad.h>
+
+namespace JJEngine {
+	// On-disk cache of linked program binaries.
+	// Keys cover the stage sources, the defines and the driver vendor/renderer/version,
+	// so editing a shader or updating the driver invalidates entries automatically.
+	class ShaderCache {
+	public:
+		static void SetEnabled(bool enabled) { s_enabled = enabled; }
+		static bool IsEnabled() { return s_enabled; }
+
+		static void SetDirectory(const std::string& directory) { s_directory = directory; }
+		static const std::string& GetDirectory() { return s_directory; }
+
+		// Requires a current GL context, the driver strings are part of the key
+		static uint64_t ComputeKey(std::initializer_list<std::string_view> sources, std::string_view defines = {});
+		// For sources that were hashed already, like preprocessed files
+		static uint64_t ComputeKey(uint64_t sourceHash, std::string_view defines = {});
+
+		// Loads a cached binary into program. Returns false on a miss or if the driver rejects
+		// the binary, in which case the entry is removed and the program must be compiled from source.
+		static bool Load(uint64_t key, GLuint program);
+		static void Store(uint64_t key, GLuint program);
+
+	private:
+		static bool s_enabled;
+		static std::string s_directory;
+	};
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <string_view>
+#include <unordered_map>
+#include <initializer_list>
+
+#include "Shader.h"
+
+namespace JJEngine {
+	// Variants of one vertex/fragment pair, selected by keywords that become #defines.
+	// Each combination is a separate program, so features cost nothing on the GPU when they
+	// are off, and a variant is only compiled the first time it is asked for.
+	class ShaderLibrary {
+	public:
+		// Bit i of a variant key enables keyword i
+		using VariantKey = uint64_t;
+		static constexpr size_t MaxKeywords = 64;
+
+		ShaderLibrary(const char* vertexPath, const char* fragmentPath, std::initializer_list<std::string_view> keywords);
+
+		ShaderLibrary(const ShaderLibrary&) = delete;
+		ShaderLibrary& operator=(const ShaderLibrary&) = delete;
+
+		// Unknown keywords are reported and ignored
+		VariantKey GetKey(std::initializer_list<std::string_view> keywords) const;
+		VariantKey GetKeywordBit(std::string_view keyword) const;
+
+		// Compiles the variant on first use. The returned shader stays valid for the library's lifetime.
+		Shader& Get(VariantKey key);
+		Shader& Get(std::initializer_list<std::string_view> keywords) { return Get(GetKey(keywords)); }
+
+		// Compiles variants up front, e.g. during loading, so their first use doesn't stall a frame
+		void Prewarm(std::initializer_list<VariantKey> keys);
+		void Prewarm(const std::vector<VariantKey>& keys);
+
+		bool HasVariant(VariantKey key) const { return m_variants.contains(key); }
+		uint32_t GetVariantCount() const { return (uint32_t)m_variants.size(); }
+		const std::vector<std::string>& GetKeywords() const { return m_keywords; }
+
+		// The #define block for a key, in keyword declaration order
+		std::string GetDefines(VariantKey key) const;
+
+	private:
+		std::string m_vertexPath, m_fragmentPath;
+		std::vector<std::string> m_keywords;
+		std::unordered_map<VariantKey, std::unique_ptr<Shader>> m_variants;
+	};
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+namespace JJEngine {
+	struct PreprocessedSource {
+		std::string source;
+
+		// Every file that went into source, the root first. A file's position is its GLSL
+		// source string number, so compiler messages read "<index>(<line>)".
+		std::vector<std::string> dependencies;
+
+		// Combined content hash of the dependencies, computed from hashes cached per file
+		uint64_t hash = 0;
+
+		// False if the root or an include couldn't be read, source is then incomplete
+		bool succeeded = false;
+	};
+
+	// Resolves #include "file" in GLSL. Paths are relative to the including file first, then to
+	// the include directories. Each file is included once per program, so chunks need no guards.
+	// Files are read and hashed once per process and kept in memory until invalidated,
+	// so shared chunks cost nothing for every program after the first. Thread safe.
+	class ShaderPreprocessor {
+	public:
+		struct Statistics {
+			uint32_t filesRead = 0;
+			uint32_t cacheHits = 0;
+			uint32_t cachedFiles = 0;
+		};
+
+		static PreprocessedSource Process(const std::string& path);
+
+		static void AddIncludeDirectory(const std::string& directory);
+
+		// Drops a changed file from the cache, the next Process reads it again
+		static void Invalidate(const std::string& path);
+
+		static Statistics GetStats();
+	};
+}
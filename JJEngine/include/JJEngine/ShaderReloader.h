@@ -0,0 +1,51 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+struct GLFWwindow;
+
+namespace JJEngine {
+	class Shader;
+	class JobSystem;
+
+	// Recompiles file-based shaders when their sources or anything they #include change, without
+	// stalling the frame. Only shaders depending on a changed file are reloaded.
+	// Files are read on the job system, then compiled with KHR_parallel_shader_compile when the
+	// driver has it, or on a background thread with its own shared context when it doesn't.
+	// The shader keeps drawing with its old program until the new one has linked, the swap is
+	// recorded as a render command so it lands between two frames. A program that fails to
+	// compile is discarded and the old one stays.
+	//
+	// Uniforms are per program, values set once after loading have to be set again after a reload.
+	class ShaderReloader {
+	public:
+		enum class Mode { Disabled, ParallelCompile, SharedContext, Synchronous };
+
+		struct Statistics {
+			uint32_t reloads = 0;   // Programs swapped in since Init
+			uint32_t failures = 0;  // Reloads discarded because compiling or linking failed
+			uint32_t pending = 0;   // Reloads waiting for files or the compiler
+		};
+
+		// Must be called on the main thread with the window's context current
+		static void Init(GLFWwindow* window, JobSystem* jobSystem = nullptr);
+		static void Shutdown();
+
+		// Turned off the watcher stops reporting changes, reloads already started still finish
+		static void SetEnabled(bool enabled);
+		static bool IsEnabled();
+
+		// Called by Shader when it loads from or is destroyed. No-ops before Init.
+		// dependencies are the files the shader was preprocessed from, the stage files included.
+		static void Register(Shader& shader, const std::vector<std::string>& dependencies);
+		static void Unregister(Shader& shader);
+
+		// Picks up file changes and advances running reloads, once per frame on the main thread
+		static void Update();
+
+		static Mode GetMode();
+		static Statistics GetStats();
+	};
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <cstddef>
+#include <glad/glad.h>
+
+namespace JJEngine {
+	// Persistently mapped ring buffer for per-frame dynamic data.
+	// The buffer is split into regions that are fenced once the GPU may read from them,
+	// so writing never needs glBufferSubData and never triggers an implicit sync.
+	class StreamBuffer {
+	public:
+		static constexpr uint32_t RegionCount = 3;
+
+		struct Allocation {
+			void* data = nullptr;
+			GLintptr offset = 0;
+		};
+
+		struct Statistics {
+			size_t bytesStreamed = 0;
+			uint32_t fenceWaits = 0;
+			double fenceWaitTime = 0.0; // Milliseconds
+		};
+
+		StreamBuffer(size_t regionSize);
+		~StreamBuffer();
+
+		StreamBuffer(const StreamBuffer&) = delete;
+		StreamBuffer& operator=(const StreamBuffer&) = delete;
+
+		// Returns a write pointer into the mapped buffer and its offset for binding.
+		// Allocations larger than a region fail and return a null pointer.
+		Allocation Allocate(size_t size, size_t alignment = 4);
+
+		// Fences the current region and moves on to the next one.
+		// Call once all of this frame's draws using the buffer have been issued.
+		void EndFrame();
+
+		GLuint GetRendererID() const { return m_rendererID; }
+		size_t GetRegionSize() const { return m_regionSize; }
+
+		// Statistics of the last completed frame
+		const Statistics& GetStats() const { return m_lastFrameStats; }
+
+	private:
+		void NextRegion();
+
+		GLuint m_rendererID = 0;
+		uint8_t* m_mappedData = nullptr;
+
+		size_t m_regionSize;
+		uint32_t m_region = 0;
+		size_t m_regionOffset = 0;
+
+		std::array<GLsync, RegionCount> m_fences{};
+
+		Statistics m_frameStats;
+		Statistics m_lastFrameStats;
+	};
+}
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <glad/glad.h>
+
+#include "AssetManager.h"
+
+namespace JJEngine {
+	enum class TextureFormat { RGBA8, SRGB8Alpha8, RG8, R8 };
+
+	// Immutable storage with a full mip chain unless told otherwise. Pixel data is staged through
+	// a persistently mapped PBO ring shared by all textures, so glTextureSubImage only queues a copy
+	// the GPU performs later instead of reading client memory before returning.
+	// Rows are bottom to top and tightly packed.
+	class Texture {
+	public:
+		// Creates the staging ring and looks for ARB_bindless_texture, with the context current
+		static void Init();
+		static void Shutdown();
+
+		// Fences this frame's staging region, on the context thread once per frame
+		static void EndFrame();
+
+		static bool IsBindlessSupported();
+
+		// Points a bindless_sampler uniform array of program at resident handles. Context thread,
+		// only with bindless support.
+		static void SetSamplerHandles(GLuint program, GLint location, uint32_t count, const uint64_t* handles);
+
+		virtual ~Texture();
+
+		Texture(const Texture&) = delete;
+		Texture& operator=(const Texture&) = delete;
+
+		// Context thread. Stages and uploads rows [y, y + rowCount) of a level, or of one array layer.
+		// Large uploads are split into bands that fit the staging ring.
+		void UploadRows(uint32_t level, uint32_t layer, uint32_t y, uint32_t rowCount, const void* pixels);
+
+		// Fills the levels below the base level from it on the GPU
+		void GenerateMipmaps();
+
+		// Recorded through RenderThread
+		void Bind(uint32_t unit) const;
+
+		// Resident handle for sampling without binding, 0 without ARB_bindless_texture. Context thread.
+		// The texture's sampling parameters are frozen once a handle exists.
+		uint64_t GetBindlessHandle();
+
+		GLuint GetRendererID() const { return m_rendererID; }
+		TextureFormat GetFormat() const { return m_format; }
+		uint32_t GetWidth() const { return m_width; }
+		uint32_t GetHeight() const { return m_height; }
+		uint32_t GetLevels() const { return m_levels; }
+
+		static uint32_t GetBytesPerPixel(TextureFormat format);
+		static uint32_t GetFullMipCount(uint32_t width, uint32_t height);
+
+	protected:
+		Texture(GLenum target, uint32_t width, uint32_t height, uint32_t layers, TextureFormat format, uint32_t levels);
+
+		// Copies pixels for the caller when the upload has to wait for the render thread
+		void SubmitUpload(uint32_t level, uint32_t layer, const void* pixels);
+
+		GLuint m_rendererID = 0;
+		GLenum m_target;
+		TextureFormat m_format;
+		uint32_t m_width, m_height, m_layers, m_levels;
+		uint64_t m_bindlessHandle = 0;
+	};
+
+	class Texture2D : public Texture {
+	public:
+		// levels 0 allocates the full mip chain
+		Texture2D(uint32_t width, uint32_t height, TextureFormat format = TextureFormat::RGBA8, uint32_t levels = 0);
+
+		// Whole level, the caller may free pixels as soon as this returns
+		void SetData(const void* pixels, uint32_t level = 0) { SubmitUpload(level, 0, pixels); }
+	};
+
+	// Layers share size, format and mip count and are sampled as sampler2DArray
+	class TextureArray : public Texture {
+	public:
+		TextureArray(uint32_t width, uint32_t height, uint32_t layers, TextureFormat format = TextureFormat::RGBA8, uint32_t levels = 0);
+
+		void SetLayerData(uint32_t layer, const void* pixels, uint32_t level = 0) { SubmitUpload(level, layer, pixels); }
+
+		uint32_t GetLayerCount() const { return m_layers; }
+	};
+
+	// Texture2D loaded from a TGA file through AssetManager. Decoded on a worker, then uploaded in
+	// bands within the manager's per-frame budgets, mipmaps are generated once the base level is in.
+	// Uncompressed and RLE true-color or grayscale TGAs, 8-bit gray loads as R8, the rest as RGBA8.
+	class TextureAsset : public Asset {
+	public:
+		TextureAsset(bool srgb = false) : m_srgb(srgb) {}
+		~TextureAsset() override;
+
+		Texture2D& GetTexture() const { return *m_texture; }
+
+	private:
+		static constexpr size_t UploadSliceSize = 1024 * 1024;
+
+		bool Decode(std::vector<std::byte>& data) override;
+		bool Upload() override;
+		size_t GetNextUploadSize() const override;
+
+		uint32_t GetRowsPerSlice() const;
+
+		bool m_srgb;
+		TextureFormat m_format = TextureFormat::RGBA8;
+		uint32_t m_width = 0, m_height = 0;
+		uint32_t m_uploadedRows = 0;
+		std::vector<std::byte> m_pixels;
+		std::unique_ptr<Texture2D> m_texture;
+	};
+}
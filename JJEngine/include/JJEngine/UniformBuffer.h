@@ -0,0 +1,198 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <tuple>
+#include <utility>
+#include <algorithm>
+#include <string_view>
+#include <type_traits>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "GLState.h"
+
+namespace JJEngine {
+	enum class BufferLayout { Std140, Std430 };
+
+	template<BufferLayout> constexpr bool UnsupportedBufferType = false;
+
+	// Members of a struct nested in a block, declared with JJ_BUFFER_STRUCT. GLSL aligns a struct
+	// to its largest member, which alignof can't see for glm types, so it's derived from this list.
+	template<typename T>
+	struct BufferStruct;
+
+	template<typename T>
+	concept DeclaredBufferStruct = requires { BufferStruct<T>::members; };
+
+	template<typename T, BufferLayout Layout>
+	struct BufferAlignment;
+
+	template<typename T, BufferLayout Layout>
+	constexpr size_t GetBufferStructAlignment()
+	{
+		if constexpr(!DeclaredBufferStruct<T>)
+		{
+			return 16;
+		}
+		else
+		{
+			size_t alignment = std::apply([](auto... members) { return std::max({ size_t(4), BufferAlignment<std::remove_cvref_t<decltype(std::declval<T&>().*members)>, Layout>::value... }); },
+				BufferStruct<T>::members);
+
+			// std140 also rounds structs up to a vec4
+			return Layout == BufferLayout::Std140 ? std::max<size_t>(alignment, 16) : alignment;
+		}
+	}
+
+	// Base alignment of a type inside a std140/std430 block.
+	// Anything that isn't a scalar, vector or matrix is a nested struct and must be declared with JJ_BUFFER_STRUCT.
+	template<typename T, BufferLayout Layout>
+	struct BufferAlignment {
+		static_assert(DeclaredBufferStruct<T>, "Type has no std140/std430 equivalent, declare nested structs with JJ_BUFFER_STRUCT");
+		static constexpr size_t value = GetBufferStructAlignment<T, Layout>();
+
+		// GLSL pads a struct to a multiple of its alignment, so whatever follows it starts there
+		static_assert(sizeof(T) % value == 0, "Struct size isn't a multiple of its block alignment, pad the end of the struct");
+	};
+
+	template<BufferLayout L> struct BufferAlignment<float, L> { static constexpr size_t value = 4; };
+	template<BufferLayout L> struct BufferAlignment<int32_t, L> { static constexpr size_t value = 4; };
+	template<BufferLayout L> struct BufferAlignment<uint32_t, L> { static constexpr size_t value = 4; };
+	template<BufferLayout L> struct BufferAlignment<glm::vec2, L> { static constexpr size_t value = 8; };
+	template<BufferLayout L> struct BufferAlignment<glm::ivec2, L> { static constexpr size_t value = 8; };
+	template<BufferLayout L> struct BufferAlignment<glm::uvec2, L> { static constexpr size_t value = 8; };
+	template<BufferLayout L> struct BufferAlignment<glm::vec3, L> { static constexpr size_t value = 16; };
+	template<BufferLayout L> struct BufferAlignment<glm::ivec3, L> { static constexpr size_t value = 16; };
+	template<BufferLayout L> struct BufferAlignment<glm::uvec3, L> { static constexpr size_t value = 16; };
+	template<BufferLayout L> struct BufferAlignment<glm::vec4, L> { static constexpr size_t value = 16; };
+	template<BufferLayout L> struct BufferAlignment<glm::ivec4, L> { static constexpr size_t value = 16; };
+	template<BufferLayout L> struct BufferAlignment<glm::uvec4, L> { static constexpr size_t value = 16; };
+	template<BufferLayout L> struct BufferAlignment<glm::mat4, L> { static constexpr size_t value = 16; };
+
+	// Matrices are arrays of column vectors. mat2 columns are 8 bytes apart in std430 like in glm,
+	// std140 rounds them to 16. mat3 columns are vec3s, 16 bytes apart in both layouts but 12 in glm.
+	template<BufferLayout L>
+	struct BufferAlignment<glm::mat2, L> {
+		static_assert(L == BufferLayout::Std430, "std140 pads mat2 columns to 16 bytes, use glm::mat2x4 and read .xy in the shader");
+		static constexpr size_t value = 8;
+	};
+
+	template<BufferLayout L>
+	struct BufferAlignment<glm::mat3, L> {
+		static_assert(UnsupportedBufferType<L>, "glm::mat3 columns are 12 bytes but GLSL pads them to 16, use glm::mat3x4 or a mat4");
+		static constexpr size_t value = 16;
+	};
+
+	// Array elements sit at a stride of the element's block size rounded up to its alignment, and std140
+	// rounds that up to a vec4. C++ doesn't round, so the element type must already have that size.
+	template<typename T, size_t N, BufferLayout Layout>
+	struct BufferAlignment<T[N], Layout> {
+		static constexpr size_t value = Layout == BufferLayout::Std140 ? std::max<size_t>(16, BufferAlignment<T, Layout>::value) : BufferAlignment<T, Layout>::value;
+		static_assert(sizeof(T) % value == 0, "Array stride doesn't match the block layout, pad the element type");
+	};
+
+	// Declares the members of a struct used inside blocks, at global namespace scope after the struct:
+	//   JJ_BUFFER_STRUCT(Light, &Light::position, &Light::color);
+	// Its own members still need JJ_BUFFER_MEMBER to check their offsets.
+#define JJ_BUFFER_STRUCT(Type, ...) \
+	template<> struct JJEngine::BufferStruct<Type> { static constexpr auto members = std::make_tuple(__VA_ARGS__); }
+
+	// Validates one member of a block struct, e.g. JJ_BUFFER_MEMBER(CameraData, viewProjection, JJEngine::BufferLayout::Std140);
+#define JJ_BUFFER_MEMBER(Type, member, layout) \
+	static_assert(offsetof(Type, member) % ::JJEngine::BufferAlignment<decltype(Type::member), layout>::value == 0, \
+		#Type "::" #member " is misaligned for " #layout)
+
+	// Maps block names to binding points shared by every program,
+	// so one buffer bound once per frame serves all shaders declaring the block.
+	// Throws std::runtime_error once a new block name would exceed the driver's binding points.
+	class BufferBindings {
+	public:
+		static GLuint GetBindingPoint(std::string_view blockName, GLenum target);
+
+		// Size of the C++ struct backing a block, 0 if no buffer has been created for it
+		static size_t GetBlockSize(std::string_view blockName, GLenum target);
+		static void SetBlockSize(std::string_view blockName, GLenum target, size_t size);
+	};
+
+	// GPU copy of a block struct. Members are written through Set, which records the dirty range,
+	// and Upload sends only that range once per frame.
+	template<typename T, BufferLayout Layout>
+	class BlockBuffer {
+		static_assert(std::is_trivially_copyable_v<T> && std::is_standard_layout_v<T>, "Block structs must be plain data");
+		static_assert(Layout != BufferLayout::Std140 || sizeof(T) % 16 == 0, "std140 block size must be a multiple of 16");
+
+	public:
+		static constexpr GLenum Target = Layout == BufferLayout::Std140 ? GL_UNIFORM_BUFFER : GL_SHADER_STORAGE_BUFFER;
+
+		BlockBuffer(std::string_view blockName, const T& data = T())
+			: m_data(data), m_bindingPoint(BufferBindings::GetBindingPoint(blockName, Target))
+		{
+			BufferBindings::SetBlockSize(blockName, Target, sizeof(T));
+
+			glCreateBuffers(1, &m_rendererID);
+			glNamedBufferStorage(m_rendererID, sizeof(T), &m_data, GL_DYNAMIC_STORAGE_BIT);
+			Bind();
+		}
+
+		~BlockBuffer()
+		{
+			GLState::DeleteBuffer(m_rendererID);
+		}
+
+		BlockBuffer(const BlockBuffer&) = delete;
+		BlockBuffer& operator=(const BlockBuffer&) = delete;
+
+		const T& Get() const { return m_data; }
+
+		template<typename M>
+		void Set(M T::* member, const M& value)
+		{
+			M& target = m_data.*member;
+			target = value;
+			MarkDirty((size_t)((uint8_t*)&target - (uint8_t*)&m_data), sizeof(M));
+		}
+
+		// Marks the whole struct dirty
+		T& Edit()
+		{
+			MarkDirty(0, sizeof(T));
+			return m_data;
+		}
+
+		void Upload()
+		{
+			if(m_dirtyBegin >= m_dirtyEnd)
+				return;
+
+			glNamedBufferSubData(m_rendererID, (GLintptr)m_dirtyBegin, (GLsizeiptr)(m_dirtyEnd - m_dirtyBegin), (uint8_t*)&m_data + m_dirtyBegin);
+			m_dirtyBegin = sizeof(T);
+			m_dirtyEnd = 0;
+		}
+
+		void Bind() const { GLState::BindBufferBase(Target, m_bindingPoint, m_rendererID); }
+
+		GLuint GetRendererID() const { return m_rendererID; }
+		GLuint GetBindingPoint() const { return m_bindingPoint; }
+
+	private:
+		void MarkDirty(size_t offset, size_t size)
+		{
+			m_dirtyBegin = std::min(m_dirtyBegin, offset);
+			m_dirtyEnd = std::max(m_dirtyEnd, offset + size);
+		}
+
+		T m_data;
+		GLuint m_rendererID = 0;
+		GLuint m_bindingPoint;
+
+		size_t m_dirtyBegin = sizeof(T);
+		size_t m_dirtyEnd = 0;
+	};
+
+	template<typename T>
+	using UniformBuffer = BlockBuffer<T, BufferLayout::Std140>;
+
+	template<typename T>
+	using StorageBuffer = BlockBuffer<T, BufferLayout::Std430>;
+}
@@ -1,15 +1,26 @@
 #pragma once
 
+#include <string>
+#include <vector>
+#include <cstdint>
+
 #include "glm/vec4.hpp"
 
 
 class GLFWwindow;
 
 namespace JJEngine {
+	enum class WindowMode {
+		Windowed,
+		// Invisible window rendering into an offscreen framebuffer with vsync off. Without a display
+		// (no DISPLAY/WAYLAND_DISPLAY) GLFW's null platform is used with a surfaceless EGL or OSMesa context.
+		Headless
+	};
+
 	class Window
 	{
 	public:
-		Window(const char* title, int width, int height, glm::vec4 clearColor = glm::vec4(0,0,0,1));
+		Window(const char* title, int width, int height, glm::vec4 clearColor = glm::vec4(0,0,0,1), WindowMode mode = WindowMode::Windowed);
 		~Window();
 
 		void Clear();
@@ -30,9 +41,26 @@ namespace JJEngine {
 		int GetHeight() const { return m_height; }
 		void SetSize(int width, int height);
 
+		bool IsVSync() const { return m_vsync; }
+		void SetVSync(bool enabled);
+
 		bool ShouldClose() const;
 
+		bool IsHeadless() const { return m_mode == WindowMode::Headless; }
+
+		// Framebuffer everything is rendered into, 0 unless headless
+		uint32_t GetFramebufferID() const { return m_framebuffer; }
+
+		// Reads back the current frame as tightly packed RGBA8, top row first.
+		// This stalls until the GPU has finished the frame, meant for golden-image tests.
+		// Needs the context, so with a render thread call these from a RenderThread::Submit command.
+		void ReadPixels(std::vector<uint8_t>& pixels) const;
+		bool SaveFrame(const std::string& filePath) const;
+
 	private:
+		void CreateOffscreenTarget();
+		void DestroyOffscreenTarget();
+
 		static Window* s_instance;
 
 		glm::vec4 m_clearColor;
@@ -42,5 +70,11 @@ namespace JJEngine {
 		const char* m_title;
 
 		int m_width, m_height;
+
+		bool m_vsync = true;
+
+		WindowMode m_mode;
+		uint32_t m_framebuffer = 0;
+		uint32_t m_colorAttachment = 0, m_depthAttachment = 0;
 	};
 }
\ No newline at end of file
@@ -0,0 +1,149 @@
+#include "JJEngine/Allocators.h"
+
+namespace JJEngine {
+	LinearAllocator::LinearAllocator(size_t capacity, std::pmr::memory_resource* upstream)
+		: m_buffer(std::make_unique<std::byte[]>(capacity)), m_capacity(capacity), m_upstream(upstream)
+	{
+	}
+
+	LinearAllocator::~LinearAllocator()
+	{
+		Reset();
+	}
+
+	void* LinearAllocator::Allocate(size_t size, size_t alignment)
+	{
+		m_allocations.fetch_add(1, std::memory_order_relaxed);
+
+		// Reserve enough for the worst case padding so the bump stays a single atomic add
+		size_t reserved = size + alignment - 1;
+		size_t offset = m_offset.fetch_add(reserved, std::memory_order_relaxed);
+		if(offset + reserved > m_capacity)
+			return AllocateOverflow(size, alignment);
+
+		uintptr_t address = (uintptr_t)(m_buffer.get() + offset);
+		address = (address + alignment - 1) & ~(uintptr_t)(alignment - 1);
+		return (void*)address;
+	}
+
+	void* LinearAllocator::AllocateOverflow(size_t size, size_t alignment)
+	{
+		void* pointer = m_upstream->allocate(size, alignment);
+
+		std::lock_guard<std::mutex> lock(m_overflowMutex);
+		m_overflow.push_back({ pointer, size, alignment });
+		m_overflowBytes += size;
+		return pointer;
+	}
+
+	void LinearAllocator::Reset()
+	{
+		for(const OverflowBlock& block : m_overflow)
+			m_upstream->deallocate(block.pointer, block.size, block.alignment);
+		m_overflow.clear();
+		m_overflowBytes = 0;
+
+		m_offset.store(0, std::memory_order_relaxed);
+		m_allocations.store(0, std::memory_order_relaxed);
+	}
+
+	void LinearAllocator::Reserve(size_t capacity)
+	{
+		if(capacity <= m_capacity)
+			return;
+
+		m_buffer = std::make_unique<std::byte[]>(capacity);
+		m_capacity = capacity;
+	}
+
+	AllocationStats LinearAllocator::GetStats() const
+	{
+		AllocationStats stats;
+		stats.bytes = std::min(m_offset.load(std::memory_order_relaxed), m_capacity);
+		stats.allocations = m_allocations.load(std::memory_order_relaxed);
+		stats.overflowBytes = m_overflowBytes;
+		return stats;
+	}
+
+	FrameAllocator::FrameAllocator(size_t capacityPerFrame)
+	{
+		for(std::unique_ptr<LinearAllocator>& arena : m_arenas)
+			arena = std::make_unique<LinearAllocator>(capacityPerFrame);
+	}
+
+	void FrameAllocator::BeginFrame()
+	{
+		m_lastFrameStats = GetCurrent().GetStats();
+
+		m_current ^= 1;
+		GetCurrent().Reset();
+	}
+
+	PoolAllocator::PoolAllocator(size_t blockSize, size_t blockCount, size_t alignment, std::pmr::memory_resource* upstream)
+		: m_blockCount(blockCount), m_alignment(alignment), m_upstream(upstream)
+	{
+		// Every block has to be able to hold the free list link and keep the alignment of the next block
+		m_blockSize = std::max(blockSize, sizeof(FreeBlock));
+		m_blockSize = (m_blockSize + alignment - 1) / alignment * alignment;
+
+		m_buffer = std::make_unique<std::byte[]>(m_blockSize * m_blockCount + alignment - 1);
+		uintptr_t address = (uintptr_t)m_buffer.get();
+		m_blocks = (std::byte*)((address + alignment - 1) & ~(uintptr_t)(alignment - 1));
+
+		for(size_t i = m_blockCount; i > 0; i--)
+		{
+			FreeBlock* block = (FreeBlock*)(m_blocks + (i - 1) * m_blockSize);
+			block->next = m_freeList;
+			m_freeList = block;
+		}
+	}
+
+	void* PoolAllocator::Allocate()
+	{
+		if(m_freeList == nullptr)
+			return nullptr;
+
+		FreeBlock* block = m_freeList;
+		m_freeList = block->next;
+		m_usedBlocks++;
+
+		m_stats.allocations++;
+		m_stats.bytes += m_blockSize;
+		return block;
+	}
+
+	void PoolAllocator::Free(void* pointer)
+	{
+		FreeBlock* block = (FreeBlock*)pointer;
+		block->next = m_freeList;
+		m_freeList = block;
+		m_usedBlocks--;
+	}
+
+	void* PoolAllocator::do_allocate(size_t bytes, size_t alignment)
+	{
+		if(bytes <= m_blockSize && alignment <= m_alignment)
+		{
+			if(void* block = Allocate())
+				return block;
+		}
+
+		m_stats.allocations++;
+		m_stats.overflowBytes += bytes;
+		return m_upstream->allocate(bytes, alignment);
+	}
+
+	void PoolAllocator::do_deallocate(void* pointer, size_t bytes, size_t alignment)
+	{
+		if(Owns(pointer))
+			Free(pointer);
+		else
+			m_upstream->deallocate(pointer, bytes, alignment);
+	}
+
+	bool PoolAllocator::Owns(void* pointer) const
+	{
+		std::byte* address = (std::byte*)pointer;
+		return address >= m_blocks && address < m_blocks + m_blockSize * m_blockCount;
+	}
+}
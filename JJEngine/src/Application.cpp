@@ -1,18 +1,31 @@
+#include <chrono>
+#include <algorithm>
 #include <iostream>
+#ifdef _WIN32
 #include <windows.h>
+#endif
 
 #include "JJEngine/Application.h"
 #include "JJEngine/Window.h"
+#include "JJEngine/Renderer2D.h"
+#include "JJEngine/Profiler.h"
+#include "JJEngine/GpuProfiler.h"
+#include "JJEngine/RenderThread.h"
+#include "JJEngine/GLState.h"
+#include "JJEngine/ShaderReloader.h"
+#include "JJEngine/AssetManager.h"
+#include "JJEngine/Texture.h"
+#include "JJEngine/Mesh.h"
 
 namespace JJEngine {
 	Application* Application::s_instance = nullptr;
 
-	Application::Application(const char* windowTitle, bool createConsoleOnDebug)
+	Application::Application(const char* windowTitle, bool createConsoleOnDebug, WindowMode windowMode) : m_running(false)
 	{
 		if(s_instance != nullptr)
 			throw std::runtime_error("Application already exists");
 
-		#ifdef _DEBUG
+#if defined(_DEBUG) && defined(_WIN32)
 		if(createConsoleOnDebug) 
 		{
 			AllocConsole();
@@ -24,7 +37,18 @@ namespace JJEngine {
 		}
 #endif
 
-		m_window = std::make_unique<Window>(windowTitle, 500, 500);
+		Profiler::SetThreadName("Main");
+
+		m_jobSystem = std::make_unique<JobSystem>();
+		m_window = std::make_unique<Window>(windowTitle, 500, 500, glm::vec4(0, 0, 0, 1), windowMode);
+
+		RenderThread::Init(m_window->GetGLFWWindow());
+		ShaderReloader::Init(m_window->GetGLFWWindow(), m_jobSystem.get());
+		AssetManager::Init(m_jobSystem.get());
+		GpuProfiler::Init();
+		// Renderer2D checks for bindless support and creates its white texture
+		Texture::Init();
+		Renderer2D::Init();
 
 		s_instance = this;
 	}
@@ -33,10 +57,77 @@ namespace JJEngine {
 	{
 		std::cout << "Destroying application" << std::endl;
 
+		Renderer2D::Shutdown();
+		Texture::Shutdown();
+		GpuProfiler::Shutdown();
+		AssetManager::Shutdown();
+		ShaderReloader::Shutdown();
+		RenderThread::Shutdown();
+
 		m_window.reset();
+		m_jobSystem.reset();
 
 		if(s_instance == this)
 			s_instance = nullptr;
 	}
 
+	void Application::Run()
+	{
+		using Clock = std::chrono::steady_clock;
+
+		m_running = true;
+
+		RenderThread::Start(m_framesInFlight);
+
+		Clock::time_point previousTime = Clock::now();
+		double accumulator = 0.0;
+
+		while(m_running && !m_window->ShouldClose())
+		{
+			JJ_PROFILE_SCOPE("Frame");
+
+			Clock::time_point currentTime = Clock::now();
+			double frameTime = std::chrono::duration<double>(currentTime - previousTime).count();
+			previousTime = currentTime;
+
+			m_frameStats.AddFrame(frameTime * 1000.0);
+			m_frameAllocator.BeginFrame();
+
+			accumulator += std::min(frameTime, m_maxFrameTime);
+			while(accumulator >= m_fixedTimestep)
+			{
+				JJ_PROFILE_SCOPE("Application::OnUpdate");
+				OnUpdate(m_fixedTimestep);
+				accumulator -= m_fixedTimestep;
+			}
+
+			ShaderReloader::Update();
+			AssetManager::Update();
+
+			GpuProfiler::BeginFrame();
+			{
+				GpuProfileScope gpuFrameScope("Frame");
+
+				m_window->Clear();
+				Renderer2D::ResetStats();
+
+				{
+					JJ_PROFILE_SCOPE("Application::OnRender");
+					GpuProfileScope gpuRenderScope("Render");
+					OnRender(accumulator / m_fixedTimestep);
+				}
+			}
+
+			m_window->Update();
+			RenderThread::Submit([]() { Mesh::EndFrame(); Texture::EndFrame(); GLState::EndFrame(); });
+			RenderThread::EndFrame();
+		}
+
+		// Resources are destroyed on the main thread, so the context comes back here
+		RenderThread::Stop();
+
+		m_running = false;
+
+		EndProfileSession();
+	}
 }
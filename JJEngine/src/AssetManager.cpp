@@ -0,0 +1,844 @@
+#include <deque>
+#include <mutex>
+#include <chrono>
+#include <thread>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <algorithm>
+#include <filesystem>
+#include <unordered_map>
+#include <condition_variable>
+
+#include "JJEngine/AssetManager.h"
+#include "JJEngine/MappedFile.h"
+#include "JJEngine/PackFile.h"
+#include "JJEngine/JobSystem.h"
+#include "JJEngine/RenderThread.h"
+#include "JJEngine/GLState.h"
+#include "JJEngine/Profiler.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#define JJ_ASSET_PREAD 1
+#endif
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/uio.h>
+#include <sys/eventfd.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+#define JJ_ASSET_IO_URING 1
+#endif
+
+namespace JJEngine {
+	// Reaches into Asset for the pipeline stages, Asset declares it a friend
+	struct AssetPipeline {
+		static void SetPath(Asset& asset, const std::string& path) { asset.m_path = path; }
+		static void SetState(Asset& asset, Asset::State state) { asset.m_state.store(state, std::memory_order_release); }
+		static bool Decode(Asset& asset, std::vector<std::byte>& data) { return asset.Decode(data); }
+		static bool Upload(Asset& asset) { return asset.Upload(); }
+		static size_t GetNextUploadSize(const Asset& asset) { return asset.GetNextUploadSize(); }
+	};
+
+	namespace {
+		using Clock = std::chrono::steady_clock;
+
+		struct ReadRequest {
+			Asset* asset; // Kept alive by AssetManagerData::loading
+			std::string path;
+			std::vector<std::byte> data;
+
+			// Set if the file is in a mounted pack, which lives until Shutdown
+			const PackFile* pack = nullptr;
+			const PackFile::Entry* packEntry = nullptr;
+
+#if JJ_ASSET_IO_URING
+			int file = -1;
+			size_t offset = 0;
+			iovec buffer{};
+#endif
+		};
+
+		class FileReader {
+		public:
+			virtual ~FileReader() = default;
+			virtual void Read(ReadRequest* request) = 0;
+		};
+
+		struct MountedPack {
+			std::unique_ptr<PackFile> pack;
+			std::string mountPoint; // Normalized, with a trailing '/' unless empty
+		};
+
+		struct AssetManagerData {
+			JobSystem* jobSystem = nullptr;
+			AssetManager::IoBackend backend = AssetManager::IoBackend::None;
+			std::unique_ptr<FileReader> reader;
+			JobCounter decodeCounter;
+
+			// Main thread
+			std::vector<MountedPack> packs;
+			std::unordered_map<std::string, std::weak_ptr<Asset>> assets;
+			std::vector<std::shared_ptr<Asset>> loading;
+			uint32_t packLoads = 0;
+			double uploadBudget = 2.0;
+			size_t uploadByteBudget = 8 * 1024 * 1024;
+
+			// Filled by decode jobs, drained on the context thread
+			std::mutex uploadMutex;
+			std::deque<Asset*> uploads;
+
+			std::atomic<uint32_t> loaded = 0;
+			std::atomic<uint32_t> failed = 0;
+			std::atomic<uint64_t> bytesRead = 0;
+			std::atomic<double> uploadTime = 0.0;
+			std::atomic<size_t> uploadBytes = 0;
+		};
+
+		AssetManagerData* s_data = nullptr;
+
+		void Fail(Asset& asset, const char* reason)
+		{
+			std::cout << "Error: Failed to load asset " << asset.GetPath() << ", " << reason << "\n";
+			s_data->failed.fetch_add(1, std::memory_order_relaxed);
+			AssetPipeline::SetState(asset, Asset::State::Failed);
+		}
+
+		void DecodeAsset(ReadRequest* request)
+		{
+			JJ_PROFILE_SCOPE("AssetManager::Decode");
+
+			Asset* asset = request->asset;
+			bool decoded = AssetPipeline::Decode(*asset, request->data);
+			delete request;
+
+			if(!decoded)
+			{
+				Fail(*asset, "decoding failed");
+				return;
+			}
+
+			std::lock_guard<std::mutex> lock(s_data->uploadMutex);
+			s_data->uploads.push_back(asset);
+		}
+
+		// Called on an I/O thread
+		void OnReadComplete(ReadRequest* request, bool succeeded)
+		{
+			if(!succeeded)
+			{
+				Fail(*request->asset, "file missing or unreadable");
+				delete request;
+				return;
+			}
+
+			s_data->bytesRead.fetch_add(request->data.size(), std::memory_order_relaxed);
+
+			if(s_data->jobSystem != nullptr)
+				s_data->jobSystem->Run([request]() { DecodeAsset(request); }, &s_data->decodeCounter);
+			else
+				DecodeAsset(request);
+		}
+
+		// Job or I/O thread, the entry was prefetched when the load started
+		void ReadFromPack(ReadRequest* request)
+		{
+			JJ_PROFILE_SCOPE("AssetManager::ReadFromPack");
+
+			if(!request->pack->Read(*request->packEntry, request->data))
+			{
+				Fail(*request->asset, "pack entry corrupt");
+				delete request;
+				return;
+			}
+
+			s_data->bytesRead.fetch_add(request->packEntry->size, std::memory_order_relaxed);
+			DecodeAsset(request);
+		}
+
+		bool ReadWholeFile(const std::string& path, std::vector<std::byte>& data)
+		{
+#if JJ_ASSET_PREAD
+			int file = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+			if(file < 0)
+				return false;
+
+			struct stat status{};
+			if(fstat(file, &status) != 0)
+			{
+				close(file);
+				return false;
+			}
+
+			data.resize((size_t)status.st_size);
+			size_t offset = 0;
+			while(offset < data.size())
+			{
+				ssize_t read = pread(file, data.data() + offset, data.size() - offset, (off_t)offset);
+				if(read < 0 && errno == EINTR)
+					continue;
+				if(read <= 0)
+					break;
+				offset += (size_t)read;
+			}
+			close(file);
+			return offset == data.size();
+#else
+			MappedFile file(path);
+			if(!file.IsOpen())
+				return false;
+
+			std::span<const std::byte> contents = file.GetData();
+			data.assign(contents.begin(), contents.end());
+			return true;
+#endif
+		}
+
+		class ThreadPoolReader : public FileReader {
+		public:
+			ThreadPoolReader(uint32_t threadCount)
+			{
+				for(uint32_t i = 0; i < std::max(threadCount, 1u); i++)
+					m_threads.emplace_back(&ThreadPoolReader::ThreadLoop, this);
+			}
+
+			~ThreadPoolReader() override
+			{
+				{
+					std::lock_guard<std::mutex> lock(m_mutex);
+					m_stopping = true;
+				}
+				m_condition.notify_all();
+				for(std::thread& thread : m_threads)
+					thread.join();
+
+				for(ReadRequest* request : m_queue)
+					delete request;
+			}
+
+			void Read(ReadRequest* request) override
+			{
+				{
+					std::lock_guard<std::mutex> lock(m_mutex);
+					m_queue.push_back(request);
+				}
+				m_condition.notify_one();
+			}
+
+		private:
+			void ThreadLoop()
+			{
+				Profiler::SetThreadName("Asset I/O");
+
+				for(;;)
+				{
+					ReadRequest* request;
+					{
+						std::unique_lock<std::mutex> lock(m_mutex);
+						m_condition.wait(lock, [this]() { return m_stopping || !m_queue.empty(); });
+						if(m_stopping)
+							break;
+
+						request = m_queue.front();
+						m_queue.pop_front();
+					}
+
+					JJ_PROFILE_SCOPE("AssetManager::Read");
+					if(request->pack != nullptr)
+						ReadFromPack(request);
+					else
+						OnReadComplete(request, ReadWholeFile(request->path, request->data));
+				}
+			}
+
+			std::vector<std::thread> m_threads;
+			std::mutex m_mutex;
+			std::condition_variable m_condition;
+			std::deque<ReadRequest*> m_queue;
+			bool m_stopping = false;
+		};
+
+#if JJ_ASSET_IO_URING
+		// io_uring through the raw syscalls, so no liburing is needed. One thread owns the ring: it
+		// opens files, queues reads and sleeps in io_uring_enter until any read or a wakeup completes.
+		// New requests wake it through an eventfd polled by the ring itself. Uses READV and POLL_ADD,
+		// so kernels from 5.1 on work.
+		class UringReader : public FileReader {
+		public:
+			static constexpr uint32_t Entries = 64;
+
+			static std::unique_ptr<UringReader> Create()
+			{
+				auto reader = std::make_unique<UringReader>();
+				if(!reader->Setup())
+					return nullptr;
+
+				reader->m_thread = std::thread(&UringReader::ThreadLoop, reader.get());
+				return reader;
+			}
+
+			~UringReader() override
+			{
+				if(m_thread.joinable())
+				{
+					m_stopping.store(true, std::memory_order_release);
+					Wake();
+					m_thread.join();
+				}
+
+				for(ReadRequest* request : m_incoming)
+					delete request;
+
+				if(m_sqes != nullptr)
+					munmap(m_sqes, m_sqesSize);
+				if(m_cqRing != nullptr && m_cqRing != m_sqRing)
+					munmap(m_cqRing, m_cqRingSize);
+				if(m_sqRing != nullptr)
+					munmap(m_sqRing, m_sqRingSize);
+				if(m_ring >= 0)
+					close(m_ring);
+				if(m_wakeup >= 0)
+					close(m_wakeup);
+			}
+
+			void Read(ReadRequest* request) override
+			{
+				{
+					std::lock_guard<std::mutex> lock(m_mutex);
+					m_incoming.push_back(request);
+				}
+				Wake();
+			}
+
+		private:
+			template<typename T>
+			T* RingField(void* ring, uint32_t offset) { return (T*)((char*)ring + offset); }
+
+			bool Setup()
+			{
+				io_uring_params params{};
+				m_ring = (int)syscall(__NR_io_uring_setup, Entries, &params);
+				if(m_ring < 0)
+					return false;
+
+				m_sqRingSize = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+				m_cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+				bool singleMap = params.features & IORING_FEAT_SINGLE_MMAP;
+				if(singleMap)
+					m_sqRingSize = m_cqRingSize = std::max(m_sqRingSize, m_cqRingSize);
+
+				void* sqRing = mmap(nullptr, m_sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_ring, IORING_OFF_SQ_RING);
+				if(sqRing == MAP_FAILED)
+					return false;
+				m_sqRing = sqRing;
+
+				void* cqRing = singleMap ? sqRing : mmap(nullptr, m_cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_ring, IORING_OFF_CQ_RING);
+				if(cqRing == MAP_FAILED)
+					return false;
+				m_cqRing = cqRing;
+
+				m_sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+				void* sqes = mmap(nullptr, m_sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_ring, IORING_OFF_SQES);
+				if(sqes == MAP_FAILED)
+					return false;
+				m_sqes = (io_uring_sqe*)sqes;
+
+				m_sqHead = RingField<uint32_t>(sqRing, params.sq_off.head);
+				m_sqTail = RingField<uint32_t>(sqRing, params.sq_off.tail);
+				m_sqMask = *RingField<uint32_t>(sqRing, params.sq_off.ring_mask);
+				m_sqArray = RingField<uint32_t>(sqRing, params.sq_off.array);
+				m_sqEntries = params.sq_entries;
+				m_cqHead = RingField<uint32_t>(cqRing, params.cq_off.head);
+				m_cqTail = RingField<uint32_t>(cqRing, params.cq_off.tail);
+				m_cqMask = *RingField<uint32_t>(cqRing, params.cq_off.ring_mask);
+				m_cqes = RingField<io_uring_cqe>(cqRing, params.cq_off.cqes);
+				m_localTail = *m_sqTail;
+
+				m_wakeup = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+				return m_wakeup >= 0;
+			}
+
+			void Wake()
+			{
+				uint64_t value = 1;
+				ssize_t written = write(m_wakeup, &value, sizeof(value));
+				(void)written;
+			}
+
+			io_uring_sqe* GetSqe()
+			{
+				uint32_t head = std::atomic_ref<uint32_t>(*m_sqHead).load(std::memory_order_acquire);
+				if(m_localTail - head >= m_sqEntries)
+					return nullptr;
+
+				uint32_t index = m_localTail & m_sqMask;
+				m_sqArray[index] = index;
+				m_localTail++;
+
+				io_uring_sqe* sqe = &m_sqes[index];
+				std::memset(sqe, 0, sizeof(*sqe));
+				return sqe;
+			}
+
+			void ArmWakeup()
+			{
+				io_uring_sqe* sqe = GetSqe();
+				sqe->opcode = IORING_OP_POLL_ADD;
+				sqe->fd = m_wakeup;
+				sqe->poll_events = POLLIN;
+				sqe->user_data = 0;
+			}
+
+			void SubmitRead(ReadRequest* request)
+			{
+				// The kernel caps single reads a little below 2 GiB, longer files take several
+				size_t remaining = request->data.size() - request->offset;
+				request->buffer.iov_base = request->data.data() + request->offset;
+				request->buffer.iov_len = std::min<size_t>(remaining, 0x7FFFF000);
+
+				io_uring_sqe* sqe = GetSqe();
+				sqe->opcode = IORING_OP_READV;
+				sqe->fd = request->file;
+				sqe->addr = (uint64_t)&request->buffer;
+				sqe->len = 1;
+				sqe->off = request->offset;
+				sqe->user_data = (uint64_t)request;
+			}
+
+			// Opens the file and queues its first read, or completes it right away if there is nothing to read
+			void StartRead(ReadRequest* request)
+			{
+				// Already mapped, a copy or decompression that doesn't need the ring
+				if(request->pack != nullptr)
+				{
+					ReadFromPack(request);
+					return;
+				}
+
+				request->file = open(request->path.c_str(), O_RDONLY | O_CLOEXEC);
+				struct stat status{};
+				if(request->file < 0 || fstat(request->file, &status) != 0)
+				{
+					FinishRead(request, false);
+					return;
+				}
+
+				request->data.resize((size_t)status.st_size);
+				if(request->data.empty())
+				{
+					FinishRead(request, true);
+					return;
+				}
+
+				SubmitRead(request);
+				m_inFlight++;
+			}
+
+			void FinishRead(ReadRequest* request, bool succeeded)
+			{
+				if(request->file >= 0)
+					close(request->file);
+				request->file = -1;
+				OnReadComplete(request, succeeded);
+			}
+
+			void HandleCompletion(const io_uring_cqe& cqe)
+			{
+				if(cqe.user_data == 0)
+				{
+					uint64_t value;
+					ssize_t read = ::read(m_wakeup, &value, sizeof(value));
+					(void)read;
+					m_wakeupArmed = false;
+					return;
+				}
+
+				ReadRequest* request = (ReadRequest*)cqe.user_data;
+				if(cqe.res == -EINTR || cqe.res == -EAGAIN)
+				{
+					SubmitRead(request);
+					return;
+				}
+
+				m_inFlight--;
+				if(cqe.res <= 0)
+				{
+					// Truncated while reading, or an I/O error
+					FinishRead(request, false);
+					return;
+				}
+
+				request->offset += (size_t)cqe.res;
+				if(request->offset < request->data.size())
+				{
+					SubmitRead(request);
+					m_inFlight++;
+					return;
+				}
+
+				FinishRead(request, true);
+			}
+
+			void ThreadLoop()
+			{
+				Profiler::SetThreadName("Asset I/O");
+
+				for(;;)
+				{
+					uint32_t head = *m_cqHead;
+					uint32_t tail = std::atomic_ref<uint32_t>(*m_cqTail).load(std::memory_order_acquire);
+					for(; head != tail; head++)
+						HandleCompletion(m_cqes[head & m_cqMask]);
+					std::atomic_ref<uint32_t>(*m_cqHead).store(head, std::memory_order_release);
+
+					// Reads already in the kernel write into request buffers, so those finish first
+					bool stopping = m_stopping.load(std::memory_order_acquire);
+					if(stopping && m_inFlight == 0)
+						break;
+
+					if(!m_wakeupArmed)
+					{
+						ArmWakeup();
+						m_wakeupArmed = true;
+					}
+
+					if(!stopping)
+					{
+						std::lock_guard<std::mutex> lock(m_mutex);
+						while(!m_incoming.empty() && m_inFlight < m_sqEntries - 1)
+						{
+							StartRead(m_incoming.front());
+							m_incoming.pop_front();
+						}
+					}
+
+					uint32_t submitted = *m_sqTail;
+					std::atomic_ref<uint32_t>(*m_sqTail).store(m_localTail, std::memory_order_release);
+
+					JJ_PROFILE_SCOPE("AssetManager::WaitForReads");
+					int result = (int)syscall(__NR_io_uring_enter, m_ring, m_localTail - submitted, 1, IORING_ENTER_GETEVENTS, nullptr, 0);
+					if(result < 0 && errno != EINTR && errno != EAGAIN && errno != EBUSY)
+					{
+						std::cout << "Error: io_uring_enter failed (" << errno << "), asset reads stopped\n";
+						break;
+					}
+				}
+			}
+
+			int m_ring = -1;
+			int m_wakeup = -1;
+			bool m_wakeupArmed = false;
+
+			void* m_sqRing = nullptr;
+			void* m_cqRing = nullptr;
+			size_t m_sqRingSize = 0, m_cqRingSize = 0, m_sqesSize = 0;
+
+			uint32_t* m_sqHead = nullptr;
+			uint32_t* m_sqTail = nullptr;
+			uint32_t* m_sqArray = nullptr;
+			uint32_t m_sqMask = 0;
+			uint32_t m_sqEntries = 0;
+			uint32_t m_localTail = 0;
+			io_uring_sqe* m_sqes = nullptr;
+
+			uint32_t* m_cqHead = nullptr;
+			uint32_t* m_cqTail = nullptr;
+			uint32_t m_cqMask = 0;
+			io_uring_cqe* m_cqes = nullptr;
+
+			uint32_t m_inFlight = 0;
+			std::atomic<bool> m_stopping = false;
+			std::thread m_thread;
+			std::mutex m_mutex;
+			std::deque<ReadRequest*> m_incoming;
+		};
+#endif
+
+		// Context thread
+		void ProcessUploads(double budget, size_t byteBudget)
+		{
+			JJ_PROFILE_FUNCTION();
+
+			Clock::time_point start = Clock::now();
+			double elapsed = 0.0;
+			size_t bytes = 0;
+			while(elapsed < budget)
+			{
+				Asset* asset;
+				{
+					std::lock_guard<std::mutex> lock(s_data->uploadMutex);
+					if(s_data->uploads.empty())
+						break;
+					asset = s_data->uploads.front();
+				}
+
+				size_t sliceBytes = AssetPipeline::GetNextUploadSize(*asset);
+				if(bytes > 0 && bytes + sliceBytes > byteBudget)
+					break;
+				bytes += sliceBytes;
+
+				bool done = AssetPipeline::Upload(*asset);
+				if(done)
+				{
+					{
+						std::lock_guard<std::mutex> lock(s_data->uploadMutex);
+						s_data->uploads.pop_front();
+					}
+					s_data->loaded.fetch_add(1, std::memory_order_relaxed);
+
+					// Last access, the main thread may release the asset from here on
+					AssetPipeline::SetState(*asset, Asset::State::Ready);
+				}
+
+				elapsed = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+			}
+
+			s_data->uploadTime.store(elapsed, std::memory_order_relaxed);
+			s_data->uploadBytes.store(bytes, std::memory_order_relaxed);
+		}
+
+		// Before Init, e.g. in tools without a frame loop
+		void LoadSynchronously(std::shared_ptr<Asset> asset)
+		{
+			JJ_PROFILE_SCOPE("AssetManager::LoadSynchronously");
+
+			MappedFile file(asset->GetPath());
+			std::span<const std::byte> contents = file.GetData();
+			std::vector<std::byte> data(contents.begin(), contents.end());
+
+			if(!file.IsOpen() || !AssetPipeline::Decode(*asset, data))
+			{
+				std::cout << "Error: Failed to load asset " << asset->GetPath() << "\n";
+				AssetPipeline::SetState(*asset, Asset::State::Failed);
+				return;
+			}
+
+			RenderThread::Submit([asset]()
+			{
+				while(!AssetPipeline::Upload(*asset)) {}
+				AssetPipeline::SetState(*asset, Asset::State::Ready);
+			});
+		}
+	}
+
+	void AssetManager::Init(JobSystem* jobSystem, uint32_t ioThreads)
+	{
+		s_data = new AssetManagerData();
+
+		// The main thread is worker 0 and only runs jobs while it waits, which it never does for
+		// assets. With no other workers decode jobs would never start, so decode on the I/O threads.
+		if(jobSystem != nullptr && jobSystem->GetWorkerCount() > 1)
+			s_data->jobSystem = jobSystem;
+
+#if JJ_ASSET_IO_URING
+		// Unavailable on old kernels and often blocked in containers
+		if(std::unique_ptr<UringReader> reader = UringReader::Create())
+		{
+			s_data->reader = std::move(reader);
+			s_data->backend = IoBackend::IoUring;
+			return;
+		}
+#endif
+
+		s_data->reader = std::make_unique<ThreadPoolReader>(ioThreads);
+		s_data->backend = IoBackend::ThreadPool;
+	}
+
+	void AssetManager::Shutdown()
+	{
+		if(s_data == nullptr)
+			return;
+
+		// Reads still queued are dropped, their assets stay in the loading state
+		s_data->reader.reset();
+		if(s_data->jobSystem != nullptr)
+			s_data->jobSystem->Wait(s_data->decodeCounter);
+
+		delete s_data;
+		s_data = nullptr;
+	}
+
+	std::shared_ptr<Asset> AssetManager::Find(const std::string& path)
+	{
+		if(s_data == nullptr)
+			return nullptr;
+
+		auto it = s_data->assets.find(path);
+		return it != s_data->assets.end() ? it->second.lock() : nullptr;
+	}
+
+	void AssetManager::Enqueue(std::shared_ptr<Asset> asset, const std::string& path)
+	{
+		AssetPipeline::SetPath(*asset, path);
+
+		if(s_data == nullptr)
+		{
+			LoadSynchronously(std::move(asset));
+			return;
+		}
+
+		s_data->assets[path] = asset;
+
+		ReadRequest* request = new ReadRequest();
+		request->asset = asset.get();
+		request->path = path;
+		s_data->loading.push_back(std::move(asset));
+
+		std::string normalized = std::filesystem::path(path).lexically_normal().generic_string();
+		for(auto it = s_data->packs.rbegin(); it != s_data->packs.rend(); ++it)
+		{
+			if(!normalized.starts_with(it->mountPoint))
+				continue;
+
+			const PackFile* pack = it->pack.get();
+			const PackFile::Entry* entry = pack->Find(std::string_view(normalized).substr(it->mountPoint.size()));
+			if(entry == nullptr)
+				continue;
+
+			// Entries live until Shutdown, so requests may keep pointers to them. Without a job system
+			// the I/O threads copy the entry, so decoding stays off the main thread either way.
+			request->pack = pack;
+			request->packEntry = entry;
+			s_data->packLoads++;
+			pack->Prefetch(*entry);
+			if(s_data->jobSystem != nullptr)
+			{
+				s_data->jobSystem->Run([request]() { ReadFromPack(request); }, &s_data->decodeCounter);
+				return;
+			}
+			break;
+		}
+
+		s_data->reader->Read(request);
+	}
+
+	bool AssetManager::Mount(const std::string& packPath, const std::string& mountPoint)
+	{
+		if(s_data == nullptr)
+			return false;
+
+		auto pack = std::make_unique<PackFile>();
+		if(!pack->Open(packPath))
+			return false;
+
+		std::string normalized = mountPoint.empty() ? std::string() : std::filesystem::path(mountPoint).lexically_normal().generic_string();
+		if(!normalized.empty() && normalized.back() != '/')
+			normalized += '/';
+
+		s_data->packs.push_back({ std::move(pack), std::move(normalized) });
+		return true;
+	}
+
+	void AssetManager::Update()
+	{
+		if(s_data == nullptr)
+			return;
+
+		JJ_PROFILE_FUNCTION();
+
+		// The pipeline's references are dropped here so assets are always destroyed on the main thread
+		std::erase_if(s_data->loading, [](const std::shared_ptr<Asset>& asset) { return asset->GetState() != Asset::State::Loading; });
+		if(s_data->loading.empty())
+		{
+			std::erase_if(s_data->assets, [](const auto& entry) { return entry.second.expired(); });
+			return;
+		}
+
+		bool uploadsQueued;
+		{
+			std::lock_guard<std::mutex> lock(s_data->uploadMutex);
+			uploadsQueued = !s_data->uploads.empty();
+		}
+
+		if(uploadsQueued)
+			RenderThread::Submit([budget = s_data->uploadBudget, byteBudget = s_data->uploadByteBudget]() { ProcessUploads(budget, byteBudget); });
+	}
+
+	void AssetManager::SetUploadBudget(double milliseconds)
+	{
+		if(s_data != nullptr)
+			s_data->uploadBudget = milliseconds;
+	}
+
+	double AssetManager::GetUploadBudget()
+	{
+		return s_data != nullptr ? s_data->uploadBudget : 0.0;
+	}
+
+	void AssetManager::SetUploadByteBudget(size_t bytes)
+	{
+		if(s_data != nullptr)
+			s_data->uploadByteBudget = bytes;
+	}
+
+	size_t AssetManager::GetUploadByteBudget()
+	{
+		return s_data != nullptr ? s_data->uploadByteBudget : 0;
+	}
+
+	AssetManager::IoBackend AssetManager::GetIoBackend()
+	{
+		return s_data != nullptr ? s_data->backend : IoBackend::None;
+	}
+
+	AssetManager::Statistics AssetManager::GetStats()
+	{
+		Statistics stats;
+		if(s_data == nullptr)
+			return stats;
+
+		stats.pending = (uint32_t)s_data->loading.size();
+		stats.loaded = s_data->loaded.load(std::memory_order_relaxed);
+		stats.failed = s_data->failed.load(std::memory_order_relaxed);
+		stats.packLoads = s_data->packLoads;
+		stats.bytesRead = s_data->bytesRead.load(std::memory_order_relaxed);
+		stats.uploadTime = s_data->uploadTime.load(std::memory_order_relaxed);
+		stats.uploadBytes = s_data->uploadBytes.load(std::memory_order_relaxed);
+		return stats;
+	}
+
+	BufferAsset::~BufferAsset()
+	{
+		if(m_buffer != 0)
+			RenderThread::Submit([buffer = m_buffer]() { GLState::DeleteBuffer(buffer); });
+	}
+
+	bool BufferAsset::Decode(std::vector<std::byte>& data)
+	{
+		if(data.empty())
+			return false;
+
+		m_size = data.size();
+		m_data = std::move(data);
+		return true;
+	}
+
+	bool BufferAsset::Upload()
+	{
+		if(m_buffer == 0)
+		{
+			glCreateBuffers(1, &m_buffer);
+			glNamedBufferStorage(m_buffer, (GLsizeiptr)m_size, nullptr, GL_DYNAMIC_STORAGE_BIT);
+		}
+
+		size_t slice = std::min(UploadSliceSize, m_size - m_uploaded);
+		glNamedBufferSubData(m_buffer, (GLintptr)m_uploaded, (GLsizeiptr)slice, m_data.data() + m_uploaded);
+		m_uploaded += slice;
+
+		if(m_uploaded < m_size)
+			return false;
+
+		m_data = {};
+		return true;
+	}
+
+	size_t BufferAsset::GetNextUploadSize() const
+	{
+		return std::min(UploadSliceSize, m_size - m_uploaded);
+	}
+}
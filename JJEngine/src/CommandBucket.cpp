@@ -0,0 +1,196 @@
+#include <new>
+#include <algorithm>
+#include <glm/gtc/type_ptr.hpp>
+
+#include "JJEngine/CommandBucket.h"
+#include "JJEngine/RenderThread.h"
+#include "JJEngine/Profiler.h"
+#include "JJEngine/GLState.h"
+
+namespace JJEngine {
+	namespace {
+		enum BindFlags : uint32_t {
+			BindShader = 1 << 0,
+			BindVertexArray = 1 << 1,
+			BindMaterial = 1 << 2,
+		};
+
+		struct DispatchedDraw {
+			CommandBucket::Draw draw;
+			uint32_t flags;
+		};
+
+		size_t GetIndexSize(GLenum indexType)
+		{
+			switch(indexType)
+			{
+			case GL_UNSIGNED_BYTE: return 1;
+			case GL_UNSIGNED_SHORT: return 2;
+			default: return 4;
+			}
+		}
+
+		void Execute(const DispatchedDraw* draws, uint32_t count)
+		{
+			JJ_PROFILE_SCOPE("CommandBucket::Execute");
+
+			// Looked up once per shader change, -1 when the shader has no such uniform
+			GLint modelLocation = -1;
+			GLint colorLocation = -1;
+			// Last transform uploaded to the bound program, uniforms are per program so a shader change forgets it
+			const glm::mat4* uploadedTransform = nullptr;
+
+			for(uint32_t i = 0; i < count; i++)
+			{
+				const CommandBucket::Draw& draw = draws[i].draw;
+				uint32_t flags = draws[i].flags;
+
+				if(flags & BindShader)
+				{
+					draw.shader->Use();
+					modelLocation = draw.shader->GetUniformLocation("uModel");
+					colorLocation = draw.shader->GetUniformLocation("uColor");
+					uploadedTransform = nullptr;
+				}
+
+				if(flags & BindVertexArray)
+					GLState::BindVertexArray(draw.vertexArray);
+
+				if((flags & BindMaterial) && draw.material != nullptr)
+				{
+					if(draw.material->textureCount > 0)
+						GLState::BindTextures(0, draw.material->textureCount, draw.material->textures.data());
+					if(colorLocation != -1)
+						glUniform4fv(colorLocation, 1, glm::value_ptr(draw.material->color));
+				}
+
+				if(modelLocation != -1 && (uploadedTransform == nullptr || *uploadedTransform != draw.transform))
+				{
+					glUniformMatrix4fv(modelLocation, 1, GL_FALSE, glm::value_ptr(draw.transform));
+					uploadedTransform = &draw.transform;
+				}
+
+				if(draw.indexType == GL_NONE)
+				{
+					glDrawArraysInstanced(draw.mode, draw.first, draw.count, draw.instanceCount);
+				}
+				else
+				{
+					const void* offset = (const void*)(draw.first * GetIndexSize(draw.indexType));
+					glDrawElementsInstancedBaseVertex(draw.mode, draw.count, draw.indexType, offset, draw.instanceCount, draw.baseVertex);
+				}
+			}
+		}
+	}
+
+	uint64_t CommandBucket::MakeKey(uint8_t layer, uint16_t shader, uint16_t material, float depth, bool backToFront)
+	{
+		constexpr uint32_t DepthMax = (1 << 24) - 1;
+
+		uint32_t depthBits = (uint32_t)(std::clamp(depth, 0.0f, 1.0f) * DepthMax);
+		if(backToFront)
+			depthBits = DepthMax - depthBits;
+
+		return ((uint64_t)layer << 56) | ((uint64_t)shader << 40) | ((uint64_t)material << 24) | depthBits;
+	}
+
+	uint64_t CommandBucket::MakeKey(uint8_t layer, const Shader& shader, const Material* material, float depth, bool backToFront)
+	{
+		return MakeKey(layer, (uint16_t)shader.GetRendererID(), material != nullptr ? material->id : 0, depth, backToFront);
+	}
+
+	CommandBucket::CommandBucket(uint32_t reserve)
+	{
+		m_draws.reserve(reserve);
+		m_entries.reserve(reserve);
+		m_scratch.reserve(reserve);
+	}
+
+	void CommandBucket::Submit(uint64_t key, const Draw& draw)
+	{
+		m_entries.push_back({ key, (uint32_t)m_draws.size() });
+		m_draws.push_back(draw);
+	}
+
+	void CommandBucket::Dispatch()
+	{
+		JJ_PROFILE_FUNCTION();
+
+		m_stats = Statistics();
+		if(m_draws.empty())
+			return;
+
+		Sort();
+
+		uint32_t count = (uint32_t)m_entries.size();
+		DispatchedDraw* draws = (DispatchedDraw*)RenderThread::Allocate(count * sizeof(DispatchedDraw), alignof(DispatchedDraw));
+
+		// Binds are decided here rather than at execution so the statistics are known on this thread
+		const Draw* previous = nullptr;
+		for(uint32_t i = 0; i < count; i++)
+		{
+			const Draw& draw = m_draws[m_entries[i].index];
+
+			uint32_t flags = 0;
+			if(previous == nullptr || previous->shader != draw.shader)
+				flags |= BindShader;
+			if(previous == nullptr || previous->vertexArray != draw.vertexArray)
+				flags |= BindVertexArray;
+			// Uniforms belong to the program, so a new shader needs the material again
+			if(previous == nullptr || previous->material != draw.material || (flags & BindShader))
+				flags |= BindMaterial;
+
+			new (&draws[i]) DispatchedDraw{ draw, flags };
+
+			uint32_t changes = ((flags & BindShader) ? 1 : 0) + ((flags & BindVertexArray) ? 1 : 0) + ((flags & BindMaterial) ? 1 : 0);
+			m_stats.stateChanges += changes;
+			m_stats.stateChangesAvoided += 3 - changes;
+			previous = &draw;
+		}
+		m_stats.draws = count;
+
+		RenderThread::Submit([draws, count]() { Execute(draws, count); });
+
+		m_draws.clear();
+		m_entries.clear();
+	}
+
+	// LSD radix sort, 8 bits per pass. Passes where every key has the same digit are skipped,
+	// which is most of them when only a few layers and shaders are in use.
+	void CommandBucket::Sort()
+	{
+		JJ_PROFILE_FUNCTION();
+
+		size_t count = m_entries.size();
+		m_scratch.resize(count);
+
+		SortEntry* source = m_entries.data();
+		SortEntry* destination = m_scratch.data();
+
+		for(uint32_t shift = 0; shift < 64; shift += 8)
+		{
+			uint32_t histogram[256] = {};
+			for(size_t i = 0; i < count; i++)
+				histogram[(source[i].key >> shift) & 0xFF]++;
+
+			if(histogram[(source[0].key >> shift) & 0xFF] == count)
+				continue;
+
+			uint32_t offset = 0;
+			for(uint32_t& bucket : histogram)
+			{
+				uint32_t size = bucket;
+				bucket = offset;
+				offset += size;
+			}
+
+			for(size_t i = 0; i < count; i++)
+				destination[histogram[(source[i].key >> shift) & 0xFF]++] = source[i];
+
+			std::swap(source, destination);
+		}
+
+		if(source != m_entries.data())
+			std::copy(source, source + count, m_entries.data());
+	}
+}
@@ -0,0 +1,338 @@
+#include <bit>
+#include <array>
+#include <cmath>
+#include <cfloat>
+#include <chrono>
+#include <cstring>
+#include <algorithm>
+
+#include "JJEngine/CpuCulling.h"
+#include "JJEngine/Profiler.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define JJ_CULLING_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+#else
+#define JJ_CULLING_X86 0
+#endif
+
+// GCC and Clang only emit AVX2 and SSE4.1 instructions in functions marked for them,
+// MSVC allows the intrinsics anywhere so nothing else has to be built with those flags
+#if defined(_MSC_VER) && !defined(__clang__)
+#define JJ_TARGET(isa)
+#else
+#define JJ_TARGET(isa) __attribute__((target(isa)))
+#endif
+
+namespace JJEngine {
+	namespace {
+		// Smaller batches aren't worth a job
+		constexpr uint32_t MinBatchSize = 2048;
+
+		struct BoundsView {
+			const float* centerX;
+			const float* centerY;
+			const float* centerZ;
+			const float* radius;
+			const float* extentX;
+			const float* extentY;
+			const float* extentZ;
+		};
+
+		// Plane normals with their absolute values, which project the box extents onto the normal
+		struct CullPlane {
+			float x, y, z, w;
+			float absX, absY, absZ;
+		};
+
+		using CullPlanes = std::array<CullPlane, 6>;
+
+		CullPlanes MakeCullPlanes(const Frustum& frustum)
+		{
+			CullPlanes planes;
+			for(size_t i = 0; i < planes.size(); i++)
+			{
+				const glm::vec4& plane = frustum.planes[i];
+				planes[i] = { plane.x, plane.y, plane.z, plane.w, std::abs(plane.x), std::abs(plane.y), std::abs(plane.z) };
+			}
+			return planes;
+		}
+
+		uint32_t CullScalar(const BoundsView& bounds, const CullPlanes& planes, uint32_t begin, uint32_t end, uint32_t* output)
+		{
+			uint32_t count = 0;
+			for(uint32_t i = begin; i < end; i++)
+			{
+				bool visible = true;
+				for(const CullPlane& plane : planes)
+				{
+					float distance = plane.x * bounds.centerX[i] + plane.y * bounds.centerY[i] + plane.z * bounds.centerZ[i] + plane.w;
+					float extent = bounds.radius[i] + plane.absX * bounds.extentX[i] + plane.absY * bounds.extentY[i] + plane.absZ * bounds.extentZ[i];
+					if(distance + extent < 0.0f)
+					{
+						visible = false;
+						break;
+					}
+				}
+
+				if(visible)
+					output[count++] = i;
+			}
+			return count;
+		}
+
+#if JJ_CULLING_X86
+		// Writes begin + the index of every set bit, lowest first
+		inline uint32_t WriteVisible(uint32_t mask, uint32_t begin, uint32_t* output)
+		{
+			uint32_t count = 0;
+			while(mask != 0)
+			{
+				output[count++] = begin + (uint32_t)std::countr_zero(mask);
+				mask &= mask - 1;
+			}
+			return count;
+		}
+
+		// Ranges start on a multiple of the lane count and padding lanes are always culled,
+		// so both vector paths may read past end up to the next multiple
+		JJ_TARGET("sse4.1")
+		uint32_t CullSSE4(const BoundsView& bounds, const CullPlanes& planes, uint32_t begin, uint32_t end, uint32_t* output)
+		{
+			uint32_t count = 0;
+			for(uint32_t i = begin; i < end; i += 4)
+			{
+				__m128 centerX = _mm_loadu_ps(bounds.centerX + i);
+				__m128 centerY = _mm_loadu_ps(bounds.centerY + i);
+				__m128 centerZ = _mm_loadu_ps(bounds.centerZ + i);
+				__m128 radius = _mm_loadu_ps(bounds.radius + i);
+				__m128 extentX = _mm_loadu_ps(bounds.extentX + i);
+				__m128 extentY = _mm_loadu_ps(bounds.extentY + i);
+				__m128 extentZ = _mm_loadu_ps(bounds.extentZ + i);
+
+				__m128 outside = _mm_setzero_ps();
+				for(const CullPlane& plane : planes)
+				{
+					__m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane.x), centerX), _mm_mul_ps(_mm_set1_ps(plane.y), centerY)),
+						_mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane.z), centerZ), _mm_set1_ps(plane.w)));
+					__m128 extent = _mm_add_ps(_mm_add_ps(radius, _mm_mul_ps(_mm_set1_ps(plane.absX), extentX)),
+						_mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane.absY), extentY), _mm_mul_ps(_mm_set1_ps(plane.absZ), extentZ)));
+					outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(distance, extent), _mm_setzero_ps()));
+				}
+
+				uint32_t visible = ~(uint32_t)_mm_movemask_ps(outside) & 0xF;
+				count += WriteVisible(visible, i, output + count);
+			}
+			return count;
+		}
+
+		JJ_TARGET("avx2")
+		uint32_t CullAVX2(const BoundsView& bounds, const CullPlanes& planes, uint32_t begin, uint32_t end, uint32_t* output)
+		{
+			uint32_t count = 0;
+			for(uint32_t i = begin; i < end; i += 8)
+			{
+				__m256 centerX = _mm256_loadu_ps(bounds.centerX + i);
+				__m256 centerY = _mm256_loadu_ps(bounds.centerY + i);
+				__m256 centerZ = _mm256_loadu_ps(bounds.centerZ + i);
+				__m256 radius = _mm256_loadu_ps(bounds.radius + i);
+				__m256 extentX = _mm256_loadu_ps(bounds.extentX + i);
+				__m256 extentY = _mm256_loadu_ps(bounds.extentY + i);
+				__m256 extentZ = _mm256_loadu_ps(bounds.extentZ + i);
+
+				__m256 outside = _mm256_setzero_ps();
+				for(const CullPlane& plane : planes)
+				{
+					__m256 distance = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(plane.x), centerX), _mm256_mul_ps(_mm256_set1_ps(plane.y), centerY)),
+						_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(plane.z), centerZ), _mm256_set1_ps(plane.w)));
+					__m256 extent = _mm256_add_ps(_mm256_add_ps(radius, _mm256_mul_ps(_mm256_set1_ps(plane.absX), extentX)),
+						_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(plane.absY), extentY), _mm256_mul_ps(_mm256_set1_ps(plane.absZ), extentZ)));
+					outside = _mm256_or_ps(outside, _mm256_cmp_ps(_mm256_add_ps(distance, extent), _mm256_setzero_ps(), _CMP_LT_OQ));
+				}
+
+				uint32_t visible = ~(uint32_t)_mm256_movemask_ps(outside) & 0xFF;
+				count += WriteVisible(visible, i, output + count);
+			}
+			return count;
+		}
+#endif
+
+		CpuCuller::Path DetectPath()
+		{
+#if JJ_CULLING_X86
+#if defined(_MSC_VER) && !defined(__clang__)
+			int info[4];
+			__cpuid(info, 0);
+			int maxLeaf = info[0];
+
+			__cpuid(info, 1);
+			bool sse41 = (info[2] & (1 << 19)) != 0;
+			bool osxsave = (info[2] & (1 << 27)) != 0;
+			bool avx = (info[2] & (1 << 28)) != 0;
+
+			bool avx2 = false;
+			if(maxLeaf >= 7 && osxsave && avx)
+			{
+				__cpuidex(info, 7, 0);
+				// The OS also has to save the upper halves of the YMM registers
+				avx2 = (info[1] & (1 << 5)) != 0 && (_xgetbv(0) & 6) == 6;
+			}
+#else
+			__builtin_cpu_init();
+			bool sse41 = __builtin_cpu_supports("sse4.1");
+			bool avx2 = __builtin_cpu_supports("avx2");
+#endif
+			if(avx2)
+				return CpuCuller::Path::AVX2;
+			if(sse41)
+				return CpuCuller::Path::SSE4;
+#endif
+			return CpuCuller::Path::Scalar;
+		}
+	}
+
+	CpuCuller::CpuCuller() : m_path(GetSupportedPath())
+	{
+	}
+
+	CpuCuller::Path CpuCuller::GetSupportedPath()
+	{
+		static const Path path = DetectPath();
+		return path;
+	}
+
+	void CpuCuller::SetPath(Path path)
+	{
+		m_path = std::min(path, GetSupportedPath());
+	}
+
+	uint32_t CpuCuller::AddSphere(const glm::vec3& center, float radius)
+	{
+		uint32_t index = Allocate();
+		Set(index, center, radius, glm::vec3(0.0f));
+		return index;
+	}
+
+	uint32_t CpuCuller::AddBox(const glm::vec3& min, const glm::vec3& max)
+	{
+		uint32_t index = Allocate();
+		SetBox(index, min, max);
+		return index;
+	}
+
+	void CpuCuller::SetSphere(uint32_t index, const glm::vec3& center, float radius)
+	{
+		Set(index, center, radius, glm::vec3(0.0f));
+	}
+
+	void CpuCuller::SetBox(uint32_t index, const glm::vec3& min, const glm::vec3& max)
+	{
+		Set(index, (min + max) * 0.5f, 0.0f, (max - min) * 0.5f);
+	}
+
+	void CpuCuller::Set(uint32_t index, const glm::vec3& center, float radius, const glm::vec3& extents)
+	{
+		m_centerX[index] = center.x;
+		m_centerY[index] = center.y;
+		m_centerZ[index] = center.z;
+		m_radius[index] = radius;
+		m_extentX[index] = extents.x;
+		m_extentY[index] = extents.y;
+		m_extentZ[index] = extents.z;
+	}
+
+	uint32_t CpuCuller::Allocate()
+	{
+		// Grow a whole vector at a time, padding has a radius no plane can pass
+		if(m_count == m_radius.size())
+		{
+			size_t size = m_radius.size() + Width;
+			for(std::vector<float>* component : { &m_centerX, &m_centerY, &m_centerZ, &m_extentX, &m_extentY, &m_extentZ })
+				component->resize(size, 0.0f);
+			m_radius.resize(size, -FLT_MAX);
+		}
+		return m_count++;
+	}
+
+	void CpuCuller::Reserve(uint32_t objectCount)
+	{
+		size_t size = (objectCount + Width - 1) / Width * Width;
+		for(std::vector<float>* component : { &m_centerX, &m_centerY, &m_centerZ, &m_radius, &m_extentX, &m_extentY, &m_extentZ })
+			component->reserve(size);
+		m_visible.reserve(size);
+	}
+
+	void CpuCuller::Clear()
+	{
+		for(std::vector<float>* component : { &m_centerX, &m_centerY, &m_centerZ, &m_radius, &m_extentX, &m_extentY, &m_extentZ })
+			component->clear();
+		m_count = 0;
+	}
+
+	uint32_t CpuCuller::CullRange(const Frustum& frustum, uint32_t begin, uint32_t end, uint32_t* output) const
+	{
+		BoundsView bounds = { m_centerX.data(), m_centerY.data(), m_centerZ.data(), m_radius.data(), m_extentX.data(), m_extentY.data(), m_extentZ.data() };
+		CullPlanes planes = MakeCullPlanes(frustum);
+
+		switch(m_path)
+		{
+#if JJ_CULLING_X86
+		case Path::AVX2: return CullAVX2(bounds, planes, begin, end, output);
+		case Path::SSE4: return CullSSE4(bounds, planes, begin, end, output);
+#endif
+		default: return CullScalar(bounds, planes, begin, end, output);
+		}
+	}
+
+	const std::vector<uint32_t>& CpuCuller::Cull(const Frustum& frustum, JobSystem* jobSystem)
+	{
+		JJ_PROFILE_FUNCTION();
+
+		auto start = std::chrono::high_resolution_clock::now();
+
+		// Every object could be visible, batches write into their own slice of this
+		m_visible.resize(m_count);
+
+		uint32_t batchSize = m_count;
+		if(jobSystem != nullptr && jobSystem->GetWorkerCount() > 1 && m_count > MinBatchSize)
+		{
+			batchSize = std::max(MinBatchSize, m_count / (jobSystem->GetWorkerCount() * 4));
+			batchSize = (batchSize + Width - 1) / Width * Width;
+		}
+
+		uint32_t visibleCount = 0;
+		if(batchSize >= m_count)
+		{
+			visibleCount = CullRange(frustum, 0, m_count, m_visible.data());
+		}
+		else
+		{
+			m_batchCounts.assign((m_count + batchSize - 1) / batchSize, 0);
+			jobSystem->ParallelFor(m_count, batchSize, [this, &frustum, batchSize](uint32_t begin, uint32_t end)
+			{
+				m_batchCounts[begin / batchSize] = CullRange(frustum, begin, end, m_visible.data() + begin);
+			});
+
+			// Slices move down into one list, each only ever moves towards the front
+			for(uint32_t batch = 0; batch < m_batchCounts.size(); batch++)
+			{
+				uint32_t* source = m_visible.data() + batch * batchSize;
+				std::memmove(m_visible.data() + visibleCount, source, m_batchCounts[batch] * sizeof(uint32_t));
+				visibleCount += m_batchCounts[batch];
+			}
+		}
+		m_visible.resize(visibleCount);
+
+		auto end = std::chrono::high_resolution_clock::now();
+
+		m_stats.objects = m_count;
+		m_stats.visible = visibleCount;
+		m_stats.cullTime = std::chrono::duration<double, std::milli>(end - start).count();
+		m_stats.objectsPerMicrosecond = m_stats.cullTime > 0.0 ? m_count / (m_stats.cullTime * 1000.0) : 0.0;
+		m_stats.path = m_path;
+		return m_visible;
+	}
+}
@@ -0,0 +1,159 @@
+#include <algorithm>
+#include <iostream>
+
+#include "JJEngine/FileWatcher.h"
+#include "JJEngine/Profiler.h"
+
+#if defined(__linux__)
+#include <unistd.h>
+#include <sys/inotify.h>
+#define JJ_FILE_WATCHER_INOTIFY 1
+#else
+#define JJ_FILE_WATCHER_INOTIFY 0
+#endif
+
+namespace JJEngine {
+	namespace {
+		std::filesystem::file_time_type GetLastWriteTime(const std::filesystem::path& path)
+		{
+			std::error_code error;
+			std::filesystem::file_time_type time = std::filesystem::last_write_time(path, error);
+			return error ? std::filesystem::file_time_type::min() : time;
+		}
+
+		void AddUnique(std::vector<std::string>& paths, const std::string& path)
+		{
+			if(std::find(paths.begin(), paths.end(), path) == paths.end())
+				paths.push_back(path);
+		}
+	}
+
+	FileWatcher::FileWatcher()
+	{
+#if JJ_FILE_WATCHER_INOTIFY
+		m_notifyHandle = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+		if(m_notifyHandle < 0)
+			std::cout << "Warning: inotify unavailable, watching files by polling\n";
+#endif
+	}
+
+	FileWatcher::~FileWatcher()
+	{
+#if JJ_FILE_WATCHER_INOTIFY
+		if(m_notifyHandle >= 0)
+			close(m_notifyHandle);
+#endif
+	}
+
+	void FileWatcher::Watch(const std::string& path)
+	{
+		auto it = std::find_if(m_files.begin(), m_files.end(), [&](const WatchedFile& file) { return file.path == path; });
+		if(it != m_files.end())
+			return;
+
+		std::filesystem::path absolutePath = std::filesystem::absolute(path).lexically_normal();
+		m_files.push_back({ path, absolutePath, GetLastWriteTime(absolutePath) });
+
+#if JJ_FILE_WATCHER_INOTIFY
+		if(m_notifyHandle < 0)
+			return;
+
+		std::filesystem::path directory = absolutePath.parent_path();
+		bool watched = std::any_of(m_directories.begin(), m_directories.end(), [&](const WatchedDirectory& entry) { return entry.path == directory; });
+		if(watched)
+			return;
+
+		int handle = inotify_add_watch(m_notifyHandle, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+		if(handle < 0)
+		{
+			std::cout << "Warning: Failed to watch " << directory << ", falling back to polling\n";
+			close(m_notifyHandle);
+			m_notifyHandle = -1;
+			m_directories.clear();
+			return;
+		}
+		m_directories.push_back({ handle, directory });
+#endif
+	}
+
+	void FileWatcher::Unwatch(const std::string& path)
+	{
+		// Directory watches stay, events for files nobody watches are ignored
+		std::erase_if(m_files, [&](const WatchedFile& file) { return file.path == path; });
+	}
+
+	std::vector<std::string> FileWatcher::Poll()
+	{
+		std::vector<std::string> changed;
+		if(m_files.empty())
+			return changed;
+
+		if(m_notifyHandle >= 0)
+			PollNotifications(changed);
+		else
+			PollTimestamps(changed);
+
+		return changed;
+	}
+
+	void FileWatcher::PollNotifications(std::vector<std::string>& changed)
+	{
+#if JJ_FILE_WATCHER_INOTIFY
+		alignas(inotify_event) char buffer[4096];
+		for(;;)
+		{
+			ssize_t length = read(m_notifyHandle, buffer, sizeof(buffer));
+			if(length <= 0)
+				break;
+
+			for(ssize_t offset = 0; offset < length;)
+			{
+				const inotify_event* event = (const inotify_event*)(buffer + offset);
+				offset += sizeof(inotify_event) + event->len;
+
+				// Events were dropped, anything may have changed
+				if(event->mask & IN_Q_OVERFLOW)
+				{
+					for(const WatchedFile& file : m_files)
+						AddUnique(changed, file.path);
+					continue;
+				}
+
+				if(event->len == 0)
+					continue;
+
+				auto directory = std::find_if(m_directories.begin(), m_directories.end(), [&](const WatchedDirectory& entry) { return entry.handle == event->wd; });
+				if(directory == m_directories.end())
+					continue;
+
+				std::filesystem::path path = directory->path / event->name;
+				for(const WatchedFile& file : m_files)
+				{
+					if(file.absolutePath == path)
+						AddUnique(changed, file.path);
+				}
+			}
+		}
+#endif
+	}
+
+	void FileWatcher::PollTimestamps(std::vector<std::string>& changed)
+	{
+		auto now = std::chrono::steady_clock::now();
+		if(now - m_lastPoll < PollInterval)
+			return;
+		m_lastPoll = now;
+
+		JJ_PROFILE_FUNCTION();
+
+		for(WatchedFile& file : m_files)
+		{
+			std::filesystem::file_time_type lastWrite = GetLastWriteTime(file.absolutePath);
+			if(lastWrite != file.lastWrite)
+			{
+				file.lastWrite = lastWrite;
+				AddUnique(changed, file.path);
+			}
+		}
+	}
+}
@@ -0,0 +1,78 @@
+#include <cmath>
+#include <algorithm>
+
+#include "JJEngine/FrameStats.h"
+
+namespace JJEngine {
+	void FrameStats::AddFrame(double milliseconds)
+	{
+		if(m_count == SampleCount)
+		{
+			double evicted = m_samples[m_next];
+			m_total -= evicted;
+			m_histogram[GetBucket(evicted)]--;
+		}
+		else
+		{
+			m_count++;
+		}
+
+		m_samples[m_next] = milliseconds;
+		m_next = (m_next + 1) % SampleCount;
+		m_total += milliseconds;
+		m_histogram[GetBucket(milliseconds)]++;
+	}
+
+	void FrameStats::Reset()
+	{
+		*this = FrameStats();
+	}
+
+	double FrameStats::GetLast() const
+	{
+		if(m_count == 0)
+			return 0.0;
+		return m_samples[(m_next + SampleCount - 1) % SampleCount];
+	}
+
+	double FrameStats::GetMin() const
+	{
+		if(m_count == 0)
+			return 0.0;
+		return *std::min_element(m_samples.begin(), m_samples.begin() + m_count);
+	}
+
+	double FrameStats::GetMax() const
+	{
+		if(m_count == 0)
+			return 0.0;
+		return *std::max_element(m_samples.begin(), m_samples.begin() + m_count);
+	}
+
+	double FrameStats::GetAverage() const
+	{
+		if(m_count == 0)
+			return 0.0;
+		return m_total / m_count;
+	}
+
+	double FrameStats::GetPercentile(double percentile) const
+	{
+		if(m_count == 0)
+			return 0.0;
+
+		std::array<double, SampleCount> sorted = m_samples;
+		size_t index = (size_t)std::ceil(percentile / 100.0 * m_count);
+		index = std::clamp<size_t>(index, 1, m_count) - 1;
+
+		std::nth_element(sorted.begin(), sorted.begin() + index, sorted.begin() + m_count);
+		return sorted[index];
+	}
+
+	size_t FrameStats::GetBucket(double milliseconds)
+	{
+		if(milliseconds <= 0.0)
+			return 0;
+		return std::min((size_t)(milliseconds / HistogramBucketWidth), HistogramBucketCount - 1);
+	}
+}
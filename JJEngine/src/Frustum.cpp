@@ -0,0 +1,31 @@
+#include "JJEngine/Frustum.h"
+
+namespace JJEngine {
+	Frustum Frustum::FromMatrix(const glm::mat4& m)
+	{
+		// Rows of the column-major matrix
+		glm::vec4 row0(m[0][0], m[1][0], m[2][0], m[3][0]);
+		glm::vec4 row1(m[0][1], m[1][1], m[2][1], m[3][1]);
+		glm::vec4 row2(m[0][2], m[1][2], m[2][2], m[3][2]);
+		glm::vec4 row3(m[0][3], m[1][3], m[2][3], m[3][3]);
+
+		Frustum frustum;
+		frustum.planes = { row3 + row0, row3 - row0, row3 + row1, row3 - row1, row3 + row2, row3 - row2 };
+
+		// Normalized so plane distances are in world units and sphere radii can be compared directly
+		for(glm::vec4& plane : frustum.planes)
+			plane /= glm::length(glm::vec3(plane));
+
+		return frustum;
+	}
+
+	bool Frustum::IntersectsSphere(const glm::vec3& center, float radius) const
+	{
+		for(const glm::vec4& plane : planes)
+		{
+			if(glm::dot(glm::vec3(plane), center) + plane.w < -radius)
+				return false;
+		}
+		return true;
+	}
+}
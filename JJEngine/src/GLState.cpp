@@ -0,0 +1,383 @@
+#include <array>
+#include <atomic>
+#include <algorithm>
+
+#include "JJEngine/GLState.h"
+
+namespace JJEngine {
+	namespace {
+		constexpr GLuint Unknown = UINT32_MAX;
+		constexpr GLenum UnknownEnum = UINT32_MAX;
+
+		// Non-indexed buffer targets that are tracked
+		constexpr std::array<GLenum, 10> BufferTargets = {
+			GL_ARRAY_BUFFER, GL_UNIFORM_BUFFER, GL_SHADER_STORAGE_BUFFER, GL_DRAW_INDIRECT_BUFFER, GL_DISPATCH_INDIRECT_BUFFER,
+			GL_PARAMETER_BUFFER, GL_PIXEL_PACK_BUFFER, GL_PIXEL_UNPACK_BUFFER, GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER,
+		};
+
+		struct IndexedBinding {
+			GLuint buffer = Unknown;
+			GLintptr offset = 0;
+			GLsizeiptr size = 0; // 0 for glBindBufferBase
+		};
+
+		// Booleans are kept as int8 so -1 can mean unknown
+		struct GLStateData {
+			GLuint program = Unknown;
+			GLuint vertexArray = Unknown;
+			GLuint drawFramebuffer = Unknown;
+			GLuint readFramebuffer = Unknown;
+
+			std::array<GLuint, BufferTargets.size()> buffers;
+			std::array<IndexedBinding, GLState::MaxIndexedBindings> uniformBuffers;
+			std::array<IndexedBinding, GLState::MaxIndexedBindings> storageBuffers;
+			std::array<GLuint, GLState::MaxTextureUnits> textures;
+
+			int8_t blend = -1;
+			GLenum blendSource = UnknownEnum, blendDestination = UnknownEnum;
+			int8_t depthTest = -1;
+			int8_t depthWrite = -1;
+			GLenum depthFunc = UnknownEnum;
+			int8_t cullFace = -1;
+			GLenum cullMode = UnknownEnum;
+			glm::vec4 clearColor = glm::vec4(-1.0f);
+			bool viewportKnown = false;
+			GLint viewport[4] = {};
+
+			uint32_t issued = 0;
+			uint32_t filtered = 0;
+			std::atomic<uint32_t> lastIssued = 0;
+			std::atomic<uint32_t> lastFiltered = 0;
+
+			GLStateData()
+			{
+				buffers.fill(Unknown);
+				textures.fill(Unknown);
+			}
+		};
+
+		GLStateData s_state;
+
+		// Returns true when the call has to be issued
+		template<typename T>
+		bool Update(T& shadow, const T& value)
+		{
+			if(shadow == value)
+			{
+				s_state.filtered++;
+				return false;
+			}
+
+			shadow = value;
+			s_state.issued++;
+			return true;
+		}
+
+		void Passthrough()
+		{
+			s_state.issued++;
+		}
+
+		GLuint* FindBufferTarget(GLenum target)
+		{
+			auto it = std::find(BufferTargets.begin(), BufferTargets.end(), target);
+			return it != BufferTargets.end() ? &s_state.buffers[it - BufferTargets.begin()] : nullptr;
+		}
+
+		IndexedBinding* FindIndexedBinding(GLenum target, GLuint index)
+		{
+			if(index >= GLState::MaxIndexedBindings)
+				return nullptr;
+
+			if(target == GL_UNIFORM_BUFFER)
+				return &s_state.uniformBuffers[index];
+			if(target == GL_SHADER_STORAGE_BUFFER)
+				return &s_state.storageBuffers[index];
+			return nullptr;
+		}
+
+		void SetCapability(int8_t& shadow, GLenum capability, bool enabled)
+		{
+			if(Update(shadow, (int8_t)enabled))
+			{
+				if(enabled)
+					glEnable(capability);
+				else
+					glDisable(capability);
+			}
+		}
+	}
+
+	void GLState::UseProgram(GLuint program)
+	{
+		if(Update(s_state.program, program))
+			glUseProgram(program);
+	}
+
+	void GLState::BindVertexArray(GLuint vertexArray)
+	{
+		if(Update(s_state.vertexArray, vertexArray))
+			glBindVertexArray(vertexArray);
+	}
+
+	void GLState::BindFramebuffer(GLenum target, GLuint framebuffer)
+	{
+		if(target == GL_FRAMEBUFFER)
+		{
+			if(s_state.drawFramebuffer == framebuffer && s_state.readFramebuffer == framebuffer)
+			{
+				s_state.filtered++;
+				return;
+			}
+
+			s_state.drawFramebuffer = s_state.readFramebuffer = framebuffer;
+			Passthrough();
+			glBindFramebuffer(target, framebuffer);
+			return;
+		}
+
+		GLuint& shadow = target == GL_READ_FRAMEBUFFER ? s_state.readFramebuffer : s_state.drawFramebuffer;
+		if(Update(shadow, framebuffer))
+			glBindFramebuffer(target, framebuffer);
+	}
+
+	void GLState::BindBuffer(GLenum target, GLuint buffer)
+	{
+		GLuint* shadow = FindBufferTarget(target);
+		if(shadow == nullptr)
+		{
+			Passthrough();
+			glBindBuffer(target, buffer);
+			return;
+		}
+
+		if(Update(*shadow, buffer))
+			glBindBuffer(target, buffer);
+	}
+
+	void GLState::BindBufferBase(GLenum target, GLuint index, GLuint buffer)
+	{
+		IndexedBinding* binding = FindIndexedBinding(target, index);
+		if(binding != nullptr && binding->buffer == buffer && binding->size == 0)
+		{
+			s_state.filtered++;
+			return;
+		}
+
+		if(binding != nullptr)
+			*binding = { buffer, 0, 0 };
+
+		// Indexed binds also replace the generic binding of the target
+		if(GLuint* shadow = FindBufferTarget(target))
+			*shadow = buffer;
+
+		Passthrough();
+		glBindBufferBase(target, index, buffer);
+	}
+
+	void GLState::BindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size)
+	{
+		IndexedBinding* binding = FindIndexedBinding(target, index);
+		if(binding != nullptr && binding->buffer == buffer && binding->offset == offset && binding->size == size)
+		{
+			s_state.filtered++;
+			return;
+		}
+
+		if(binding != nullptr)
+			*binding = { buffer, offset, size };
+
+		if(GLuint* shadow = FindBufferTarget(target))
+			*shadow = buffer;
+
+		Passthrough();
+		glBindBufferRange(target, index, buffer, offset, size);
+	}
+
+	void GLState::BindTextureUnit(GLuint unit, GLuint texture)
+	{
+		if(unit >= MaxTextureUnits)
+		{
+			Passthrough();
+			glBindTextureUnit(unit, texture);
+			return;
+		}
+
+		if(Update(s_state.textures[unit], texture))
+			glBindTextureUnit(unit, texture);
+	}
+
+	void GLState::BindTextures(GLuint first, GLsizei count, const GLuint* textures)
+	{
+		if(first + count > MaxTextureUnits)
+		{
+			Passthrough();
+			glBindTextures(first, count, textures);
+			return;
+		}
+
+		if(std::equal(textures, textures + count, s_state.textures.begin() + first))
+		{
+			s_state.filtered++;
+			return;
+		}
+
+		std::copy(textures, textures + count, s_state.textures.begin() + first);
+		Passthrough();
+		glBindTextures(first, count, textures);
+	}
+
+	void GLState::SetBlend(bool enabled)
+	{
+		SetCapability(s_state.blend, GL_BLEND, enabled);
+	}
+
+	void GLState::SetBlendFunc(GLenum source, GLenum destination)
+	{
+		if(s_state.blendSource == source && s_state.blendDestination == destination)
+		{
+			s_state.filtered++;
+			return;
+		}
+
+		s_state.blendSource = source;
+		s_state.blendDestination = destination;
+		Passthrough();
+		glBlendFunc(source, destination);
+	}
+
+	void GLState::SetDepthTest(bool enabled)
+	{
+		SetCapability(s_state.depthTest, GL_DEPTH_TEST, enabled);
+	}
+
+	void GLState::SetDepthWrite(bool enabled)
+	{
+		if(Update(s_state.depthWrite, (int8_t)enabled))
+			glDepthMask(enabled ? GL_TRUE : GL_FALSE);
+	}
+
+	void GLState::SetDepthFunc(GLenum function)
+	{
+		if(Update(s_state.depthFunc, function))
+			glDepthFunc(function);
+	}
+
+	void GLState::SetCullFace(bool enabled)
+	{
+		SetCapability(s_state.cullFace, GL_CULL_FACE, enabled);
+	}
+
+	void GLState::SetCullMode(GLenum mode)
+	{
+		if(Update(s_state.cullMode, mode))
+			glCullFace(mode);
+	}
+
+	void GLState::SetClearColor(const glm::vec4& color)
+	{
+		if(Update(s_state.clearColor, color))
+			glClearColor(color.x, color.y, color.z, color.w);
+	}
+
+	void GLState::SetViewport(GLint x, GLint y, GLsizei width, GLsizei height)
+	{
+		if(s_state.viewportKnown && s_state.viewport[0] == x && s_state.viewport[1] == y && s_state.viewport[2] == width && s_state.viewport[3] == height)
+		{
+			s_state.filtered++;
+			return;
+		}
+
+		s_state.viewportKnown = true;
+		s_state.viewport[0] = x;
+		s_state.viewport[1] = y;
+		s_state.viewport[2] = width;
+		s_state.viewport[3] = height;
+		Passthrough();
+		glViewport(x, y, width, height);
+	}
+
+	void GLState::DeleteProgram(GLuint program)
+	{
+		if(s_state.program == program)
+			s_state.program = Unknown;
+		glDeleteProgram(program);
+	}
+
+	void GLState::DeleteVertexArray(GLuint vertexArray)
+	{
+		if(s_state.vertexArray == vertexArray)
+			s_state.vertexArray = Unknown;
+		glDeleteVertexArrays(1, &vertexArray);
+	}
+
+	void GLState::DeleteFramebuffer(GLuint framebuffer)
+	{
+		// Deleting a bound framebuffer reverts the binding to 0
+		if(s_state.drawFramebuffer == framebuffer)
+			s_state.drawFramebuffer = 0;
+		if(s_state.readFramebuffer == framebuffer)
+			s_state.readFramebuffer = 0;
+		glDeleteFramebuffers(1, &framebuffer);
+	}
+
+	void GLState::DeleteBuffer(GLuint buffer)
+	{
+		std::replace(s_state.buffers.begin(), s_state.buffers.end(), buffer, Unknown);
+		for(IndexedBinding& binding : s_state.uniformBuffers)
+		{
+			if(binding.buffer == buffer)
+				binding.buffer = Unknown;
+		}
+		for(IndexedBinding& binding : s_state.storageBuffers)
+		{
+			if(binding.buffer == buffer)
+				binding.buffer = Unknown;
+		}
+		glDeleteBuffers(1, &buffer);
+	}
+
+	void GLState::DeleteTexture(GLuint texture)
+	{
+		std::replace(s_state.textures.begin(), s_state.textures.end(), texture, Unknown);
+		glDeleteTextures(1, &texture);
+	}
+
+	void GLState::Invalidate()
+	{
+		s_state.program = Unknown;
+		s_state.vertexArray = Unknown;
+		s_state.drawFramebuffer = Unknown;
+		s_state.readFramebuffer = Unknown;
+		s_state.buffers.fill(Unknown);
+		s_state.uniformBuffers.fill(IndexedBinding());
+		s_state.storageBuffers.fill(IndexedBinding());
+		s_state.textures.fill(Unknown);
+
+		s_state.blend = -1;
+		s_state.blendSource = s_state.blendDestination = UnknownEnum;
+		s_state.depthTest = -1;
+		s_state.depthWrite = -1;
+		s_state.depthFunc = UnknownEnum;
+		s_state.cullFace = -1;
+		s_state.cullMode = UnknownEnum;
+		s_state.clearColor = glm::vec4(-1.0f);
+		s_state.viewportKnown = false;
+	}
+
+	void GLState::EndFrame()
+	{
+		s_state.lastIssued.store(s_state.issued, std::memory_order_relaxed);
+		s_state.lastFiltered.store(s_state.filtered, std::memory_order_relaxed);
+		s_state.issued = 0;
+		s_state.filtered = 0;
+	}
+
+	GLState::Statistics GLState::GetStats()
+	{
+		Statistics stats;
+		stats.issued = s_state.lastIssued.load(std::memory_order_relaxed);
+		stats.filtered = s_state.lastFiltered.load(std::memory_order_relaxed);
+		return stats;
+	}
+}
@@ -0,0 +1,367 @@
+#include <array>
+#include <cstring>
+#include <algorithm>
+#include <iostream>
+
+#include <GLFW/glfw3.h>
+
+#include "JJEngine/GpuCulling.h"
+#include "JJEngine/Frustum.h"
+#include "JJEngine/UniformBuffer.h"
+#include "JJEngine/RenderThread.h"
+#include "JJEngine/GLState.h"
+#include "JJEngine/Profiler.h"
+
+namespace JJEngine {
+	namespace {
+		const char* HiZCopySource = R"(#version 450 core
+layout (local_size_x = 8, local_size_y = 8) in;
+
+layout (binding = 0) uniform sampler2D uDepth;
+layout (binding = 0, r32f) writeonly uniform image2D uDestination;
+
+void main()
+{
+	ivec2 texel = ivec2(gl_GlobalInvocationID.xy);
+	if(any(greaterThanEqual(texel, imageSize(uDestination))))
+		return;
+
+	imageStore(uDestination, texel, vec4(texelFetch(uDepth, texel, 0).r));
+}
+)";
+
+		const char* HiZDownsampleSource = R"(#version 450 core
+layout (local_size_x = 8, local_size_y = 8) in;
+
+layout (binding = 0, r32f) readonly uniform image2D uSource;
+layout (binding = 1, r32f) writeonly uniform image2D uDestination;
+
+void main()
+{
+	ivec2 texel = ivec2(gl_GlobalInvocationID.xy);
+	ivec2 destinationSize = imageSize(uDestination);
+	if(any(greaterThanEqual(texel, destinationSize)))
+		return;
+
+	// The last row and column also take the leftover texels of an odd sized source
+	ivec2 sourceSize = imageSize(uSource);
+	ivec2 first = texel * 2;
+	ivec2 last = min(first + 1 + ivec2(equal(texel, destinationSize - 1)) * (sourceSize & 1), sourceSize - 1);
+
+	float depth = 0.0;
+	for(int y = first.y; y <= last.y; y++)
+	{
+		for(int x = first.x; x <= last.x; x++)
+			depth = max(depth, imageLoad(uSource, ivec2(x, y)).r);
+	}
+	imageStore(uDestination, texel, vec4(depth));
+}
+)";
+
+		const char* CullSource = R"(#version 450 core
+layout (local_size_x = 64) in;
+
+struct DrawCommand
+{
+	uint count;
+	uint instanceCount;
+	uint firstIndex;
+	int baseVertex;
+	uint baseInstance;
+};
+
+layout (std430) readonly buffer CullBounds { vec4 uBounds[]; };
+layout (std430) readonly buffer CullCommandsIn { DrawCommand uCommandsIn[]; };
+layout (std430) writeonly buffer CullCommandsOut { DrawCommand uCommandsOut[]; };
+layout (std430) buffer CullDrawCount { uint uDrawCount; };
+
+uniform int uObjectCount;
+uniform vec4 uPlanes[6];
+uniform bool uCompact;
+uniform bool uUseHiZ;
+uniform mat4 uViewProjection;
+uniform vec2 uHiZSize;
+uniform int uHiZLevels;
+layout (binding = 0) uniform sampler2D uHiZ;
+
+bool IsInFrustum(vec4 sphere)
+{
+	for(int i = 0; i < 6; i++)
+	{
+		if(dot(uPlanes[i].xyz, sphere.xyz) + uPlanes[i].w < -sphere.w)
+			return false;
+	}
+	return true;
+}
+
+bool IsOccluded(vec4 sphere)
+{
+	vec3 minimum = vec3(1e30);
+	vec3 maximum = vec3(-1e30);
+	for(int i = 0; i < 8; i++)
+	{
+		vec3 corner = sphere.xyz + sphere.w * vec3((i & 1) != 0 ? 1.0 : -1.0, (i & 2) != 0 ? 1.0 : -1.0, (i & 4) != 0 ? 1.0 : -1.0);
+		vec4 clip = uViewProjection * vec4(corner, 1.0);
+
+		// Boxes crossing the near plane can't be projected, keep them
+		if(clip.w <= 0.0)
+			return false;
+
+		vec3 ndc = clip.xyz / clip.w;
+		minimum = min(minimum, ndc);
+		maximum = max(maximum, ndc);
+	}
+
+	vec2 uvMin = clamp(minimum.xy * 0.5 + 0.5, 0.0, 1.0);
+	vec2 uvMax = clamp(maximum.xy * 0.5 + 0.5, 0.0, 1.0);
+
+	// Pick the level where the box covers at most 2x2 texels
+	vec2 size = (uvMax - uvMin) * uHiZSize;
+	int level = clamp(int(ceil(log2(max(max(size.x, size.y), 1.0)))), 0, uHiZLevels - 1);
+
+	// Texel i of a level covers base texels [i << level, (i + 1) << level), except that the last one also
+	// holds the odd leftovers. Scaling uv by the level size would drift left of that on odd sized bases.
+	// Level sizes follow from the base size, llvmpipe returns the next level's size from textureSize.
+	ivec2 baseSize = ivec2(uHiZSize);
+	ivec2 levelSize = max(baseSize >> level, ivec2(1));
+	ivec2 texelMin = min(min(ivec2(uvMin * uHiZSize), baseSize - 1) >> level, levelSize - 1);
+	ivec2 texelMax = min(min(ivec2(uvMax * uHiZSize), baseSize - 1) >> level, levelSize - 1);
+
+	float farthest = max(
+		max(texelFetch(uHiZ, texelMin, level).r, texelFetch(uHiZ, ivec2(texelMax.x, texelMin.y), level).r),
+		max(texelFetch(uHiZ, ivec2(texelMin.x, texelMax.y), level).r, texelFetch(uHiZ, texelMax, level).r));
+
+	return minimum.z * 0.5 + 0.5 > farthest;
+}
+
+void main()
+{
+	uint index = gl_GlobalInvocationID.x;
+	if(index >= uint(uObjectCount))
+		return;
+
+	DrawCommand command = uCommandsIn[index];
+	vec4 sphere = uBounds[index];
+	bool visible = command.instanceCount > 0 && IsInFrustum(sphere) && !(uUseHiZ && IsOccluded(sphere));
+
+	if(uCompact)
+	{
+		if(visible)
+			uCommandsOut[atomicAdd(uDrawCount, 1)] = command;
+	}
+	else
+	{
+		// Culled commands keep their slot so the full list can be drawn without a count buffer
+		if(!visible)
+			command.instanceCount = 0;
+		uCommandsOut[index] = command;
+	}
+}
+)";
+
+		constexpr uint32_t CullGroupSize = 64;
+		constexpr uint32_t HiZGroupSize = 8;
+
+		GLuint GetStorageBinding(std::string_view blockName, size_t elementSize)
+		{
+			BufferBindings::SetBlockSize(blockName, GL_SHADER_STORAGE_BUFFER, elementSize);
+			return BufferBindings::GetBindingPoint(blockName, GL_SHADER_STORAGE_BUFFER);
+		}
+	}
+
+	HiZPyramid::HiZPyramid(uint32_t width, uint32_t height)
+		: m_width(std::max(width, 1u)), m_height(std::max(height, 1u))
+	{
+		m_levelCount = 1;
+		for(uint32_t size = std::max(m_width, m_height); size > 1; size >>= 1)
+			m_levelCount++;
+
+		glCreateTextures(GL_TEXTURE_2D, 1, &m_texture);
+		glTextureStorage2D(m_texture, m_levelCount, GL_R32F, m_width, m_height);
+		glTextureParameteri(m_texture, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+		glTextureParameteri(m_texture, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		glTextureParameteri(m_texture, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTextureParameteri(m_texture, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+		m_copyShader.LoadComputeFromSource(HiZCopySource);
+		m_downsampleShader.LoadComputeFromSource(HiZDownsampleSource);
+	}
+
+	HiZPyramid::~HiZPyramid()
+	{
+		GLState::DeleteTexture(m_texture);
+	}
+
+	void HiZPyramid::Build(GLuint depthTexture)
+	{
+		RenderThread::Submit([this, depthTexture]()
+		{
+			JJ_PROFILE_SCOPE("HiZPyramid::Build");
+
+			m_copyShader.Use();
+			GLState::BindTextureUnit(0, depthTexture);
+			glBindImageTexture(0, m_texture, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+			glDispatchCompute((m_width + HiZGroupSize - 1) / HiZGroupSize, (m_height + HiZGroupSize - 1) / HiZGroupSize, 1);
+
+			m_downsampleShader.Use();
+			uint32_t width = m_width, height = m_height;
+			for(uint32_t level = 1; level < m_levelCount; level++)
+			{
+				width = std::max(width / 2, 1u);
+				height = std::max(height / 2, 1u);
+
+				// Each level reads what the previous dispatch wrote
+				glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+				glBindImageTexture(0, m_texture, level - 1, GL_FALSE, 0, GL_READ_ONLY, GL_R32F);
+				glBindImageTexture(1, m_texture, level, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+				glDispatchCompute((width + HiZGroupSize - 1) / HiZGroupSize, (height + HiZGroupSize - 1) / HiZGroupSize, 1);
+			}
+
+			glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+		});
+	}
+
+	GpuCuller::GpuCuller()
+		: m_boundsBinding(GetStorageBinding("CullBounds", sizeof(glm::vec4))),
+		m_commandsInBinding(GetStorageBinding("CullCommandsIn", sizeof(DrawElementsIndirectCommand))),
+		m_commandsOutBinding(GetStorageBinding("CullCommandsOut", sizeof(DrawElementsIndirectCommand))),
+		m_drawCountBinding(GetStorageBinding("CullDrawCount", sizeof(uint32_t)))
+	{
+		m_cullShader.LoadComputeFromSource(CullSource);
+
+		glCreateBuffers(1, &m_countBuffer);
+		glNamedBufferStorage(m_countBuffer, sizeof(uint32_t), nullptr, 0);
+
+		// Core since 4.6, llvmpipe and older drivers may only have the ARB entry point or neither
+		if(GLAD_GL_VERSION_4_6)
+			m_multiDrawCount = glMultiDrawElementsIndirectCount;
+		else if(glfwExtensionSupported("GL_ARB_indirect_parameters"))
+			m_multiDrawCount = (PFNGLMULTIDRAWELEMENTSINDIRECTCOUNTPROC)glfwGetProcAddress("glMultiDrawElementsIndirectCountARB");
+
+		if(m_multiDrawCount == nullptr)
+			std::cout << "Warning: indirect draw counts not supported, GPU culling draws the full list\n";
+
+		// Compacted draws lose their position, shaders can no longer rely on gl_DrawID
+		if(!IndirectDrawList::IsDrawParametersSupported())
+			std::cout << "Warning: shader draw parameters not supported, culled object shaders must read aObjectIndex\n";
+
+		m_stats.compacting = m_multiDrawCount != nullptr;
+	}
+
+	GpuCuller::~GpuCuller()
+	{
+		GLState::DeleteBuffer(m_countBuffer);
+		if(m_boundsBuffer != 0)
+			GLState::DeleteBuffer(m_boundsBuffer);
+		if(m_commandBuffer != 0)
+			GLState::DeleteBuffer(m_commandBuffer);
+	}
+
+	void GpuCuller::SetBounds(const glm::vec4* spheres, uint32_t count)
+	{
+		JJ_PROFILE_FUNCTION();
+
+		size_t size = (size_t)count * sizeof(glm::vec4);
+		void* data = RenderThread::Allocate(size, alignof(glm::vec4));
+		std::memcpy(data, spheres, size);
+
+		RenderThread::Submit([this, data, count, size]()
+		{
+			if(count > m_boundsCapacity)
+			{
+				if(m_boundsBuffer != 0)
+					GLState::DeleteBuffer(m_boundsBuffer);
+
+				m_boundsCapacity = std::max(count, m_boundsCapacity * 2);
+				glCreateBuffers(1, &m_boundsBuffer);
+				glNamedBufferStorage(m_boundsBuffer, (GLsizeiptr)m_boundsCapacity * sizeof(glm::vec4), nullptr, GL_DYNAMIC_STORAGE_BIT);
+			}
+
+			if(count > 0)
+				glNamedBufferSubData(m_boundsBuffer, 0, size, data);
+		});
+
+		m_boundsCount = count;
+		m_warnedMissingBounds = false;
+	}
+
+	void GpuCuller::Reserve(uint32_t objectCount)
+	{
+		if(objectCount <= m_capacity)
+			return;
+
+		if(m_commandBuffer != 0)
+			GLState::DeleteBuffer(m_commandBuffer);
+
+		m_capacity = std::max(objectCount, m_capacity * 2);
+		glCreateBuffers(1, &m_commandBuffer);
+		glNamedBufferStorage(m_commandBuffer, (GLsizeiptr)m_capacity * sizeof(DrawElementsIndirectCommand), nullptr, 0);
+	}
+
+	void GpuCuller::CullAndDraw(IndirectDrawList& list, Shader& shader, const glm::mat4& viewProjection, const HiZPyramid* hiZ)
+	{
+		JJ_PROFILE_FUNCTION();
+
+		list.Upload();
+
+		uint32_t objectCount = list.GetObjectCount();
+		if(objectCount > m_boundsCount && !m_warnedMissingBounds)
+		{
+			std::cout << "Warning: GPU culling has bounds for " << m_boundsCount << " of " << objectCount << " objects, the rest are not drawn\n";
+			m_warnedMissingBounds = true;
+		}
+		objectCount = std::min(objectCount, m_boundsCount);
+		m_stats.objects = objectCount;
+
+		Frustum frustum = Frustum::FromMatrix(viewProjection);
+
+		RenderThread::Submit([this, &list, &shader, frustum, viewProjection, hiZ, objectCount]()
+		{
+			uint32_t count = std::min(objectCount, list.GetUploadedCount());
+			if(count == 0)
+				return;
+
+			Reserve(count);
+
+			if(m_multiDrawCount != nullptr)
+				glClearNamedBufferData(m_countBuffer, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, nullptr);
+
+			m_cullShader.Use();
+			m_cullShader.SetUniform1i("uObjectCount", (int)count);
+			glUniform4fv(m_cullShader.GetUniformLocation("uPlanes"), 6, &frustum.planes[0].x);
+			m_cullShader.SetUniform1i("uCompact", m_multiDrawCount != nullptr);
+			m_cullShader.SetUniform1i("uUseHiZ", hiZ != nullptr);
+			if(hiZ != nullptr)
+			{
+				m_cullShader.SetUniformMat4("uViewProjection", viewProjection);
+				m_cullShader.SetUniform2f("uHiZSize", (float)hiZ->GetWidth(), (float)hiZ->GetHeight());
+				m_cullShader.SetUniform1i("uHiZLevels", (int)hiZ->GetLevelCount());
+				GLState::BindTextureUnit(0, hiZ->GetTextureID());
+			}
+
+			GLState::BindBufferBase(GL_SHADER_STORAGE_BUFFER, m_boundsBinding, m_boundsBuffer);
+			GLState::BindBufferBase(GL_SHADER_STORAGE_BUFFER, m_commandsInBinding, list.GetCommandBuffer());
+			GLState::BindBufferBase(GL_SHADER_STORAGE_BUFFER, m_commandsOutBinding, m_commandBuffer);
+			GLState::BindBufferBase(GL_SHADER_STORAGE_BUFFER, m_drawCountBinding, m_countBuffer);
+			glDispatchCompute((count + CullGroupSize - 1) / CullGroupSize, 1, 1);
+
+			// The draw below sources its commands and count from what the dispatch wrote
+			glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT);
+
+			shader.Use();
+			GLState::BindVertexArray(list.GetPool().GetVertexArray());
+			GLState::BindBufferBase(GL_SHADER_STORAGE_BUFFER, list.GetBindingPoint(), list.GetObjectBuffer());
+			GLState::BindBuffer(GL_DRAW_INDIRECT_BUFFER, m_commandBuffer);
+
+			if(m_multiDrawCount != nullptr)
+			{
+				GLState::BindBuffer(GL_PARAMETER_BUFFER, m_countBuffer);
+				m_multiDrawCount(GL_TRIANGLES, GL_UNSIGNED_INT, nullptr, 0, count, 0);
+			}
+			else
+			{
+				glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, nullptr, count, 0);
+			}
+		});
+	}
+}
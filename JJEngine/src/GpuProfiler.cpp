@@ -0,0 +1,196 @@
+#include <array>
+#include <mutex>
+#include <algorithm>
+#include <iostream>
+
+#include "JJEngine/GpuProfiler.h"
+#include "JJEngine/RenderThread.h"
+
+namespace JJEngine {
+	namespace {
+		struct PassQueries {
+			const char* name;
+			uint32_t beginQuery;
+			uint32_t endQuery;
+		};
+
+		// Query objects are pooled per frame slot and reused once the slot comes round again
+		struct FrameQueries {
+			std::vector<GLuint> queries;
+			uint32_t usedQueries = 0;
+			std::vector<PassQueries> passes;
+		};
+
+		struct GpuProfilerData {
+			bool supported = false;
+			std::array<FrameQueries, GpuProfiler::FramesInFlight> frames;
+			uint32_t frame = 0;
+			std::vector<uint32_t> openPasses;
+
+			// Written on the render thread, read from the main thread
+			std::mutex timingsMutex;
+			std::vector<GpuProfiler::PassTiming> timings;
+			uint32_t droppedFrames = 0;
+		};
+
+		GpuProfilerData* s_data = nullptr;
+
+		uint32_t IssueTimestamp(FrameQueries& frame)
+		{
+			if(frame.usedQueries == frame.queries.size())
+			{
+				GLuint query;
+				glGenQueries(1, &query);
+				frame.queries.push_back(query);
+			}
+
+			uint32_t index = frame.usedQueries++;
+			glQueryCounter(frame.queries[index], GL_TIMESTAMP);
+			return index;
+		}
+
+		// Results are only read once every query of the frame reports available, so this never blocks
+		bool ReadResults(FrameQueries& frame)
+		{
+			if(frame.usedQueries == 0)
+				return false;
+
+			// Checked newest first, it is almost always the one still pending
+			for(uint32_t i = frame.usedQueries; i > 0; i--)
+			{
+				GLint available = GL_FALSE;
+				glGetQueryObjectiv(frame.queries[i - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+				if(!available)
+					return false;
+			}
+
+			// The main thread reads the timings while the render thread replaces them
+			std::lock_guard<std::mutex> lock(s_data->timingsMutex);
+			s_data->timings.clear();
+			for(const PassQueries& pass : frame.passes)
+			{
+				if(pass.endQuery == UINT32_MAX)
+					continue;
+
+				GLuint64 begin = 0, end = 0;
+				glGetQueryObjectui64v(frame.queries[pass.beginQuery], GL_QUERY_RESULT, &begin);
+				glGetQueryObjectui64v(frame.queries[pass.endQuery], GL_QUERY_RESULT, &end);
+				double milliseconds = (double)(end - begin) / 1000000.0;
+
+				auto it = std::find_if(s_data->timings.begin(), s_data->timings.end(), [&](const GpuProfiler::PassTiming& timing) { return timing.name == pass.name; });
+				if(it != s_data->timings.end())
+					it->milliseconds += milliseconds;
+				else
+					s_data->timings.push_back({ pass.name, milliseconds });
+			}
+			return true;
+		}
+	}
+
+	void GpuProfiler::Init()
+	{
+		if(s_data != nullptr)
+			return;
+
+		s_data = new GpuProfilerData();
+
+		GLint counterBits = 0;
+		glGetQueryiv(GL_TIMESTAMP, GL_QUERY_COUNTER_BITS, &counterBits);
+		s_data->supported = counterBits > 0;
+		if(!s_data->supported)
+			std::cout << "Warning: GL_TIMESTAMP queries unsupported, GPU timings disabled\n";
+	}
+
+	void GpuProfiler::Shutdown()
+	{
+		if(s_data == nullptr)
+			return;
+
+		for(FrameQueries& frame : s_data->frames)
+			glDeleteQueries((GLsizei)frame.queries.size(), frame.queries.data());
+
+		delete s_data;
+		s_data = nullptr;
+	}
+
+	void GpuProfiler::BeginFrame()
+	{
+		if(s_data == nullptr || !s_data->supported)
+			return;
+
+		RenderThread::Submit([]()
+		{
+			s_data->frame = (s_data->frame + 1) % FramesInFlight;
+			s_data->openPasses.clear();
+
+			// This slot was recorded FramesInFlight frames ago, if its results still aren't in they are dropped
+			// rather than waited on, reissuing a pending query simply discards its old result
+			FrameQueries& frame = s_data->frames[s_data->frame];
+			if(!ReadResults(frame) && frame.usedQueries != 0)
+			{
+				std::lock_guard<std::mutex> lock(s_data->timingsMutex);
+				s_data->droppedFrames++;
+			}
+
+			frame.usedQueries = 0;
+			frame.passes.clear();
+		});
+	}
+
+	void GpuProfiler::BeginPass(const char* name)
+	{
+		if(s_data == nullptr || !s_data->supported)
+			return;
+
+		RenderThread::Submit([name]()
+		{
+			FrameQueries& frame = s_data->frames[s_data->frame];
+			s_data->openPasses.push_back((uint32_t)frame.passes.size());
+			frame.passes.push_back({ name, IssueTimestamp(frame), UINT32_MAX });
+		});
+	}
+
+	void GpuProfiler::EndPass()
+	{
+		if(s_data == nullptr || !s_data->supported)
+			return;
+
+		RenderThread::Submit([]()
+		{
+			if(s_data->openPasses.empty())
+				return;
+
+			FrameQueries& frame = s_data->frames[s_data->frame];
+			frame.passes[s_data->openPasses.back()].endQuery = IssueTimestamp(frame);
+			s_data->openPasses.pop_back();
+		});
+	}
+
+	std::vector<GpuProfiler::PassTiming> GpuProfiler::GetPassTimings()
+	{
+		if(s_data == nullptr)
+			return {};
+
+		std::lock_guard<std::mutex> lock(s_data->timingsMutex);
+		return s_data->timings;
+	}
+
+	double GpuProfiler::GetPassTime(const std::string& name)
+	{
+		for(const PassTiming& timing : GetPassTimings())
+		{
+			if(timing.name == name)
+				return timing.milliseconds;
+		}
+		return 0.0;
+	}
+
+	uint32_t GpuProfiler::GetDroppedFrames()
+	{
+		if(s_data == nullptr)
+			return 0;
+
+		std::lock_guard<std::mutex> lock(s_data->timingsMutex);
+		return s_data->droppedFrames;
+	}
+}
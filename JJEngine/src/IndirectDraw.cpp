@@ -0,0 +1,229 @@
+#include <chrono>
+#include <cstring>
+#include <algorithm>
+#include <iostream>
+
+#include <GLFW/glfw3.h>
+
+#include "JJEngine/IndirectDraw.h"
+#include "JJEngine/UniformBuffer.h"
+#include "JJEngine/RenderThread.h"
+#include "JJEngine/GLState.h"
+#include "JJEngine/Profiler.h"
+
+namespace JJEngine {
+	namespace {
+		constexpr GLuint ObjectIndexBinding = 1;
+		constexpr uint32_t InitialObjectCapacity = 256;
+	}
+
+	GeometryPool::GeometryPool(const VertexLayout& layout, uint32_t maxVertices, uint32_t maxIndices)
+		: m_stride(layout.GetStride()), m_maxVertices(maxVertices), m_maxIndices(maxIndices)
+	{
+		glCreateBuffers(1, &m_vertexBuffer);
+		glNamedBufferStorage(m_vertexBuffer, (GLsizeiptr)maxVertices * m_stride, nullptr, GL_DYNAMIC_STORAGE_BIT);
+
+		glCreateBuffers(1, &m_indexBuffer);
+		glNamedBufferStorage(m_indexBuffer, (GLsizeiptr)maxIndices * sizeof(uint32_t), nullptr, GL_DYNAMIC_STORAGE_BIT);
+
+		glCreateVertexArrays(1, &m_vertexArray);
+		glVertexArrayVertexBuffer(m_vertexArray, 0, m_vertexBuffer, 0, m_stride);
+		glVertexArrayElementBuffer(m_vertexArray, m_indexBuffer);
+		layout.Apply(m_vertexArray, 0, 0);
+
+		// A divisor no instance count reaches keeps every instance of a draw on element baseInstance
+		glEnableVertexArrayAttrib(m_vertexArray, ObjectIndexLocation);
+		glVertexArrayAttribIFormat(m_vertexArray, ObjectIndexLocation, 1, GL_UNSIGNED_INT, 0);
+		glVertexArrayAttribBinding(m_vertexArray, ObjectIndexLocation, ObjectIndexBinding);
+		glVertexArrayBindingDivisor(m_vertexArray, ObjectIndexBinding, UINT32_MAX);
+		ReserveObjects(InitialObjectCapacity);
+	}
+
+	GeometryPool::~GeometryPool()
+	{
+		GLState::DeleteVertexArray(m_vertexArray);
+		GLState::DeleteBuffer(m_vertexBuffer);
+		GLState::DeleteBuffer(m_indexBuffer);
+		GLState::DeleteBuffer(m_objectIndexBuffer);
+	}
+
+	void GeometryPool::ReserveObjects(uint32_t objectCount)
+	{
+		if(objectCount <= m_objectCapacity)
+			return;
+
+		if(m_objectIndexBuffer != 0)
+			GLState::DeleteBuffer(m_objectIndexBuffer);
+
+		m_objectCapacity = std::max(objectCount, m_objectCapacity * 2);
+		std::vector<uint32_t> indices(m_objectCapacity);
+		for(uint32_t i = 0; i < m_objectCapacity; i++)
+			indices[i] = i;
+
+		glCreateBuffers(1, &m_objectIndexBuffer);
+		glNamedBufferStorage(m_objectIndexBuffer, (GLsizeiptr)m_objectCapacity * sizeof(uint32_t), indices.data(), 0);
+		glVertexArrayVertexBuffer(m_vertexArray, ObjectIndexBinding, m_objectIndexBuffer, 0, sizeof(uint32_t));
+	}
+
+	GeometryPool::MeshRange GeometryPool::Add(const void* vertices, uint32_t vertexCount, const uint32_t* indices, uint32_t indexCount)
+	{
+		if(m_vertexCount + vertexCount > m_maxVertices || m_indexCount + indexCount > m_maxIndices)
+		{
+			std::cout << "Warning: Geometry pool is full, mesh of " << vertexCount << " vertices dropped\n";
+			return {};
+		}
+
+		MeshRange range;
+		range.firstIndex = m_indexCount;
+		range.indexCount = indexCount;
+		range.baseVertex = (int32_t)m_vertexCount;
+		range.vertexCount = vertexCount;
+
+		size_t vertexSize = (size_t)vertexCount * m_stride;
+		size_t indexSize = (size_t)indexCount * sizeof(uint32_t);
+		uint8_t* data = (uint8_t*)RenderThread::Allocate(vertexSize + indexSize);
+		std::memcpy(data, vertices, vertexSize);
+		std::memcpy(data + vertexSize, indices, indexSize);
+
+		RenderThread::Submit([this, range, data, vertexSize, indexSize]()
+		{
+			glNamedBufferSubData(m_vertexBuffer, (GLintptr)range.baseVertex * m_stride, vertexSize, data);
+			glNamedBufferSubData(m_indexBuffer, (GLintptr)range.firstIndex * sizeof(uint32_t), indexSize, data + vertexSize);
+		});
+
+		m_vertexCount += vertexCount;
+		m_indexCount += indexCount;
+		return range;
+	}
+
+	bool IndirectDrawList::IsDrawParametersSupported()
+	{
+		return GLAD_GL_VERSION_4_6 || glfwExtensionSupported("GL_ARB_shader_draw_parameters");
+	}
+
+	IndirectDrawList::IndirectDrawList(GeometryPool& pool, size_t objectDataSize, std::string_view blockName)
+		: m_pool(pool), m_objectDataSize(objectDataSize), m_bindingPoint(BufferBindings::GetBindingPoint(blockName, GL_SHADER_STORAGE_BUFFER))
+	{
+		BufferBindings::SetBlockSize(blockName, GL_SHADER_STORAGE_BUFFER, objectDataSize);
+	}
+
+	IndirectDrawList::~IndirectDrawList()
+	{
+		if(m_commandBuffer != 0)
+		{
+			GLState::DeleteBuffer(m_commandBuffer);
+			GLState::DeleteBuffer(m_objectBuffer);
+		}
+	}
+
+	uint32_t IndirectDrawList::Add(const GeometryPool::MeshRange& mesh, const void* objectData, uint32_t instanceCount)
+	{
+		uint32_t index = (uint32_t)m_commands.size();
+		m_commands.push_back({ mesh.indexCount, instanceCount, mesh.firstIndex, mesh.baseVertex, index });
+
+		const uint8_t* bytes = (const uint8_t*)objectData;
+		m_objectData.insert(m_objectData.end(), bytes, bytes + m_objectDataSize);
+
+		m_dirty = true;
+		return index;
+	}
+
+	void IndirectDrawList::SetObjectData(uint32_t index, const void* objectData)
+	{
+		std::memcpy(m_objectData.data() + index * m_objectDataSize, objectData, m_objectDataSize);
+		m_dirty = true;
+	}
+
+	void IndirectDrawList::Clear()
+	{
+		m_commands.clear();
+		m_objectData.clear();
+		m_dirty = true;
+	}
+
+	void IndirectDrawList::Upload()
+	{
+		if(!m_dirty)
+			return;
+
+		JJ_PROFILE_FUNCTION();
+
+		uint32_t count = (uint32_t)m_commands.size();
+		size_t commandsSize = count * sizeof(DrawElementsIndirectCommand);
+		size_t objectDataSize = m_objectData.size();
+
+		uint8_t* data = (uint8_t*)RenderThread::Allocate(commandsSize + objectDataSize);
+		std::memcpy(data, m_commands.data(), commandsSize);
+		std::memcpy(data + commandsSize, m_objectData.data(), objectDataSize);
+
+		RenderThread::Submit([this, data, commandsSize, count]()
+		{
+			UploadBuffers((const DrawElementsIndirectCommand*)data, data + commandsSize, count);
+		});
+
+		m_dirty = false;
+	}
+
+	void IndirectDrawList::UploadBuffers(const DrawElementsIndirectCommand* commands, const uint8_t* objectData, uint32_t count)
+	{
+		Reserve(count);
+		if(count > 0)
+		{
+			glNamedBufferSubData(m_commandBuffer, 0, count * sizeof(DrawElementsIndirectCommand), commands);
+			glNamedBufferSubData(m_objectBuffer, 0, count * m_objectDataSize, objectData);
+		}
+		m_uploadedCount = count;
+	}
+
+	void IndirectDrawList::Reserve(uint32_t objectCount)
+	{
+		if(objectCount <= m_capacity)
+			return;
+
+		// Immutable storage can't grow, so the buffers are replaced with room to spare
+		if(m_commandBuffer != 0)
+		{
+			GLState::DeleteBuffer(m_commandBuffer);
+			GLState::DeleteBuffer(m_objectBuffer);
+		}
+
+		m_capacity = std::max(objectCount, m_capacity * 2);
+		m_pool.ReserveObjects(m_capacity);
+
+		glCreateBuffers(1, &m_commandBuffer);
+		glNamedBufferStorage(m_commandBuffer, m_capacity * sizeof(DrawElementsIndirectCommand), nullptr, GL_DYNAMIC_STORAGE_BIT);
+
+		glCreateBuffers(1, &m_objectBuffer);
+		glNamedBufferStorage(m_objectBuffer, m_capacity * m_objectDataSize, nullptr, GL_DYNAMIC_STORAGE_BIT);
+	}
+
+	void IndirectDrawList::Draw(Shader& shader)
+	{
+		Upload();
+
+		RenderThread::Submit([this, &shader]()
+		{
+			if(m_uploadedCount == 0)
+				return;
+
+			auto start = std::chrono::high_resolution_clock::now();
+
+			shader.Use();
+			GLState::BindVertexArray(m_pool.GetVertexArray());
+			GLState::BindBuffer(GL_DRAW_INDIRECT_BUFFER, m_commandBuffer);
+			GLState::BindBufferBase(GL_SHADER_STORAGE_BUFFER, m_bindingPoint, m_objectBuffer);
+			glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, nullptr, m_uploadedCount, 0);
+
+			auto end = std::chrono::high_resolution_clock::now();
+			m_submitTime.store(std::chrono::duration<double, std::milli>(end - start).count(), std::memory_order_relaxed);
+		});
+	}
+
+	IndirectDrawList::Statistics IndirectDrawList::GetStats() const
+	{
+		Statistics stats;
+		stats.objects = (uint32_t)m_commands.size();
+		stats.submitTime = m_submitTime.load(std::memory_order_relaxed);
+		return stats;
+	}
+}
@@ -0,0 +1,251 @@
+#include <memory>
+
+#include "JJEngine/JobSystem.h"
+#include "JJEngine/Profiler.h"
+
+namespace JJEngine {
+	namespace {
+		thread_local int32_t t_workerIndex = -1;
+
+		// Jobs are recycled round robin from a per-thread ring, so scheduling never allocates
+		thread_local std::unique_ptr<Job[]> t_jobs;
+		thread_local size_t t_nextJob = 0;
+	}
+
+	bool WorkStealingQueue::Push(Job* job)
+	{
+		int64_t bottom = m_bottom.load(std::memory_order_relaxed);
+		int64_t top = m_top.load(std::memory_order_acquire);
+		if(bottom - top >= Capacity)
+			return false;
+
+		m_jobs[bottom & (Capacity - 1)].store(job, std::memory_order_relaxed);
+		m_bottom.store(bottom + 1, std::memory_order_release);
+		return true;
+	}
+
+	Job* WorkStealingQueue::Pop()
+	{
+		int64_t bottom = m_bottom.load(std::memory_order_relaxed) - 1;
+		m_bottom.store(bottom, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		int64_t top = m_top.load(std::memory_order_relaxed);
+
+		if(top > bottom)
+		{
+			m_bottom.store(bottom + 1, std::memory_order_relaxed);
+			return nullptr;
+		}
+
+		Job* job = m_jobs[bottom & (Capacity - 1)].load(std::memory_order_relaxed);
+		if(top == bottom)
+		{
+			// Last job, race thieves for it
+			if(!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+				job = nullptr;
+			m_bottom.store(bottom + 1, std::memory_order_relaxed);
+		}
+		return job;
+	}
+
+	Job* WorkStealingQueue::Steal()
+	{
+		int64_t top = m_top.load(std::memory_order_acquire);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		int64_t bottom = m_bottom.load(std::memory_order_acquire);
+
+		if(top >= bottom)
+			return nullptr;
+
+		Job* job = m_jobs[top & (Capacity - 1)].load(std::memory_order_relaxed);
+		if(!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+			return nullptr;
+		return job;
+	}
+
+	JobSystem::JobSystem(uint32_t workerCount)
+	{
+		if(workerCount == 0)
+			workerCount = std::max(1u, std::thread::hardware_concurrency());
+
+		for(uint32_t i = 0; i < workerCount; i++)
+			m_queues.push_back(std::make_unique<WorkStealingQueue>());
+
+		t_workerIndex = 0;
+		for(uint32_t i = 1; i < workerCount; i++)
+			m_threads.emplace_back(&JobSystem::WorkerLoop, this, i);
+	}
+
+	JobSystem::~JobSystem()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_sleepMutex);
+			m_stopping = true;
+		}
+		m_wakeCondition.notify_all();
+
+		for(std::thread& thread : m_threads)
+			thread.join();
+
+		t_workerIndex = -1;
+	}
+
+	void JobSystem::Wait(JobCounter& counter)
+	{
+		while(!counter.IsDone())
+		{
+			if(Job* job = FindJob())
+				Execute(job);
+			else
+				std::this_thread::yield();
+		}
+
+		// The last job releases the counter under its lock, taking it guarantees that has finished
+		std::lock_guard<std::mutex> lock(counter.m_mutex);
+	}
+
+	int32_t JobSystem::GetWorkerIndex()
+	{
+		return t_workerIndex;
+	}
+
+	Job* JobSystem::AllocateJob()
+	{
+		if(!t_jobs)
+			t_jobs = std::make_unique<Job[]>(MaxJobsPerThread);
+
+		Job* job = &t_jobs[t_nextJob];
+		t_nextJob = (t_nextJob + 1) % MaxJobsPerThread;
+
+		// More jobs in flight than the ring holds, help out until the oldest one is done
+		while(!job->finished.load(std::memory_order_acquire))
+		{
+			if(Job* other = FindJob())
+				Execute(other);
+			else
+				std::this_thread::yield();
+		}
+
+		job->finished.store(false, std::memory_order_relaxed);
+		return job;
+	}
+
+	void JobSystem::Schedule(Job* job, JobCounter* dependency)
+	{
+		if(dependency != nullptr)
+		{
+			std::unique_lock<std::mutex> lock(dependency->m_mutex);
+			if(dependency->m_value.load(std::memory_order_acquire) != 0)
+			{
+				dependency->m_continuations.push_back(job);
+				return;
+			}
+		}
+
+		Push(job);
+	}
+
+	void JobSystem::Push(Job* job)
+	{
+		m_queuedJobs.fetch_add(1, std::memory_order_seq_cst);
+
+		int32_t index = GetWorkerIndex();
+		if(index < 0 || !m_queues[index]->Push(job))
+		{
+			std::lock_guard<std::mutex> lock(m_injectionMutex);
+			m_injectionQueue.push_back(job);
+		}
+
+		if(m_sleepingWorkers.load(std::memory_order_seq_cst) > 0)
+		{
+			{
+				std::lock_guard<std::mutex> lock(m_sleepMutex);
+			}
+			m_wakeCondition.notify_one();
+		}
+	}
+
+	Job* JobSystem::FindJob()
+	{
+		if(m_queuedJobs.load(std::memory_order_relaxed) <= 0)
+			return nullptr;
+
+		Job* job = nullptr;
+
+		int32_t index = GetWorkerIndex();
+		if(index >= 0)
+			job = m_queues[index]->Pop();
+
+		if(job == nullptr)
+		{
+			std::lock_guard<std::mutex> lock(m_injectionMutex);
+			if(!m_injectionQueue.empty())
+			{
+				job = m_injectionQueue.front();
+				m_injectionQueue.pop_front();
+			}
+		}
+
+		if(job == nullptr)
+		{
+			uint32_t queueCount = (uint32_t)m_queues.size();
+			uint32_t start = index >= 0 ? (uint32_t)index : 0;
+			for(uint32_t i = 1; i <= queueCount && job == nullptr; i++)
+			{
+				uint32_t victim = (start + i) % queueCount;
+				if((int32_t)victim != index)
+					job = m_queues[victim]->Steal();
+			}
+		}
+
+		if(job != nullptr)
+			m_queuedJobs.fetch_sub(1, std::memory_order_relaxed);
+		return job;
+	}
+
+	void JobSystem::Execute(Job* job)
+	{
+		{
+			JJ_PROFILE_SCOPE("Job");
+			job->invoke(*job);
+			job->destroy(*job);
+		}
+
+		JobCounter* counter = job->counter;
+		job->finished.store(true, std::memory_order_release);
+
+		if(counter == nullptr)
+			return;
+
+		std::vector<Job*> continuations;
+		{
+			std::lock_guard<std::mutex> lock(counter->m_mutex);
+			if(counter->m_value.fetch_sub(1, std::memory_order_acq_rel) != 1)
+				return;
+			continuations.swap(counter->m_continuations);
+		}
+
+		for(Job* continuation : continuations)
+			Push(continuation);
+	}
+
+	void JobSystem::WorkerLoop(uint32_t index)
+	{
+		t_workerIndex = (int32_t)index;
+		Profiler::SetThreadName("Worker " + std::to_string(index));
+
+		while(!m_stopping.load(std::memory_order_relaxed))
+		{
+			if(Job* job = FindJob())
+			{
+				Execute(job);
+				continue;
+			}
+
+			std::unique_lock<std::mutex> lock(m_sleepMutex);
+			m_sleepingWorkers.fetch_add(1, std::memory_order_seq_cst);
+			m_wakeCondition.wait(lock, [this]() { return m_stopping.load() || m_queuedJobs.load(std::memory_order_seq_cst) > 0; });
+			m_sleepingWorkers.fetch_sub(1, std::memory_order_relaxed);
+		}
+	}
+}
@@ -0,0 +1,221 @@
+#include <cstdio>
+#include <utility>
+#include <algorithm>
+
+#include "JJEngine/MappedFile.h"
+#include "JJEngine/Profiler.h"
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#elif defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#define JJ_MAPPED_FILE_POSIX 1
+#endif
+
+namespace JJEngine {
+	namespace {
+		constexpr size_t StreamChunkSize = 64 * 1024;
+	}
+
+	MappedFile::MappedFile(const std::string& path, AccessPattern pattern)
+	{
+		Open(path, pattern);
+	}
+
+	MappedFile::~MappedFile()
+	{
+		Close();
+	}
+
+	MappedFile::MappedFile(MappedFile&& other) noexcept
+	{
+		*this = std::move(other);
+	}
+
+	MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+	{
+		if(this == &other)
+			return *this;
+
+		Close();
+		m_data = std::exchange(other.m_data, nullptr);
+		m_size = std::exchange(other.m_size, 0);
+		m_open = std::exchange(other.m_open, false);
+		m_mapped = std::exchange(other.m_mapped, false);
+		m_buffer = std::move(other.m_buffer); // Moving keeps the heap block, m_data stays valid
+		return *this;
+	}
+
+	bool MappedFile::Open(const std::string& path, AccessPattern pattern)
+	{
+		JJ_PROFILE_FUNCTION();
+
+		Close();
+		m_open = Map(path, pattern) || Stream(path);
+		return m_open;
+	}
+
+	void MappedFile::Close()
+	{
+		if(m_mapped)
+		{
+#if defined(_WIN32)
+			UnmapViewOfFile(m_data);
+#elif JJ_MAPPED_FILE_POSIX
+			munmap((void*)m_data, m_size);
+#endif
+		}
+
+		m_data = nullptr;
+		m_size = 0;
+		m_open = false;
+		m_mapped = false;
+		m_buffer = {};
+	}
+
+	void MappedFile::Prefetch(size_t offset, size_t size) const
+	{
+		if(!m_mapped || offset >= m_size)
+			return;
+
+		size = std::min(size, m_size - offset);
+
+#if defined(_WIN32)
+		WIN32_MEMORY_RANGE_ENTRY range{ (void*)(m_data + offset), size };
+		PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+#elif JJ_MAPPED_FILE_POSIX
+		// madvise wants a page aligned start
+		size_t pageSize = (size_t)sysconf(_SC_PAGESIZE);
+		size_t alignedOffset = offset & ~(pageSize - 1);
+		madvise((void*)(m_data + alignedOffset), size + (offset - alignedOffset), MADV_WILLNEED);
+#endif
+	}
+
+	bool MappedFile::Map(const std::string& path, AccessPattern pattern)
+	{
+#if defined(_WIN32)
+		DWORD flags = FILE_ATTRIBUTE_NORMAL;
+		if(pattern == AccessPattern::Sequential)
+			flags |= FILE_FLAG_SEQUENTIAL_SCAN;
+		else if(pattern == AccessPattern::Random)
+			flags |= FILE_FLAG_RANDOM_ACCESS;
+
+		HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, flags, nullptr);
+		if(file == INVALID_HANDLE_VALUE)
+			return false;
+
+		LARGE_INTEGER size{};
+		if(!GetFileSizeEx(file, &size) || GetFileType(file) != FILE_TYPE_DISK)
+		{
+			CloseHandle(file);
+			return false;
+		}
+
+		// Empty files can't be mapped, streaming handles them
+		if(size.QuadPart == 0)
+		{
+			CloseHandle(file);
+			return false;
+		}
+
+		HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		CloseHandle(file);
+		if(mapping == nullptr)
+			return false;
+
+		// The view keeps the mapping alive
+		void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+		CloseHandle(mapping);
+		if(data == nullptr)
+			return false;
+
+		m_data = (const std::byte*)data;
+		m_size = (size_t)size.QuadPart;
+		m_mapped = true;
+		return true;
+#elif JJ_MAPPED_FILE_POSIX
+		int file = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+		if(file < 0)
+			return false;
+
+		struct stat status{};
+		if(fstat(file, &status) != 0 || !S_ISREG(status.st_mode))
+		{
+			close(file);
+			return false;
+		}
+
+		// Empty files can't be mapped, and procfs reports 0 for files that aren't. Streaming handles both.
+		if(status.st_size == 0)
+		{
+			close(file);
+			return false;
+		}
+
+		// The mapping keeps the file alive
+		void* data = mmap(nullptr, (size_t)status.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+		close(file);
+		if(data == MAP_FAILED)
+			return false;
+
+		m_data = (const std::byte*)data;
+		m_size = (size_t)status.st_size;
+		m_mapped = true;
+
+		switch(pattern)
+		{
+		case AccessPattern::Sequential:
+			madvise(data, m_size, MADV_SEQUENTIAL);
+			madvise(data, m_size, MADV_WILLNEED);
+			break;
+		case AccessPattern::Random:
+			madvise(data, m_size, MADV_RANDOM);
+			break;
+		default:
+			break;
+		}
+		return true;
+#else
+		(void)path;
+		(void)pattern;
+		return false;
+#endif
+	}
+
+	bool MappedFile::Stream(const std::string& path)
+	{
+		std::FILE* file = std::fopen(path.c_str(), "rb");
+		if(file == nullptr)
+			return false;
+
+		// Sizes of special files can't be trusted, read until the end
+		size_t size = 0;
+		for(;;)
+		{
+			m_buffer.resize(size + StreamChunkSize);
+			size_t read = std::fread(m_buffer.data() + size, 1, StreamChunkSize, file);
+			size += read;
+			if(read < StreamChunkSize)
+				break;
+		}
+
+		bool failed = std::ferror(file) != 0;
+		std::fclose(file);
+		if(failed)
+		{
+			m_buffer = {};
+			return false;
+		}
+
+		m_buffer.resize(size);
+		m_buffer.shrink_to_fit();
+		m_data = m_buffer.data();
+		m_size = size;
+		return true;
+	}
+}
@@ -0,0 +1,178 @@
+#include <cstring>
+#include <algorithm>
+
+#include "JJEngine/Mesh.h"
+#include "JJEngine/GLState.h"
+#include "JJEngine/RenderThread.h"
+#include "JJEngine/Profiler.h"
+
+namespace JJEngine {
+	namespace {
+		// Each instance stream region holds several full draws so a frame drawing the mesh
+		// more than once doesn't wrap onto regions still in flight
+		constexpr uint32_t DrawsPerStreamRegion = 8;
+
+		// Meshes whose instance stream was written since the last EndFrame, context thread only
+		std::vector<Mesh*> s_streamedMeshes;
+
+		struct AttributeFormat {
+			GLint components;
+			GLenum type;
+			bool normalized;
+			bool integer;
+			uint32_t size;
+			uint32_t locations;
+		};
+
+		AttributeFormat GetFormat(VertexAttribute attribute)
+		{
+			switch(attribute)
+			{
+			case VertexAttribute::Float:      return { 1, GL_FLOAT, false, false, 4, 1 };
+			case VertexAttribute::Float2:     return { 2, GL_FLOAT, false, false, 8, 1 };
+			case VertexAttribute::Float3:     return { 3, GL_FLOAT, false, false, 12, 1 };
+			case VertexAttribute::Float4:     return { 4, GL_FLOAT, false, false, 16, 1 };
+			case VertexAttribute::Int:        return { 1, GL_INT, false, true, 4, 1 };
+			case VertexAttribute::UInt:       return { 1, GL_UNSIGNED_INT, false, true, 4, 1 };
+			case VertexAttribute::UByte4Norm: return { 4, GL_UNSIGNED_BYTE, true, false, 4, 1 };
+			case VertexAttribute::Mat4:       return { 4, GL_FLOAT, false, false, 64, 4 };
+			}
+			return {};
+		}
+	}
+
+	VertexLayout::VertexLayout(std::initializer_list<VertexAttribute> attributes)
+	{
+		for(VertexAttribute attribute : attributes)
+		{
+			AttributeFormat format = GetFormat(attribute);
+			m_elements.push_back({ attribute, m_stride });
+			m_stride += format.size;
+			m_locationCount += format.locations;
+		}
+	}
+
+	void VertexLayout::Apply(GLuint vertexArray, uint32_t firstLocation, GLuint binding) const
+	{
+		uint32_t location = firstLocation;
+		for(const Element& element : m_elements)
+		{
+			AttributeFormat format = GetFormat(element.type);
+			for(uint32_t i = 0; i < format.locations; i++, location++)
+			{
+				// Matrix columns are consecutive vec4s
+				uint32_t offset = element.offset + i * format.size / format.locations;
+
+				glEnableVertexArrayAttrib(vertexArray, location);
+				if(format.integer)
+					glVertexArrayAttribIFormat(vertexArray, location, format.components, format.type, offset);
+				else
+					glVertexArrayAttribFormat(vertexArray, location, format.components, format.type, format.normalized ? GL_TRUE : GL_FALSE, offset);
+				glVertexArrayAttribBinding(vertexArray, location, binding);
+			}
+		}
+	}
+
+	Mesh::Mesh(const VertexLayout& layout, const void* vertices, uint32_t vertexCount, const uint32_t* indices, uint32_t indexCount)
+		: m_vertexCount(vertexCount), m_indexCount(indexCount), m_vertexLocationCount(layout.GetLocationCount())
+	{
+		glCreateBuffers(1, &m_vertexBuffer);
+		glNamedBufferStorage(m_vertexBuffer, (GLsizeiptr)vertexCount * layout.GetStride(), vertices, 0);
+
+		glCreateVertexArrays(1, &m_vertexArray);
+		glVertexArrayVertexBuffer(m_vertexArray, 0, m_vertexBuffer, 0, layout.GetStride());
+		layout.Apply(m_vertexArray, 0, 0);
+
+		if(indices != nullptr && indexCount > 0)
+		{
+			glCreateBuffers(1, &m_indexBuffer);
+			glNamedBufferStorage(m_indexBuffer, (GLsizeiptr)indexCount * sizeof(uint32_t), indices, 0);
+			glVertexArrayElementBuffer(m_vertexArray, m_indexBuffer);
+		}
+	}
+
+	void Mesh::EndFrame()
+	{
+		for(Mesh* mesh : s_streamedMeshes)
+		{
+			mesh->m_instanceStream->EndFrame();
+			mesh->m_streamed = false;
+		}
+		s_streamedMeshes.clear();
+	}
+
+	Mesh::~Mesh()
+	{
+		if(m_streamed)
+			std::erase(s_streamedMeshes, this);
+
+		GLState::DeleteVertexArray(m_vertexArray);
+		GLState::DeleteBuffer(m_vertexBuffer);
+		if(m_indexBuffer != 0)
+			GLState::DeleteBuffer(m_indexBuffer);
+	}
+
+	void Mesh::SetInstanceLayout(const VertexLayout& layout, uint32_t maxInstancesPerDraw)
+	{
+		m_instanceStride = layout.GetStride();
+		m_maxInstancesPerDraw = maxInstancesPerDraw;
+		m_instanceStream = std::make_unique<StreamBuffer>((size_t)m_instanceStride * maxInstancesPerDraw * DrawsPerStreamRegion);
+
+		// Bound once at offset 0, each draw selects its slice with baseInstance
+		glVertexArrayVertexBuffer(m_vertexArray, 1, m_instanceStream->GetRendererID(), 0, m_instanceStride);
+		glVertexArrayBindingDivisor(m_vertexArray, 1, 1);
+		layout.Apply(m_vertexArray, m_vertexLocationCount, 1);
+	}
+
+	void Mesh::Draw(Shader& shader)
+	{
+		RenderThread::Submit([this, &shader]()
+		{
+			shader.Use();
+			GLState::BindVertexArray(m_vertexArray);
+			IssueDraw(1, 0);
+		});
+	}
+
+	void Mesh::DrawInstanced(Shader& shader, const void* instances, uint32_t instanceCount)
+	{
+		if(instanceCount == 0 || m_instanceStream == nullptr)
+			return;
+
+		JJ_PROFILE_FUNCTION();
+
+		size_t size = (size_t)instanceCount * m_instanceStride;
+		void* data = RenderThread::Allocate(size, alignof(std::max_align_t));
+		std::memcpy(data, instances, size);
+
+		RenderThread::Submit([this, &shader, data, instanceCount]()
+		{
+			shader.Use();
+			GLState::BindVertexArray(m_vertexArray);
+
+			if(!m_streamed)
+			{
+				s_streamedMeshes.push_back(this);
+				m_streamed = true;
+			}
+
+			for(uint32_t first = 0; first < instanceCount; first += m_maxInstancesPerDraw)
+			{
+				uint32_t count = std::min(m_maxInstancesPerDraw, instanceCount - first);
+				size_t size = (size_t)count * m_instanceStride;
+
+				StreamBuffer::Allocation allocation = m_instanceStream->Allocate(size, m_instanceStride);
+				std::memcpy(allocation.data, (const uint8_t*)data + (size_t)first * m_instanceStride, size);
+				IssueDraw(count, (uint32_t)(allocation.offset / m_instanceStride));
+			}
+		});
+	}
+
+	void Mesh::IssueDraw(uint32_t instanceCount, uint32_t baseInstance) const
+	{
+		if(m_indexBuffer != 0)
+			glDrawElementsInstancedBaseVertexBaseInstance(GL_TRIANGLES, m_indexCount, GL_UNSIGNED_INT, nullptr, instanceCount, 0, baseInstance);
+		else
+			glDrawArraysInstancedBaseInstance(GL_TRIANGLES, 0, m_vertexCount, instanceCount, baseInstance);
+	}
+}
@@ -0,0 +1,121 @@
+#include <cstring>
+#include <iostream>
+#include <algorithm>
+
+#include "JJEngine/PackFile.h"
+#include "JJEngine/Profiler.h"
+
+#if defined(JJ_PACK_LZ4)
+#include <lz4.h>
+#endif
+#if defined(JJ_PACK_ZSTD)
+#include <zstd.h>
+#endif
+
+namespace JJEngine {
+	bool PackFile::Open(const std::string& path)
+	{
+		JJ_PROFILE_FUNCTION();
+
+		Close();
+
+		// Entries are read piecemeal, each one is prefetched when it is needed
+		if(!m_file.Open(path, MappedFile::AccessPattern::Random))
+		{
+			std::cout << "Error: Pack file not found: " << path << "\n";
+			return false;
+		}
+
+		std::span<const std::byte> data = m_file.GetData();
+		PackFormat::Header header{};
+		if(data.size() >= sizeof(header))
+			std::memcpy(&header, data.data(), sizeof(header));
+
+		bool valid = data.size() >= sizeof(header) && header.magic == PackFormat::Magic && header.version == PackFormat::Version
+			&& header.tocOffset % alignof(Entry) == 0 && (uintptr_t)data.data() % alignof(Entry) == 0
+			&& header.tocOffset <= data.size() && header.entryCount <= (data.size() - header.tocOffset) / sizeof(Entry)
+			&& header.namesOffset <= data.size() && header.namesSize <= data.size() - header.namesOffset;
+		if(!valid)
+		{
+			std::cout << "Error: " << path << " is not a pack file or was written by a different version\n";
+			Close();
+			return false;
+		}
+
+		m_entries = { (const Entry*)(data.data() + header.tocOffset), header.entryCount };
+		m_names = { (const char*)data.data() + header.namesOffset, header.namesSize };
+
+		for(const Entry& entry : m_entries)
+		{
+			bool inside = entry.offset <= data.size() && entry.size <= data.size() - entry.offset
+				&& (uint64_t)entry.nameOffset + entry.nameLength <= m_names.size();
+			if(!inside)
+			{
+				std::cout << "Error: Pack file " << path << " is truncated or corrupt\n";
+				Close();
+				return false;
+			}
+		}
+		return true;
+	}
+
+	void PackFile::Close()
+	{
+		m_file.Close();
+		m_entries = {};
+		m_names = {};
+	}
+
+	const PackFile::Entry* PackFile::Find(std::string_view path) const
+	{
+		uint64_t hash = PackFormat::HashPath(path);
+		auto it = std::lower_bound(m_entries.begin(), m_entries.end(), hash, [](const Entry& entry, uint64_t hash) { return entry.pathHash < hash; });
+
+		// JJPack refuses colliding paths, comparing the name catches paths that aren't in the pack
+		if(it == m_entries.end() || it->pathHash != hash || GetPath(*it) != path)
+			return nullptr;
+		return &*it;
+	}
+
+	std::span<const std::byte> PackFile::GetStoredData(const Entry& entry) const
+	{
+		return m_file.GetData().subspan(entry.offset, entry.size);
+	}
+
+	bool PackFile::Read(const Entry& entry, std::vector<std::byte>& data) const
+	{
+		JJ_PROFILE_FUNCTION();
+
+		std::span<const std::byte> stored = GetStoredData(entry);
+		switch(entry.compression)
+		{
+		case PackFormat::Compression::None:
+			data.assign(stored.begin(), stored.end());
+			return true;
+#if defined(JJ_PACK_LZ4)
+		case PackFormat::Compression::LZ4:
+		{
+			data.resize(entry.originalSize);
+			int size = LZ4_decompress_safe((const char*)stored.data(), (char*)data.data(), (int)stored.size(), (int)data.size());
+			return size >= 0 && (uint64_t)size == entry.originalSize;
+		}
+#endif
+#if defined(JJ_PACK_ZSTD)
+		case PackFormat::Compression::Zstd:
+		{
+			data.resize(entry.originalSize);
+			size_t size = ZSTD_decompress(data.data(), data.size(), stored.data(), stored.size());
+			return !ZSTD_isError(size) && size == entry.originalSize;
+		}
+#endif
+		default:
+			std::cout << "Error: " << GetPath(entry) << " uses a compression this build doesn't support\n";
+			return false;
+		}
+	}
+
+	void PackFile::Prefetch(const Entry& entry) const
+	{
+		m_file.Prefetch(entry.offset, entry.size);
+	}
+}
@@ -0,0 +1,196 @@
+#include <mutex>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+#include "JJEngine/Profiler.h"
+
+namespace JJEngine {
+	namespace {
+		struct ProfileEvent {
+			const char* name;
+			int64_t start;
+			int64_t end;
+		};
+
+		constexpr uint64_t EventsPerThread = 1 << 16;
+
+		// Written only by the owning thread, read by EndSession once recording has stopped
+		struct ThreadBuffer {
+			uint32_t threadID;
+			std::string threadName;
+			std::unique_ptr<ProfileEvent[]> events;
+			std::atomic<uint64_t> writeIndex = 0;
+			// Set around each write. Paired with ProfilerData::active so that EndSession either
+			// waits for the write or the writer sees the session has ended and drops the event.
+			std::atomic<bool> writing = false;
+		};
+
+		struct ProfilerData {
+			std::mutex mutex;
+			std::vector<std::unique_ptr<ThreadBuffer>> threads;
+			std::string filePath;
+			std::atomic<bool> active = false;
+			int64_t sessionStart = 0;
+		};
+
+		ProfilerData& GetData()
+		{
+			static ProfilerData data;
+			return data;
+		}
+
+		// Buffers stay owned by the profiler so events survive the thread that recorded them
+		thread_local ThreadBuffer* t_buffer = nullptr;
+
+		ThreadBuffer& GetThreadBuffer()
+		{
+			if(t_buffer == nullptr)
+			{
+				ProfilerData& data = GetData();
+				std::lock_guard<std::mutex> lock(data.mutex);
+
+				std::unique_ptr<ThreadBuffer> buffer = std::make_unique<ThreadBuffer>();
+				buffer->threadID = (uint32_t)data.threads.size();
+				t_buffer = buffer.get();
+				data.threads.push_back(std::move(buffer));
+			}
+			return *t_buffer;
+		}
+
+		void WriteEscaped(std::ofstream& out, const char* text)
+		{
+			for(const char* c = text; *c != '\0'; c++)
+			{
+				if(*c == '"' || *c == '\\')
+					out << '\\';
+				out << *c;
+			}
+		}
+	}
+
+	void Profiler::BeginSession(const std::string& filePath)
+	{
+		ProfilerData& data = GetData();
+		if(data.active)
+			EndSession();
+
+		{
+			std::lock_guard<std::mutex> lock(data.mutex);
+			for(std::unique_ptr<ThreadBuffer>& thread : data.threads)
+				thread->writeIndex.store(0, std::memory_order_relaxed);
+
+			data.filePath = filePath;
+			data.sessionStart = GetTime();
+		}
+
+		data.active.store(true, std::memory_order_release);
+	}
+
+	void Profiler::EndSession()
+	{
+		ProfilerData& data = GetData();
+		if(!data.active.exchange(false))
+			return;
+
+		std::lock_guard<std::mutex> lock(data.mutex);
+
+		// Writers that saw the session still active finish their event before the buffers are read
+		for(std::unique_ptr<ThreadBuffer>& thread : data.threads)
+		{
+			while(thread->writing.load(std::memory_order_acquire))
+				std::this_thread::yield();
+		}
+
+		std::ofstream out(data.filePath);
+		if(!out)
+		{
+			std::cout << "Error: Failed to write profile " << data.filePath << "\n";
+			return;
+		}
+
+		out << std::fixed << std::setprecision(3);
+		out << "{\"otherData\":{},\"traceEvents\":[";
+		bool first = true;
+
+		for(std::unique_ptr<ThreadBuffer>& thread : data.threads)
+		{
+			if(!thread->threadName.empty())
+			{
+				out << (first ? "" : ",") << "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << thread->threadID << ",\"args\":{\"name\":\"";
+				WriteEscaped(out, thread->threadName.c_str());
+				out << "\"}}";
+				first = false;
+			}
+
+			if(!thread->events)
+				continue;
+
+			// Once the ring has wrapped only the newest events are left
+			uint64_t end = thread->writeIndex.load(std::memory_order_acquire);
+			uint64_t begin = end > EventsPerThread ? end - EventsPerThread : 0;
+			for(uint64_t i = begin; i < end; i++)
+			{
+				const ProfileEvent& event = thread->events[i % EventsPerThread];
+				if(event.start < data.sessionStart)
+					continue;
+
+				out << (first ? "" : ",") << "\n{\"name\":\"";
+				WriteEscaped(out, event.name);
+				out << "\",\"cat\":\"function\",\"ph\":\"X\",\"pid\":0,\"tid\":" << thread->threadID
+					<< ",\"ts\":" << (event.start - data.sessionStart) / 1000.0
+					<< ",\"dur\":" << (event.end - event.start) / 1000.0 << "}";
+				first = false;
+			}
+		}
+
+		out << "\n]}\n";
+	}
+
+	bool Profiler::IsSessionActive()
+	{
+		return GetData().active.load(std::memory_order_relaxed);
+	}
+
+	void Profiler::SetThreadName(const std::string& name)
+	{
+		ThreadBuffer& buffer = GetThreadBuffer();
+
+		std::lock_guard<std::mutex> lock(GetData().mutex);
+		buffer.threadName = name;
+	}
+
+	void Profiler::RecordEvent(const char* name, int64_t startNanoseconds, int64_t endNanoseconds)
+	{
+		if(!IsSessionActive())
+			return;
+
+		ThreadBuffer& buffer = GetThreadBuffer();
+		if(!buffer.events)
+		{
+			std::lock_guard<std::mutex> lock(GetData().mutex);
+			buffer.events = std::make_unique<ProfileEvent[]>(EventsPerThread);
+		}
+
+		// Both sides are sequentially consistent, EndSession clears active and then waits on writing
+		buffer.writing.store(true);
+		if(GetData().active.load())
+		{
+			uint64_t index = buffer.writeIndex.load(std::memory_order_relaxed);
+			buffer.events[index % EventsPerThread] = { name, startNanoseconds, endNanoseconds };
+			buffer.writeIndex.store(index + 1, std::memory_order_release);
+		}
+		buffer.writing.store(false, std::memory_order_release);
+	}
+
+	int64_t Profiler::GetTime()
+	{
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+}
@@ -0,0 +1,263 @@
+#include <array>
+#include <mutex>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <algorithm>
+#include <condition_variable>
+
+#include <GLFW/glfw3.h>
+
+#include "JJEngine/RenderThread.h"
+#include "JJEngine/Profiler.h"
+
+namespace JJEngine {
+	namespace {
+		// Initial arena size, lists grow to what the application actually records
+		constexpr size_t CommandListCapacity = 4 * 1024 * 1024;
+
+		struct RenderThreadData {
+			GLFWwindow* window = nullptr;
+
+			// framesInFlight + 1 lists are in use: one recording, the rest queued or executing
+			std::array<std::unique_ptr<RenderCommandList>, RenderThread::MaxFramesInFlight + 1> lists;
+			uint32_t listCount = 1;
+			uint32_t framesInFlight = 0;
+			uint32_t recording = 0;
+
+			std::thread thread;
+			bool running = false;
+
+			std::mutex mutex;
+			std::condition_variable condition;
+			uint64_t submittedFrames = 0;
+			uint64_t completedFrames = 0;
+			bool stopping = false;
+
+			RenderThread::Statistics stats;
+		};
+
+		RenderThreadData* s_data = nullptr;
+
+		thread_local bool t_isRenderThread = false;
+
+		void RenderLoop()
+		{
+			t_isRenderThread = true;
+			Profiler::SetThreadName("Render");
+			glfwMakeContextCurrent(s_data->window);
+
+			while(true)
+			{
+				uint64_t frame;
+				{
+					std::unique_lock<std::mutex> lock(s_data->mutex);
+					s_data->condition.wait(lock, [] { return s_data->completedFrames < s_data->submittedFrames || s_data->stopping; });
+					if(s_data->completedFrames == s_data->submittedFrames)
+						break;
+					frame = s_data->completedFrames;
+				}
+
+				RenderCommandList& list = *s_data->lists[frame % s_data->listCount];
+				uint32_t commands = (uint32_t)list.GetCommandCount();
+				AllocationStats allocation = list.GetAllocationStats();
+				size_t capacity = list.GetCapacity();
+
+				auto start = std::chrono::high_resolution_clock::now();
+				{
+					JJ_PROFILE_SCOPE("RenderThread::Execute");
+					list.Execute();
+				}
+				auto end = std::chrono::high_resolution_clock::now();
+
+				{
+					std::lock_guard<std::mutex> lock(s_data->mutex);
+					s_data->completedFrames++;
+					s_data->stats.commands = commands;
+					s_data->stats.commandBytes = allocation.bytes + allocation.overflowBytes;
+					s_data->stats.overflowBytes = allocation.overflowBytes;
+					s_data->stats.arenaCapacity = capacity;
+					s_data->stats.executeTime = std::chrono::duration<double, std::milli>(end - start).count();
+				}
+				s_data->condition.notify_all();
+			}
+
+			glfwMakeContextCurrent(nullptr);
+			t_isRenderThread = false;
+		}
+
+		void SubmitRecording()
+		{
+			{
+				std::lock_guard<std::mutex> lock(s_data->mutex);
+				s_data->submittedFrames++;
+			}
+			s_data->condition.notify_all();
+		}
+	}
+
+	RenderCommandList::RenderCommandList(size_t capacity) : m_allocator(capacity)
+	{
+	}
+
+	RenderCommandList::~RenderCommandList()
+	{
+		Reset();
+	}
+
+	void RenderCommandList::Execute()
+	{
+		for(const Command& command : m_commands)
+		{
+			command.execute(command.payload);
+			command.destroy(command.payload);
+		}
+		m_commands.clear();
+	}
+
+	void RenderCommandList::Reset()
+	{
+		for(const Command& command : m_commands)
+			command.destroy(command.payload);
+		m_commands.clear();
+
+		// Overflow blocks are freed by every Reset, so a frame that did not fit grows the arena to hold the
+		// whole frame with some headroom instead of going to the heap again next frame
+		AllocationStats stats = m_allocator.GetStats();
+		m_allocator.Reset();
+		if(stats.overflowBytes > 0)
+			m_allocator.Reserve((stats.bytes + stats.overflowBytes) * 3 / 2);
+	}
+
+	void RenderThread::Init(GLFWwindow* window)
+	{
+		if(s_data != nullptr)
+			return;
+
+		s_data = new RenderThreadData();
+		s_data->window = window;
+		for(std::unique_ptr<RenderCommandList>& list : s_data->lists)
+			list = std::make_unique<RenderCommandList>(CommandListCapacity);
+	}
+
+	void RenderThread::Shutdown()
+	{
+		if(s_data == nullptr)
+			return;
+
+		Stop();
+
+		delete s_data;
+		s_data = nullptr;
+	}
+
+	void RenderThread::Start(uint32_t framesInFlight)
+	{
+		if(s_data == nullptr || s_data->running)
+			return;
+
+		s_data->framesInFlight = std::min(framesInFlight, MaxFramesInFlight);
+		s_data->listCount = s_data->framesInFlight + 1;
+		s_data->recording = 0;
+		s_data->submittedFrames = 0;
+		s_data->completedFrames = 0;
+		s_data->stopping = false;
+		s_data->stats = Statistics();
+		for(std::unique_ptr<RenderCommandList>& list : s_data->lists)
+			list->Reset();
+
+		if(s_data->framesInFlight == 0)
+			return;
+
+		// A context can only be current on one thread at a time
+		glfwMakeContextCurrent(nullptr);
+		s_data->running = true;
+		s_data->thread = std::thread(RenderLoop);
+	}
+
+	void RenderThread::Stop()
+	{
+		if(s_data == nullptr || !s_data->running)
+			return;
+
+		SubmitRecording();
+		{
+			std::lock_guard<std::mutex> lock(s_data->mutex);
+			s_data->stopping = true;
+		}
+		s_data->condition.notify_all();
+		s_data->thread.join();
+
+		s_data->running = false;
+		glfwMakeContextCurrent(s_data->window);
+	}
+
+	bool RenderThread::IsRunning()
+	{
+		return s_data != nullptr && s_data->running;
+	}
+
+	bool RenderThread::IsRenderThread()
+	{
+		return t_isRenderThread;
+	}
+
+	RenderCommandList* RenderThread::GetRecordingList()
+	{
+		if(!IsRunning() || t_isRenderThread)
+			return nullptr;
+		return s_data->lists[s_data->recording].get();
+	}
+
+	void* RenderThread::Allocate(size_t size, size_t alignment)
+	{
+		// Commands run inline when not threaded, the recording list then only serves as scratch memory
+		return s_data->lists[s_data->recording]->Allocate(size, alignment);
+	}
+
+	void RenderThread::EndFrame()
+	{
+		if(s_data == nullptr)
+			return;
+
+		if(!s_data->running)
+		{
+			s_data->lists[s_data->recording]->Reset();
+			return;
+		}
+
+		JJ_PROFILE_FUNCTION();
+
+		SubmitRecording();
+
+		auto start = std::chrono::high_resolution_clock::now();
+		{
+			std::unique_lock<std::mutex> lock(s_data->mutex);
+			s_data->condition.wait(lock, [] { return s_data->submittedFrames - s_data->completedFrames <= s_data->framesInFlight; });
+		}
+		auto end = std::chrono::high_resolution_clock::now();
+
+		{
+			std::lock_guard<std::mutex> lock(s_data->mutex);
+			s_data->stats.submitWaitTime = std::chrono::duration<double, std::milli>(end - start).count();
+		}
+
+		// The list recorded framesInFlight + 1 frames ago has finished executing by now
+		s_data->recording = (uint32_t)(s_data->submittedFrames % s_data->listCount);
+		s_data->lists[s_data->recording]->Reset();
+	}
+
+	uint32_t RenderThread::GetFramesInFlight()
+	{
+		return s_data != nullptr ? s_data->framesInFlight : 0;
+	}
+
+	RenderThread::Statistics RenderThread::GetStats()
+	{
+		if(s_data == nullptr)
+			return Statistics();
+
+		std::lock_guard<std::mutex> lock(s_data->mutex);
+		return s_data->stats;
+	}
+}
@@ -0,0 +1,434 @@
+#include <array>
+#include <string>
+#include <cstddef>
+#include <mutex>
+#include <memory>
+#include <cstring>
+#include <algorithm>
+
+#include "JJEngine/Renderer2D.h"
+#include "JJEngine/Shader.h"
+#include "JJEngine/Texture.h"
+#include "JJEngine/StreamBuffer.h"
+#include "JJEngine/UniformBuffer.h"
+#include "JJEngine/Profiler.h"
+#include "JJEngine/GpuProfiler.h"
+#include "JJEngine/RenderThread.h"
+#include "JJEngine/GLState.h"
+
+namespace JJEngine {
+	namespace {
+		struct QuadVertex {
+			glm::vec3 position;
+			uint32_t color;
+			glm::vec2 texCoord;
+			uint32_t texIndex;
+		};
+
+		constexpr uint32_t MaxVertices = Renderer2D::MaxQuadsPerBatch * 4;
+		constexpr uint32_t MaxIndices = Renderer2D::MaxQuadsPerBatch * 6;
+		static_assert(MaxVertices - 1 <= UINT16_MAX, "Quad indices must fit in 16 bits");
+
+		// Each stream region holds several full batches so a busy frame doesn't wrap onto regions still in flight
+		constexpr uint32_t BatchesPerStreamRegion = 8;
+
+		struct CameraData {
+			glm::mat4 viewProjection;
+		};
+		JJ_BUFFER_MEMBER(CameraData, viewProjection, BufferLayout::Std140);
+
+		const glm::vec2 QuadTexCoords[4] = { { 0.0f, 0.0f }, { 1.0f, 0.0f }, { 1.0f, 1.0f }, { 0.0f, 1.0f } };
+
+		const char* QuadVertexSource = R"(#version 450 core
+layout (location = 0) in vec3 aPosition;
+layout (location = 1) in vec4 aColor;
+layout (location = 2) in vec2 aTexCoord;
+layout (location = 3) in uint aTexIndex;
+
+layout (std140) uniform Camera
+{
+	mat4 uViewProjection;
+};
+
+out vec4 vColor;
+out vec2 vTexCoord;
+flat out uint vTexIndex;
+
+void main()
+{
+	vColor = aColor;
+	vTexCoord = aTexCoord;
+	vTexIndex = aTexIndex;
+	gl_Position = uViewProjection * vec4(aPosition, 1.0);
+}
+)";
+
+		// Slots are bound to texture units 0-15, or set to resident handles with ARB_bindless_texture
+		const char* BoundSamplersSource = R"(#version 450 core
+layout (binding = 0) uniform sampler2D uTextures[16];
+)";
+
+		const char* BindlessSamplersSource = R"(#version 450 core
+#extension GL_ARB_bindless_texture : require
+layout (location = 0, bindless_sampler) uniform sampler2D uTextures[16];
+)";
+		constexpr GLint BindlessSamplersLocation = 0;
+
+		// Sampler arrays may only be indexed with dynamically uniform values,
+		// so the slot is selected with a switch instead
+		const char* QuadFragmentSource = R"(
+layout (location = 0) out vec4 FragColor;
+
+in vec4 vColor;
+in vec2 vTexCoord;
+flat in uint vTexIndex;
+
+void main()
+{
+	vec4 texColor = vec4(1.0);
+	switch(vTexIndex)
+	{
+		case  0: texColor = texture(uTextures[ 0], vTexCoord); break;
+		case  1: texColor = texture(uTextures[ 1], vTexCoord); break;
+		case  2: texColor = texture(uTextures[ 2], vTexCoord); break;
+		case  3: texColor = texture(uTextures[ 3], vTexCoord); break;
+		case  4: texColor = texture(uTextures[ 4], vTexCoord); break;
+		case  5: texColor = texture(uTextures[ 5], vTexCoord); break;
+		case  6: texColor = texture(uTextures[ 6], vTexCoord); break;
+		case  7: texColor = texture(uTextures[ 7], vTexCoord); break;
+		case  8: texColor = texture(uTextures[ 8], vTexCoord); break;
+		case  9: texColor = texture(uTextures[ 9], vTexCoord); break;
+		case 10: texColor = texture(uTextures[10], vTexCoord); break;
+		case 11: texColor = texture(uTextures[11], vTexCoord); break;
+		case 12: texColor = texture(uTextures[12], vTexCoord); break;
+		case 13: texColor = texture(uTextures[13], vTexCoord); break;
+		case 14: texColor = texture(uTextures[14], vTexCoord); break;
+		case 15: texColor = texture(uTextures[15], vTexCoord); break;
+	}
+	FragColor = texColor * vColor;
+}
+)";
+
+		struct Renderer2DData {
+			GLuint vertexArray = 0;
+			GLuint indexBuffer = 0;
+			std::unique_ptr<StreamBuffer> vertexStream;
+			std::unique_ptr<Texture2D> whiteTexture;
+
+			std::unique_ptr<Shader> quadShader;
+			std::unique_ptr<Shader> bindlessQuadShader; // Null without ARB_bindless_texture
+			std::unique_ptr<UniformBuffer<CameraData>> cameraBuffer;
+
+			std::unique_ptr<QuadVertex[]> vertexBufferBase;
+			QuadVertex* vertexBufferPtr = nullptr;
+			uint32_t quadCount = 0;
+
+			std::array<GLuint, Renderer2D::MaxTextureSlots> textureSlots{};
+			std::array<Texture*, Renderer2D::MaxTextureSlots> textureObjects{}; // Null for raw texture names
+			uint32_t textureSlotCount = 1; // Slot 0 is always the white texture
+
+			Renderer2D::Statistics stats;
+
+			// Copied out of the stream by whichever thread owns the context, read from the main thread
+			std::mutex streamStatsMutex;
+			StreamBuffer::Statistics streamStats;
+		};
+
+		Renderer2DData* s_data = nullptr;
+
+		uint32_t PackColor(const glm::vec4& color)
+		{
+			uint32_t r = (uint32_t)(std::clamp(color.x, 0.0f, 1.0f) * 255.0f + 0.5f);
+			uint32_t g = (uint32_t)(std::clamp(color.y, 0.0f, 1.0f) * 255.0f + 0.5f);
+			uint32_t b = (uint32_t)(std::clamp(color.z, 0.0f, 1.0f) * 255.0f + 0.5f);
+			uint32_t a = (uint32_t)(std::clamp(color.w, 0.0f, 1.0f) * 255.0f + 0.5f);
+			return r | (g << 8) | (b << 16) | (a << 24);
+		}
+
+		void StartBatch()
+		{
+			s_data->vertexBufferPtr = s_data->vertexBufferBase.get();
+			s_data->quadCount = 0;
+			s_data->textureSlotCount = 1;
+		}
+
+		uint32_t GetTextureSlot(GLuint textureID, Texture* texture)
+		{
+			if(textureID == 0 || textureID == s_data->whiteTexture->GetRendererID())
+				return 0;
+
+			for(uint32_t i = 1; i < s_data->textureSlotCount; i++)
+			{
+				if(s_data->textureSlots[i] == textureID)
+				{
+					// The same texture passed by name and as an object, only the object can go bindless
+					if(s_data->textureObjects[i] == nullptr)
+						s_data->textureObjects[i] = texture;
+					return i;
+				}
+			}
+
+			if(s_data->textureSlotCount == Renderer2D::MaxTextureSlots)
+			{
+				Renderer2D::Flush();
+				StartBatch();
+			}
+
+			uint32_t slot = s_data->textureSlotCount++;
+			s_data->textureSlots[slot] = textureID;
+			s_data->textureObjects[slot] = texture;
+			return slot;
+		}
+
+		// Texture slot lookup may flush, so it has to happen before the batch space check
+		void SubmitQuad(const glm::vec3 (&corners)[4], uint32_t color, GLuint textureID, Texture* texture = nullptr)
+		{
+			uint32_t texIndex = GetTextureSlot(textureID, texture);
+
+			if(s_data->quadCount == Renderer2D::MaxQuadsPerBatch)
+			{
+				Renderer2D::Flush();
+				StartBatch();
+				texIndex = GetTextureSlot(textureID, texture);
+			}
+
+			QuadVertex* vertex = s_data->vertexBufferPtr;
+			for(int i = 0; i < 4; i++)
+			{
+				vertex[i].position = corners[i];
+				vertex[i].color = color;
+				vertex[i].texCoord = QuadTexCoords[i];
+				vertex[i].texIndex = texIndex;
+			}
+
+			s_data->vertexBufferPtr += 4;
+			s_data->quadCount++;
+			s_data->stats.quadCount++;
+		}
+
+		// Axis aligned quads skip the matrix multiply entirely
+		void SubmitAxisAlignedQuad(const glm::vec3& position, const glm::vec2& size, uint32_t color, GLuint textureID, Texture* texture = nullptr)
+		{
+			float halfWidth = size.x * 0.5f;
+			float halfHeight = size.y * 0.5f;
+
+			const glm::vec3 corners[4] = {
+				{ position.x - halfWidth, position.y - halfHeight, position.z },
+				{ position.x + halfWidth, position.y - halfHeight, position.z },
+				{ position.x + halfWidth, position.y + halfHeight, position.z },
+				{ position.x - halfWidth, position.y + halfHeight, position.z },
+			};
+
+			SubmitQuad(corners, color, textureID, texture);
+		}
+	}
+
+	void Renderer2D::Init()
+	{
+		if(s_data != nullptr)
+			return;
+
+		s_data = new Renderer2DData();
+		s_data->vertexBufferBase = std::make_unique<QuadVertex[]>(MaxVertices);
+
+		s_data->vertexStream = std::make_unique<StreamBuffer>(MaxVertices * sizeof(QuadVertex) * BatchesPerStreamRegion);
+
+		// Index pattern never changes, so it is generated once and kept on the GPU
+		std::unique_ptr<uint16_t[]> indices = std::make_unique<uint16_t[]>(MaxIndices);
+		for(uint32_t i = 0, offset = 0; i < MaxIndices; i += 6, offset += 4)
+		{
+			indices[i + 0] = (uint16_t)(offset + 0);
+			indices[i + 1] = (uint16_t)(offset + 1);
+			indices[i + 2] = (uint16_t)(offset + 2);
+			indices[i + 3] = (uint16_t)(offset + 2);
+			indices[i + 4] = (uint16_t)(offset + 3);
+			indices[i + 5] = (uint16_t)(offset + 0);
+		}
+
+		glCreateBuffers(1, &s_data->indexBuffer);
+		glNamedBufferStorage(s_data->indexBuffer, MaxIndices * sizeof(uint16_t), indices.get(), 0);
+
+		glCreateVertexArrays(1, &s_data->vertexArray);
+		glVertexArrayVertexBuffer(s_data->vertexArray, 0, s_data->vertexStream->GetRendererID(), 0, sizeof(QuadVertex));
+		glVertexArrayElementBuffer(s_data->vertexArray, s_data->indexBuffer);
+
+		glEnableVertexArrayAttrib(s_data->vertexArray, 0);
+		glVertexArrayAttribFormat(s_data->vertexArray, 0, 3, GL_FLOAT, GL_FALSE, offsetof(QuadVertex, position));
+		glVertexArrayAttribBinding(s_data->vertexArray, 0, 0);
+
+		glEnableVertexArrayAttrib(s_data->vertexArray, 1);
+		glVertexArrayAttribFormat(s_data->vertexArray, 1, 4, GL_UNSIGNED_BYTE, GL_TRUE, offsetof(QuadVertex, color));
+		glVertexArrayAttribBinding(s_data->vertexArray, 1, 0);
+
+		glEnableVertexArrayAttrib(s_data->vertexArray, 2);
+		glVertexArrayAttribFormat(s_data->vertexArray, 2, 2, GL_FLOAT, GL_FALSE, offsetof(QuadVertex, texCoord));
+		glVertexArrayAttribBinding(s_data->vertexArray, 2, 0);
+
+		glEnableVertexArrayAttrib(s_data->vertexArray, 3);
+		glVertexArrayAttribIFormat(s_data->vertexArray, 3, 1, GL_UNSIGNED_INT, offsetof(QuadVertex, texIndex));
+		glVertexArrayAttribBinding(s_data->vertexArray, 3, 0);
+
+		uint32_t white = 0xffffffff;
+		s_data->whiteTexture = std::make_unique<Texture2D>(1, 1, TextureFormat::RGBA8, 1);
+		s_data->whiteTexture->SetData(&white);
+		s_data->textureSlots[0] = s_data->whiteTexture->GetRendererID();
+		s_data->textureObjects[0] = s_data->whiteTexture.get();
+
+		s_data->cameraBuffer = std::make_unique<UniformBuffer<CameraData>>("Camera");
+
+		s_data->quadShader = std::make_unique<Shader>();
+		s_data->quadShader->LoadFromSource(QuadVertexSource, (std::string(BoundSamplersSource) + QuadFragmentSource).c_str());
+
+		if(Texture::IsBindlessSupported())
+		{
+			s_data->bindlessQuadShader = std::make_unique<Shader>();
+			s_data->bindlessQuadShader->LoadFromSource(QuadVertexSource, (std::string(BindlessSamplersSource) + QuadFragmentSource).c_str());
+		}
+
+		GLState::SetBlend(true);
+		GLState::SetBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	}
+
+	void Renderer2D::Shutdown()
+	{
+		if(s_data == nullptr)
+			return;
+
+		GLState::DeleteVertexArray(s_data->vertexArray);
+		GLState::DeleteBuffer(s_data->indexBuffer);
+
+		delete s_data;
+		s_data = nullptr;
+	}
+
+	void Renderer2D::BeginScene(const glm::mat4& viewProjection)
+	{
+		RenderThread::Submit([viewProjection]()
+		{
+			s_data->cameraBuffer->Set(&CameraData::viewProjection, viewProjection);
+			s_data->cameraBuffer->Upload();
+			s_data->cameraBuffer->Bind();
+		});
+
+		StartBatch();
+	}
+
+	void Renderer2D::EndScene()
+	{
+		JJ_PROFILE_FUNCTION();
+
+		Flush();
+		StartBatch();
+
+		RenderThread::Submit([]()
+		{
+			s_data->vertexStream->EndFrame();
+
+			std::lock_guard<std::mutex> lock(s_data->streamStatsMutex);
+			s_data->streamStats = s_data->vertexStream->GetStats();
+		});
+	}
+
+	void Renderer2D::Flush()
+	{
+		if(s_data->quadCount == 0)
+			return;
+
+		JJ_PROFILE_FUNCTION();
+		GpuProfileScope gpuScope("Renderer2D");
+
+		// The batch buffer is reused as soon as this returns, so the vertices travel with the command
+		size_t size = (uint8_t*)s_data->vertexBufferPtr - (uint8_t*)s_data->vertexBufferBase.get();
+		void* vertices = RenderThread::Allocate(size, alignof(QuadVertex));
+		std::memcpy(vertices, s_data->vertexBufferBase.get(), size);
+
+		uint32_t textureSlotCount = s_data->textureSlotCount;
+		bool bindless = s_data->bindlessQuadShader != nullptr
+			&& std::none_of(s_data->textureObjects.begin(), s_data->textureObjects.begin() + textureSlotCount, [](Texture* texture) { return texture == nullptr; });
+
+		RenderThread::Submit([vertices, size, quadCount = s_data->quadCount, textureSlotCount, bindless,
+			textureSlots = s_data->textureSlots, textureObjects = s_data->textureObjects]()
+		{
+			StreamBuffer::Allocation allocation = s_data->vertexStream->Allocate(size, sizeof(QuadVertex));
+			std::memcpy(allocation.data, vertices, size);
+			GLint baseVertex = (GLint)(allocation.offset / sizeof(QuadVertex));
+
+			if(bindless)
+			{
+				// Handles are made resident once per texture and stay valid, only the uniform changes per batch
+				std::array<uint64_t, MaxTextureSlots> handles;
+				for(uint32_t i = 0; i < textureSlotCount; i++)
+					handles[i] = textureObjects[i]->GetBindlessHandle();
+				Texture::SetSamplerHandles(s_data->bindlessQuadShader->GetRendererID(), BindlessSamplersLocation, textureSlotCount, handles.data());
+				s_data->bindlessQuadShader->Use();
+			}
+			else
+			{
+				GLState::BindTextures(0, textureSlotCount, textureSlots.data());
+				s_data->quadShader->Use();
+			}
+
+			GLState::BindVertexArray(s_data->vertexArray);
+			glDrawElementsBaseVertex(GL_TRIANGLES, quadCount * 6, GL_UNSIGNED_SHORT, nullptr, baseVertex);
+		});
+
+		s_data->stats.drawCalls++;
+		if(bindless)
+			s_data->stats.bindlessDrawCalls++;
+	}
+
+	void Renderer2D::DrawQuad(const glm::vec2& position, const glm::vec2& size, const glm::vec4& color)
+	{
+		DrawQuad(glm::vec3(position, 0.0f), size, color);
+	}
+
+	void Renderer2D::DrawQuad(const glm::vec3& position, const glm::vec2& size, const glm::vec4& color)
+	{
+		DrawQuad(position, size, 0, color);
+	}
+
+	void Renderer2D::DrawQuad(const glm::vec3& position, const glm::vec2& size, GLuint textureID, const glm::vec4& tint)
+	{
+		SubmitAxisAlignedQuad(position, size, PackColor(tint), textureID);
+	}
+
+	void Renderer2D::DrawQuad(const glm::vec3& position, const glm::vec2& size, Texture& texture, const glm::vec4& tint)
+	{
+		SubmitAxisAlignedQuad(position, size, PackColor(tint), texture.GetRendererID(), &texture);
+	}
+
+	void Renderer2D::DrawQuad(const glm::mat4& transform, const glm::vec4& color, GLuint textureID)
+	{
+		const glm::vec4 localCorners[4] = {
+			{ -0.5f, -0.5f, 0.0f, 1.0f },
+			{  0.5f, -0.5f, 0.0f, 1.0f },
+			{  0.5f,  0.5f, 0.0f, 1.0f },
+			{ -0.5f,  0.5f, 0.0f, 1.0f },
+		};
+
+		glm::vec3 corners[4];
+		for(int i = 0; i < 4; i++)
+		{
+			glm::vec4 corner = transform * localCorners[i];
+			corners[i] = glm::vec3(corner.x, corner.y, corner.z);
+		}
+
+		SubmitQuad(corners, PackColor(color), textureID);
+	}
+
+	const Renderer2D::Statistics& Renderer2D::GetStats()
+	{
+		return s_data->stats;
+	}
+
+	StreamBuffer::Statistics Renderer2D::GetStreamStats()
+	{
+		std::lock_guard<std::mutex> lock(s_data->streamStatsMutex);
+		return s_data->streamStats;
+	}
+
+	void Renderer2D::ResetStats()
+	{
+		s_data->stats = Statistics();
+	}
+}
@@ -1,27 +1,21 @@
 #include <string>
-#include <fstream>
-#include <sstream>
+#include <algorithm>
 #include <iostream>
+#include <stdexcept>
+
+#include <glm/gtc/type_ptr.hpp>
 
 #include "JJEngine/Shader.h"
+#include "JJEngine/ShaderCache.h"
+#include "JJEngine/UniformBuffer.h"
+#include "JJEngine/Profiler.h"
+#include "JJEngine/GLState.h"
+#include "JJEngine/ShaderReloader.h"
+#include "JJEngine/ShaderPreprocessor.h"
+#include "JJEngine/RenderThread.h"
 
 using namespace JJEngine;
 
-std::string GetFileContents(const char* fileName)
-{
-	std::ifstream in(fileName, std::ios::binary);
-	if (in) {
-		std::string contents;
-		in.seekg(0, std::ios::end);
-		contents.resize(in.tellg());
-		in.seekg(0, std::ios::beg);
-		in.read(&contents[0], contents.size());
-		in.close();
-		return(contents);
-	}
-	return {};
-}
-
 GLuint CompileShader(const char* source, GLenum type)
 {
 	GLuint id = glCreateShader(type);
@@ -35,7 +29,8 @@ GLuint CompileShader(const char* source, GLenum type)
 		glGetShaderiv(id, GL_INFO_LOG_LENGTH, &length);
 		char* message = (char*)alloca(length * sizeof(char));
 		glGetShaderInfoLog(id, length, &length, message);
-		std::cout << "Failed to compile " << (type == GL_VERTEX_SHADER ? "vertex" : "fragment") << " shader!\n";
+		const char* stage = type == GL_VERTEX_SHADER ? "vertex" : type == GL_FRAGMENT_SHADER ? "fragment" : "compute";
+		std::cout << "Failed to compile " << stage << " shader!\n";
 		std::cout << message << "\n";
 		glDeleteShader(id);
 		return -1;
@@ -44,65 +39,262 @@ GLuint CompileShader(const char* source, GLenum type)
 	return id;
 }
 
-Shader::Shader(const char* vertexPath, const char* fragmentPath) : m_vertexPath(vertexPath), m_fragmentPath(fragmentPath)
+Shader::Shader()
+{
+}
+
+Shader::Shader(const char* vertexPath, const char* fragmentPath, std::string defines)
+	: m_vertexPath(vertexPath), m_fragmentPath(fragmentPath), m_defines(std::move(defines))
 {
 	Load();
 }
 
 Shader::~Shader()
 {
-	glDeleteProgram(m_rendererID);
+	ShaderReloader::Unregister(*this);
+	GLState::DeleteProgram(m_rendererID);
 }
 
-GLint Shader::GetUniformLocation(const char* name)
+void Shader::ReflectUniforms()
 {
-	if (m_uniformLocationCache.contains(name))
-		return m_uniformLocationCache[name];
+	JJ_PROFILE_FUNCTION();
 
-	int location = glGetUniformLocation(m_rendererID, name);
-	if (location == -1)
-		std::cout << "Warning: uniform '" << name << "' doesn't exist!\n";
+	GLint uniformCount = 0, maxNameLength = 0;
+	glGetProgramiv(m_rendererID, GL_ACTIVE_UNIFORMS, &uniformCount);
+	glGetProgramiv(m_rendererID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxNameLength);
 
-	m_uniformLocationCache[name] = location;
-	return location;
+	std::vector<UniformSlot> uniforms;
+	std::string name(maxNameLength, '\0');
+	for(GLint i = 0; i < uniformCount; i++)
+	{
+		GLsizei length = 0;
+		GLint size = 0;
+		GLenum type = 0;
+		glGetActiveUniform(m_rendererID, i, maxNameLength, &length, &size, &type, name.data());
+
+		std::string uniformName(name.data(), length);
+		GLint location = glGetUniformLocation(m_rendererID, uniformName.c_str());
+		if(location == -1) // Uniform block members have no location
+			continue;
+
+		// Arrays are reported as "name[0]", register the bare name and every element
+		if(uniformName.ends_with("[0]"))
+		{
+			std::string baseName = uniformName.substr(0, uniformName.size() - 3);
+			uniforms.push_back({ HashFnv1a64(baseName), location, baseName });
+			for(GLint element = 0; element < size; element++)
+			{
+				std::string elementName = baseName + "[" + std::to_string(element) + "]";
+				GLint elementLocation = glGetUniformLocation(m_rendererID, elementName.c_str());
+				if(elementLocation != -1)
+					uniforms.push_back({ HashFnv1a64(elementName), elementLocation, elementName });
+			}
+		}
+		else
+		{
+			uniforms.push_back({ HashFnv1a64(uniformName), location, uniformName });
+		}
+	}
+
+	// Load factor of at most one half keeps probe sequences short and guarantees an empty slot.
+	// Arrays register every element, so this can hold thousands of uniforms in linear memory.
+	size_t tableSize = 1;
+	while(tableSize < uniforms.size() * 2)
+		tableSize <<= 1;
+
+	std::vector<UniformSlot> table(tableSize);
+	uint64_t mask = tableSize - 1;
+	for(UniformSlot& uniform : uniforms)
+	{
+		uint64_t index = uniform.hash & mask;
+		while(table[index].location != -1)
+			index = (index + 1) & mask;
+		table[index] = std::move(uniform);
+	}
+
+	m_uniformTable = std::move(table);
+	m_uniformTableMask = mask;
+}
+
+void Shader::ReflectBlocks()
+{
+	// Point every block at the binding shared by all programs declaring a block of that name
+	for(GLenum interface : { GL_UNIFORM_BLOCK, GL_SHADER_STORAGE_BLOCK })
+	{
+		GLenum target = interface == GL_UNIFORM_BLOCK ? GL_UNIFORM_BUFFER : GL_SHADER_STORAGE_BUFFER;
+
+		GLint blockCount = 0, maxNameLength = 0;
+		glGetProgramInterfaceiv(m_rendererID, interface, GL_ACTIVE_RESOURCES, &blockCount);
+		glGetProgramInterfaceiv(m_rendererID, interface, GL_MAX_NAME_LENGTH, &maxNameLength);
+
+		std::string name(maxNameLength, '\0');
+		for(GLint i = 0; i < blockCount; i++)
+		{
+			GLsizei length = 0;
+			glGetProgramResourceName(m_rendererID, interface, i, maxNameLength, &length, name.data());
+			std::string_view blockName(name.data(), length);
+
+			// A program that can't get a binding still links, its block just stays unbound
+			GLuint bindingPoint;
+			try
+			{
+				bindingPoint = BufferBindings::GetBindingPoint(blockName, target);
+			}
+			catch(const std::runtime_error& error)
+			{
+				std::cout << "Error: " << error.what() << "\n";
+				continue;
+			}
+
+			if(interface == GL_UNIFORM_BLOCK)
+				glUniformBlockBinding(m_rendererID, i, bindingPoint);
+			else
+				glShaderStorageBlockBinding(m_rendererID, i, bindingPoint);
+
+			// Storage blocks ending in a runtime sized array report their minimum size, which drivers
+			// may round up (Mesa pads it to 16 bytes), so only a shortfall beyond that counts
+			const GLenum property = GL_BUFFER_DATA_SIZE;
+			GLint dataSize = 0;
+			glGetProgramResourceiv(m_rendererID, interface, i, 1, &property, 1, nullptr, &dataSize);
+
+			size_t blockSize = BufferBindings::GetBlockSize(blockName, target);
+			bool mismatch = interface == GL_UNIFORM_BLOCK ? blockSize != (size_t)dataSize : (blockSize + 15) / 16 * 16 < (size_t)dataSize;
+			if(blockSize != 0 && mismatch)
+				std::cout << "Warning: block '" << blockName << "' is " << dataSize << " bytes in the shader but " << blockSize << " bytes in C++\n";
+		}
+	}
 }
 
 void Shader::Use() const
 {
-	glUseProgram(m_rendererID);
+	GLState::UseProgram(m_rendererID);
 }
 
 void Shader::Load()
 {
-	if(m_rendererID != 0)
-		glDeleteProgram(m_rendererID);
+	JJ_PROFILE_FUNCTION();
 
-	std::string vertexCode = GetFileContents(m_vertexPath);
-	std::string fragmentCode = GetFileContents(m_fragmentPath);
+	PreprocessedSource vertex = ShaderPreprocessor::Process(m_vertexPath);
+	PreprocessedSource fragment = ShaderPreprocessor::Process(m_fragmentPath);
 
-	if(vertexCode.empty() || fragmentCode.empty())
+	// Registered even if loading fails, fixing or creating the missing file then loads it
+	std::vector<std::string> dependencies = vertex.dependencies;
+	for(const std::string& path : fragment.dependencies)
 	{
-		std::cout << "Error: Shader file not found\n";
+		if(std::find(dependencies.begin(), dependencies.end(), path) == dependencies.end())
+			dependencies.push_back(path);
+	}
+	ShaderReloader::Register(*this, dependencies);
+
+	if(!vertex.succeeded || !fragment.succeeded)
+	{
+		std::cout << "Error: Failed to load shader " << m_vertexPath << " + " << m_fragmentPath << "\n";
 		return;
 	}
 
-	const char* vShaderCode = vertexCode.c_str();
-	const char* fShaderCode = fragmentCode.c_str();
+	LoadVertexFragment(std::move(vertex.source), std::move(fragment.source), HashCombine64(vertex.hash, fragment.hash));
+}
 
-	GLuint vertex, fragment;
+std::string Shader::InjectDefines(std::string_view source, std::string_view defines)
+{
+	if(defines.empty())
+		return std::string(source);
 
-	vertex = CompileShader(vShaderCode, GL_VERTEX_SHADER);
-	fragment = CompileShader(fShaderCode, GL_FRAGMENT_SHADER);
+	// #version has to stay the first statement, defines go right after it
+	size_t insertAt = 0;
+	size_t version = source.find("#version");
+	if(version != std::string_view::npos)
+	{
+		size_t lineEnd = source.find('\n', version);
+		insertAt = lineEnd == std::string_view::npos ? source.size() : lineEnd + 1;
+	}
+
+	// Keeps compiler messages pointing at the lines of the original file
+	size_t nextLine = std::count(source.begin(), source.begin() + insertAt, '\n') + 1;
+
+	std::string result;
+	result.reserve(source.size() + defines.size() + 16);
+	result.append(source.substr(0, insertAt));
+	if(insertAt > 0 && source[insertAt - 1] != '\n')
+		result += '\n';
+	result.append(defines);
+	if(defines.back() != '\n')
+		result += '\n';
+	result += "#line " + std::to_string(nextLine) + "\n";
+	result.append(source.substr(insertAt));
+	return result;
+}
+
+void Shader::LoadFromSource(const char* vShaderCode, const char* fShaderCode)
+{
+	uint64_t sourceHash = HashCombine64(HashFnv1a64(vShaderCode), HashFnv1a64(fShaderCode));
+	LoadVertexFragment(vShaderCode, fShaderCode, sourceHash);
+}
 
-	if(vertex == 0 || fragment == 0)
+// Compiled through RenderThread, so variants can be created while a frame is being recorded.
+// Cache keys cover the sources as written plus the defines.
+void Shader::LoadVertexFragment(std::string vertexSource, std::string fragmentSource, uint64_t sourceHash)
+{
+	RenderThread::Submit([this, vertexSource = std::move(vertexSource), fragmentSource = std::move(fragmentSource), sourceHash]()
 	{
-		std::cout << "Error: Shader compilation failed\n";
-		return;
+		JJ_PROFILE_SCOPE("Shader::LoadFromSource");
+
+		std::string vertexCode = InjectDefines(vertexSource, m_defines);
+		std::string fragmentCode = InjectDefines(fragmentSource, m_defines);
+
+		const ShaderStage stages[] = { { vertexCode.c_str(), GL_VERTEX_SHADER }, { fragmentCode.c_str(), GL_FRAGMENT_SHADER } };
+		LoadStages(stages, 2, ShaderCache::ComputeKey(sourceHash, m_defines));
+	});
+}
+
+void Shader::LoadComputeFromSource(const char* cShaderCode)
+{
+	RenderThread::Submit([this, computeSource = std::string(cShaderCode)]()
+	{
+		JJ_PROFILE_SCOPE("Shader::LoadComputeFromSource");
+
+		std::string computeCode = InjectDefines(computeSource, m_defines);
+
+		const ShaderStage stages[] = { { computeCode.c_str(), GL_COMPUTE_SHADER } };
+		LoadStages(stages, 1, ShaderCache::ComputeKey({ computeSource }, m_defines));
+	});
+}
+
+void Shader::LoadStages(const ShaderStage* stages, uint32_t stageCount, uint64_t cacheKey)
+{
+	if(m_rendererID != 0)
+	{
+		GLState::DeleteProgram(m_rendererID);
+		m_rendererID = 0;
 	}
+	m_uniformTable.assign(1, UniformSlot());
+	m_uniformTableMask = 0;
 
 	m_rendererID = glCreateProgram();
-	glAttachShader(m_rendererID, vertex);
-	glAttachShader(m_rendererID, fragment);
+	if(ShaderCache::Load(cacheKey, m_rendererID))
+	{
+		ReflectUniforms();
+		ReflectBlocks();
+		std::cout << "Shader loaded from cache\n";
+		return;
+	}
+
+	GLuint shaders[2] = {};
+	for(uint32_t i = 0; i < stageCount; i++)
+	{
+		shaders[i] = CompileShader(stages[i].source, stages[i].type);
+		if(shaders[i] == (GLuint)-1)
+		{
+			std::cout << "Error: Shader compilation failed\n";
+			for(uint32_t j = 0; j < i; j++)
+				glDeleteShader(shaders[j]);
+			return;
+		}
+	}
+
+	glProgramParameteri(m_rendererID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+	for(uint32_t i = 0; i < stageCount; i++)
+		glAttachShader(m_rendererID, shaders[i]);
 	glLinkProgram(m_rendererID);
 
 	int success;
@@ -113,12 +305,34 @@ void Shader::Load()
 		std::cout << "Error: Shader program linking failed\n" << infoLog << "\n";
 	}
 
-	glDeleteShader(vertex);
-	glDeleteShader(fragment);
+	for(uint32_t i = 0; i < stageCount; i++)
+	{
+		glDetachShader(m_rendererID, shaders[i]);
+		glDeleteShader(shaders[i]);
+	}
+
+	if(success)
+	{
+		ShaderCache::Store(cacheKey, m_rendererID);
+		ReflectUniforms();
+		ReflectBlocks();
+	}
 
 	std::cout << "Shader loaded successfully\n";
 }
 
+void Shader::AdoptProgram(GLuint program)
+{
+	if(m_rendererID != 0)
+		GLState::DeleteProgram(m_rendererID);
+
+	m_rendererID = program;
+	m_uniformTable.assign(1, UniformSlot());
+	m_uniformTableMask = 0;
+	ReflectUniforms();
+	ReflectBlocks();
+}
+
 void Shader::Load(const char* vertexPath, const char* fragmentPath)
 {
 	m_vertexPath = vertexPath;
@@ -126,57 +340,62 @@ void Shader::Load(const char* vertexPath, const char* fragmentPath)
 	Load();
 }
 
-void Shader::SetUniform1i(const char* name, int value)
+void Shader::SetUniform1i(UniformName name, int value)
 {
 	glUniform1i(GetUniformLocation(name), value);
 }
 
-void Shader::SetUniform2i(const char* name, int v0, int v1)
+void Shader::SetUniform2i(UniformName name, int v0, int v1)
 {
 	glUniform2i(GetUniformLocation(name), v0, v1);
 }
 
-void Shader::SetUniform3i(const char* name, int v0, int v1, int v2)
+void Shader::SetUniform3i(UniformName name, int v0, int v1, int v2)
 {
 	glUniform3i(GetUniformLocation(name), v0, v1, v2);
 }
 
-void Shader::SetUniform4i(const char* name, int v0, int v1, int v2, int v3)
+void Shader::SetUniform4i(UniformName name, int v0, int v1, int v2, int v3)
 {
 	glUniform4i(GetUniformLocation(name), v0, v1, v2, v3);
 }
 
-void Shader::SetUniform1f(const char* name, float value)
+void Shader::SetUniform1f(UniformName name, float value)
 {
 	glUniform1f(GetUniformLocation(name), value);
 }
 
-void Shader::SetUniform2f(const char* name, float v0, float v1)
+void Shader::SetUniform2f(UniformName name, float v0, float v1)
 {
 	glUniform2f(GetUniformLocation(name), v0, v1);
 }
 
-void Shader::SetUniform3f(const char* name, float v0, float v1, float v2)
+void Shader::SetUniform3f(UniformName name, float v0, float v1, float v2)
 {
 	glUniform3f(GetUniformLocation(name), v0, v1, v2);
 }
 
-void Shader::SetUniform4f(const char* name, float v0, float v1, float v2, float v3)
+void Shader::SetUniform4f(UniformName name, float v0, float v1, float v2, float v3)
 {
 	glUniform4f(GetUniformLocation(name), v0, v1, v2, v3);
 }
 
-void Shader::SetUniformVec2(const char* name, const glm::vec2& value)
+void Shader::SetUniformVec2(UniformName name, const glm::vec2& value)
 {
 	glUniform2f(GetUniformLocation(name), value.x, value.y);
 }
 
-void Shader::SetUniformVec3(const char* name, const glm::vec3& value)
+void Shader::SetUniformVec3(UniformName name, const glm::vec3& value)
 {
 	glUniform3f(GetUniformLocation(name), value.x, value.y, value.z);
 }
 
-void Shader::SetUniformVec4(const char* name, const glm::vec4& value)
+void Shader::SetUniformVec4(UniformName name, const glm::vec4& value)
 {
 	glUniform4f(GetUniformLocation(name), value.x, value.y, value.z, value.w);
 }
+
+void Shader::SetUniformMat4(UniformName name, const glm::mat4& value)
+{
+	glUniformMatrix4fv(GetUniformLocation(name), 1, GL_FALSE, glm::value_ptr(value));
+}
@@ -0,0 +1,155 @@
+#include <cstdio>
+#include <vector>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <filesystem>
+
+#include "JJEngine/ShaderCache.h"
+#include "JJEngine/Hash.h"
+#include "JJEngine/MappedFile.h"
+#include "JJEngine/Profiler.h"
+
+namespace JJEngine {
+	namespace {
+		constexpr uint32_t CacheMagic = 0x4250424a; // "JJPB"
+		constexpr uint32_t CacheVersion = 1;
+
+		struct CacheHeader {
+			uint32_t magic;
+			uint32_t version;
+			uint64_t key;
+			GLenum format;
+			uint32_t length;
+		};
+
+		uint64_t GetDriverHash()
+		{
+			static uint64_t driverHash = 0;
+			if(driverHash == 0)
+			{
+				driverHash = HashFnv1a64((const char*)glGetString(GL_VENDOR));
+				driverHash = HashFnv1a64((const char*)glGetString(GL_RENDERER), driverHash);
+				driverHash = HashFnv1a64((const char*)glGetString(GL_VERSION), driverHash);
+			}
+			return driverHash;
+		}
+
+		bool DriverSupportsBinaries()
+		{
+			GLint formats = 0;
+			glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+			return formats > 0;
+		}
+
+		std::filesystem::path GetEntryPath(uint64_t key)
+		{
+			char name[32];
+			snprintf(name, sizeof(name), "%016llx.bin", (unsigned long long)key);
+			return std::filesystem::path(ShaderCache::GetDirectory()) / name;
+		}
+	}
+
+	bool ShaderCache::s_enabled = true;
+	std::string ShaderCache::s_directory = "shadercache";
+
+	uint64_t ShaderCache::ComputeKey(std::initializer_list<std::string_view> sources, std::string_view defines)
+	{
+		uint64_t key = GetDriverHash();
+		for(std::string_view source : sources)
+		{
+			// Separate the stages so moving code between them changes the key
+			key = HashFnv1a64(source, key);
+			key = HashFnv1a64(std::string_view("\0", 1), key);
+		}
+		return HashFnv1a64(defines, key);
+	}
+
+	uint64_t ShaderCache::ComputeKey(uint64_t sourceHash, std::string_view defines)
+	{
+		return HashFnv1a64(defines, HashCombine64(GetDriverHash(), sourceHash));
+	}
+
+	bool ShaderCache::Load(uint64_t key, GLuint program)
+	{
+		JJ_PROFILE_FUNCTION();
+
+		if(!s_enabled || !DriverSupportsBinaries())
+			return false;
+
+		std::filesystem::path path = GetEntryPath(key);
+		MappedFile file(path.string());
+		if(!file.IsOpen())
+			return false;
+
+		// The binary goes to the driver straight from the mapping
+		CacheHeader header{};
+		std::span<const std::byte> data = file.GetData();
+		if(data.size() >= sizeof(header))
+			std::memcpy(&header, data.data(), sizeof(header));
+
+		if(data.size() < sizeof(header) || header.magic != CacheMagic || header.version != CacheVersion || header.key != key)
+		{
+			file.Close();
+			std::error_code error;
+			std::filesystem::remove(path, error);
+			return false;
+		}
+
+		GLint success = GL_FALSE;
+		if(data.size() - sizeof(header) >= header.length)
+		{
+			glProgramBinary(program, header.format, data.data() + sizeof(header), (GLsizei)header.length);
+			glGetProgramiv(program, GL_LINK_STATUS, &success);
+		}
+		file.Close(); // Windows can't delete a mapped file
+
+		if(!success)
+		{
+			std::cout << "Warning: Cached shader binary rejected, recompiling from source\n";
+			std::error_code error;
+			std::filesystem::remove(path, error);
+			return false;
+		}
+
+		return true;
+	}
+
+	void ShaderCache::Store(uint64_t key, GLuint program)
+	{
+		JJ_PROFILE_FUNCTION();
+
+		if(!s_enabled || !DriverSupportsBinaries())
+			return;
+
+		GLint length = 0;
+		glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+		if(length <= 0)
+			return;
+
+		CacheHeader header{ CacheMagic, CacheVersion, key, 0, (uint32_t)length };
+		std::vector<char> binary(length);
+		glGetProgramBinary(program, length, nullptr, &header.format, binary.data());
+
+		std::error_code error;
+		std::filesystem::create_directories(s_directory, error);
+
+		// Write to a temporary file first so a crash never leaves a truncated entry behind
+		std::filesystem::path path = GetEntryPath(key);
+		std::filesystem::path tempPath = path;
+		tempPath += ".tmp";
+
+		std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+		if(!out)
+		{
+			std::cout << "Warning: Failed to write shader cache entry " << path.string() << "\n";
+			return;
+		}
+
+		out.write((const char*)&header, sizeof(header));
+		out.write(binary.data(), binary.size());
+		out.close();
+
+		std::filesystem::rename(tempPath, path, error);
+	}
+}
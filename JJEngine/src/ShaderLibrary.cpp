@@ -0,0 +1,70 @@
+#include <iostream>
+#include <stdexcept>
+
+#include "JJEngine/ShaderLibrary.h"
+#include "JJEngine/Profiler.h"
+
+namespace JJEngine {
+	ShaderLibrary::ShaderLibrary(const char* vertexPath, const char* fragmentPath, std::initializer_list<std::string_view> keywords)
+		: m_vertexPath(vertexPath), m_fragmentPath(fragmentPath), m_keywords(keywords.begin(), keywords.end())
+	{
+		if(m_keywords.size() > MaxKeywords)
+			throw std::runtime_error("Shader library has more than 64 keywords");
+	}
+
+	ShaderLibrary::VariantKey ShaderLibrary::GetKeywordBit(std::string_view keyword) const
+	{
+		for(size_t i = 0; i < m_keywords.size(); i++)
+		{
+			if(m_keywords[i] == keyword)
+				return (VariantKey)1 << i;
+		}
+
+		std::cout << "Warning: Shader keyword '" << keyword << "' not declared for " << m_vertexPath << "\n";
+		return 0;
+	}
+
+	ShaderLibrary::VariantKey ShaderLibrary::GetKey(std::initializer_list<std::string_view> keywords) const
+	{
+		VariantKey key = 0;
+		for(std::string_view keyword : keywords)
+			key |= GetKeywordBit(keyword);
+		return key;
+	}
+
+	std::string ShaderLibrary::GetDefines(VariantKey key) const
+	{
+		std::string defines;
+		for(size_t i = 0; i < m_keywords.size(); i++)
+		{
+			if(key & ((VariantKey)1 << i))
+				defines += "#define " + m_keywords[i] + "\n";
+		}
+		return defines;
+	}
+
+	Shader& ShaderLibrary::Get(VariantKey key)
+	{
+		auto it = m_variants.find(key);
+		if(it != m_variants.end())
+			return *it->second;
+
+		JJ_PROFILE_FUNCTION();
+
+		// Sources are compiled through RenderThread, draws recorded after this see the new program
+		auto shader = std::make_unique<Shader>(m_vertexPath.c_str(), m_fragmentPath.c_str(), GetDefines(key));
+		return *m_variants.emplace(key, std::move(shader)).first->second;
+	}
+
+	void ShaderLibrary::Prewarm(std::initializer_list<VariantKey> keys)
+	{
+		for(VariantKey key : keys)
+			Get(key);
+	}
+
+	void ShaderLibrary::Prewarm(const std::vector<VariantKey>& keys)
+	{
+		for(VariantKey key : keys)
+			Get(key);
+	}
+}
@@ -0,0 +1,210 @@
+#include <mutex>
+#include <memory>
+#include <iostream>
+#include <algorithm>
+#include <filesystem>
+#include <string_view>
+#include <unordered_map>
+
+#include "JJEngine/ShaderPreprocessor.h"
+#include "JJEngine/Hash.h"
+#include "JJEngine/MappedFile.h"
+#include "JJEngine/Profiler.h"
+
+namespace JJEngine {
+	namespace {
+		struct SourceFile {
+			std::string contents;
+			uint64_t hash;
+		};
+
+		struct PreprocessorData {
+			std::mutex mutex;
+			std::unordered_map<std::string, std::shared_ptr<const SourceFile>> files;
+			std::vector<std::string> includeDirectories;
+
+			ShaderPreprocessor::Statistics stats;
+		};
+
+		PreprocessorData s_data;
+
+		std::string NormalizePath(const std::filesystem::path& path)
+		{
+			return path.lexically_normal().generic_string();
+		}
+
+		std::shared_ptr<const SourceFile> ReadFile(const std::string& path)
+		{
+			// Copied out instead of keeping the mapping, a mapped file can't be replaced by an editor
+			// on Windows and faults when truncated elsewhere. Only done once per file and process.
+			MappedFile mapped(path);
+			if(!mapped.IsOpen())
+				return nullptr;
+
+			auto file = std::make_shared<SourceFile>();
+			file->contents = mapped.GetText();
+			file->hash = HashFnv1a64(file->contents);
+			return file;
+		}
+
+		std::shared_ptr<const SourceFile> GetFile(const std::string& path)
+		{
+			{
+				std::lock_guard<std::mutex> lock(s_data.mutex);
+				auto it = s_data.files.find(path);
+				if(it != s_data.files.end())
+				{
+					s_data.stats.cacheHits++;
+					return it->second;
+				}
+			}
+
+			// Read outside the lock, two threads racing for the same file both read it once
+			std::shared_ptr<const SourceFile> file = ReadFile(path);
+			if(file == nullptr)
+				return nullptr;
+
+			std::lock_guard<std::mutex> lock(s_data.mutex);
+			s_data.stats.filesRead++;
+			return s_data.files.emplace(path, file).first->second;
+		}
+
+		bool Exists(const std::string& path)
+		{
+			{
+				std::lock_guard<std::mutex> lock(s_data.mutex);
+				if(s_data.files.contains(path))
+					return true;
+			}
+			std::error_code error;
+			return std::filesystem::is_regular_file(path, error);
+		}
+
+		std::string ResolveInclude(const std::string& includingFile, std::string_view name)
+		{
+			std::string relative = NormalizePath(std::filesystem::path(includingFile).parent_path() / name);
+			if(Exists(relative))
+				return relative;
+
+			std::vector<std::string> directories;
+			{
+				std::lock_guard<std::mutex> lock(s_data.mutex);
+				directories = s_data.includeDirectories;
+			}
+
+			for(const std::string& directory : directories)
+			{
+				std::string candidate = NormalizePath(std::filesystem::path(directory) / name);
+				if(Exists(candidate))
+					return candidate;
+			}
+
+			// Reported as missing under the relative path, which is also what gets watched
+			return relative;
+		}
+
+		// Returns the name between quotes or angle brackets if line is an #include directive
+		bool ParseInclude(std::string_view line, std::string_view& name)
+		{
+			size_t start = line.find_first_not_of(" \t");
+			if(start == std::string_view::npos || line[start] != '#')
+				return false;
+
+			size_t directive = line.find_first_not_of(" \t", start + 1);
+			if(directive == std::string_view::npos || line.substr(directive, 7) != "include")
+				return false;
+
+			size_t open = line.find_first_of("\"<", directive + 7);
+			if(open == std::string_view::npos)
+				return false;
+
+			size_t close = line.find(line[open] == '"' ? '"' : '>', open + 1);
+			if(close == std::string_view::npos)
+				return false;
+
+			name = line.substr(open + 1, close - open - 1);
+			return true;
+		}
+
+		bool ProcessFile(const std::string& path, PreprocessedSource& result)
+		{
+			uint32_t index = (uint32_t)result.dependencies.size();
+			result.dependencies.push_back(path);
+
+			std::shared_ptr<const SourceFile> file = GetFile(path);
+			if(file == nullptr)
+			{
+				std::cout << "Error: Shader file not found: " << path << "\n";
+				return false;
+			}
+			result.hash = HashCombine64(result.hash, file->hash);
+
+			bool succeeded = true;
+			std::string_view contents = file->contents;
+			uint32_t lineNumber = 0;
+			while(!contents.empty())
+			{
+				size_t lineEnd = contents.find('\n');
+				std::string_view line = contents.substr(0, lineEnd);
+				contents = lineEnd == std::string_view::npos ? std::string_view() : contents.substr(lineEnd + 1);
+				lineNumber++;
+
+				std::string_view name;
+				if(!ParseInclude(line, name))
+				{
+					result.source.append(line);
+					result.source += '\n';
+					continue;
+				}
+
+				std::string include = ResolveInclude(path, name);
+
+				// Already part of this program, the blank line keeps the numbering
+				if(std::find(result.dependencies.begin(), result.dependencies.end(), include) != result.dependencies.end())
+				{
+					result.source += '\n';
+					continue;
+				}
+
+				result.source += "#line 1 " + std::to_string(result.dependencies.size()) + "\n";
+				if(!ProcessFile(include, result))
+				{
+					std::cout << "  included from " << path << "(" << lineNumber << ")\n";
+					succeeded = false;
+				}
+				result.source += "#line " + std::to_string(lineNumber + 1) + " " + std::to_string(index) + "\n";
+			}
+
+			return succeeded;
+		}
+	}
+
+	PreprocessedSource ShaderPreprocessor::Process(const std::string& path)
+	{
+		JJ_PROFILE_FUNCTION();
+
+		PreprocessedSource result;
+		result.succeeded = ProcessFile(NormalizePath(path), result);
+		return result;
+	}
+
+	void ShaderPreprocessor::AddIncludeDirectory(const std::string& directory)
+	{
+		std::lock_guard<std::mutex> lock(s_data.mutex);
+		s_data.includeDirectories.push_back(directory);
+	}
+
+	void ShaderPreprocessor::Invalidate(const std::string& path)
+	{
+		std::lock_guard<std::mutex> lock(s_data.mutex);
+		s_data.files.erase(NormalizePath(path));
+	}
+
+	ShaderPreprocessor::Statistics ShaderPreprocessor::GetStats()
+	{
+		std::lock_guard<std::mutex> lock(s_data.mutex);
+		Statistics stats = s_data.stats;
+		stats.cachedFiles = (uint32_t)s_data.files.size();
+		return stats;
+	}
+}
@@ -0,0 +1,532 @@
+#include <mutex>
+#include <deque>
+#include <atomic>
+#include <thread>
+#include <memory>
+#include <string>
+#include <vector>
+#include <iostream>
+#include <algorithm>
+#include <condition_variable>
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include "JJEngine/ShaderReloader.h"
+#include "JJEngine/Shader.h"
+#include "JJEngine/ShaderCache.h"
+#include "JJEngine/ShaderPreprocessor.h"
+#include "JJEngine/FileWatcher.h"
+#include "JJEngine/JobSystem.h"
+#include "JJEngine/RenderThread.h"
+#include "JJEngine/GLState.h"
+#include "JJEngine/Profiler.h"
+
+namespace JJEngine {
+	namespace {
+		// GL_COMPLETION_STATUS_KHR, same value for the ARB variant. Not in the core-only glad headers.
+		constexpr GLenum CompletionStatus = 0x91B1;
+		using MaxShaderCompilerThreadsProc = void (APIENTRYP)(GLuint count);
+
+		// Main thread, waiting for the sources to be read
+		struct PendingRead {
+			Shader* shader;
+			std::string vertexPath, fragmentPath;
+			PreprocessedSource vertex, fragment;
+			std::string defines;
+			JobCounter counter;
+		};
+
+		// Context thread, from the first compile call until the program is swapped in or discarded
+		struct PendingCompile {
+			Shader* shader; // Null once the shader is destroyed or a newer reload of it started
+			std::string name;
+			std::string vertexSource, fragmentSource;
+			std::string defines;
+			uint64_t sourceHash = 0;
+			uint64_t cacheKey = 0;
+
+			GLuint vertex = 0, fragment = 0, program = 0;
+			std::atomic<bool> compiled = false; // Set by the compile thread in SharedContext mode
+		};
+
+		struct RegisteredShader {
+			Shader* shader;
+			std::vector<std::string> dependencies;
+		};
+
+		struct ShaderReloaderData {
+			ShaderReloader::Mode mode = ShaderReloader::Mode::Disabled;
+			bool enabled = true;
+			JobSystem* jobSystem = nullptr;
+
+			// Main thread
+			FileWatcher watcher;
+			std::vector<RegisteredShader> shaders;
+			std::vector<std::unique_ptr<PendingRead>> reads;
+
+			// Context thread
+			std::vector<std::unique_ptr<PendingCompile>> compiles;
+
+			// SharedContext mode
+			GLFWwindow* compileWindow = nullptr;
+			std::thread compileThread;
+			std::mutex compileMutex;
+			std::condition_variable compileCondition;
+			std::deque<PendingCompile*> compileQueue;
+			bool stopping = false;
+
+			std::atomic<uint32_t> submittedCompiles = 0;
+			std::atomic<uint32_t> reloads = 0;
+			std::atomic<uint32_t> failures = 0;
+		};
+
+		ShaderReloaderData* s_data = nullptr;
+
+		// Only issues the calls, with parallel compile or on the compile thread none of them wait
+		void BeginCompile(PendingCompile& compile)
+		{
+			std::string vertexCode = Shader::InjectDefines(compile.vertexSource, compile.defines);
+			std::string fragmentCode = Shader::InjectDefines(compile.fragmentSource, compile.defines);
+			const char* vertexSource = vertexCode.c_str();
+			const char* fragmentSource = fragmentCode.c_str();
+
+			compile.vertex = glCreateShader(GL_VERTEX_SHADER);
+			glShaderSource(compile.vertex, 1, &vertexSource, nullptr);
+			glCompileShader(compile.vertex);
+
+			compile.fragment = glCreateShader(GL_FRAGMENT_SHADER);
+			glShaderSource(compile.fragment, 1, &fragmentSource, nullptr);
+			glCompileShader(compile.fragment);
+
+			compile.program = glCreateProgram();
+			glProgramParameteri(compile.program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+			glAttachShader(compile.program, compile.vertex);
+			glAttachShader(compile.program, compile.fragment);
+			glLinkProgram(compile.program);
+		}
+
+		bool IsCompiled(PendingCompile& compile)
+		{
+			switch(s_data->mode)
+			{
+			case ShaderReloader::Mode::ParallelCompile:
+			{
+				GLint completed = GL_FALSE;
+				glGetProgramiv(compile.program, CompletionStatus, &completed);
+				return completed == GL_TRUE;
+			}
+			case ShaderReloader::Mode::SharedContext:
+				return compile.compiled.load(std::memory_order_acquire);
+			default:
+				return true;
+			}
+		}
+
+		void PrintShaderLog(GLuint shader, const char* stage)
+		{
+			GLint status = GL_FALSE;
+			glGetShaderiv(shader, GL_COMPILE_STATUS, &status);
+			if(status == GL_TRUE)
+				return;
+
+			GLint length = 0;
+			glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &length);
+			std::string message(std::max(length, 1), '\0');
+			glGetShaderInfoLog(shader, length, nullptr, message.data());
+			std::cout << "Failed to compile " << stage << " shader!\n" << message.c_str() << "\n";
+		}
+
+		void DeleteObjects(PendingCompile& compile)
+		{
+			if(compile.program != 0)
+			{
+				glDetachShader(compile.program, compile.vertex);
+				glDetachShader(compile.program, compile.fragment);
+			}
+			glDeleteShader(compile.vertex);
+			glDeleteShader(compile.fragment);
+			compile.vertex = compile.fragment = 0;
+		}
+
+		void FinishCompile(PendingCompile& compile)
+		{
+			JJ_PROFILE_FUNCTION();
+
+			GLint linked = GL_FALSE;
+			glGetProgramiv(compile.program, GL_LINK_STATUS, &linked);
+
+			if(compile.shader == nullptr || !linked)
+			{
+				if(compile.shader != nullptr)
+				{
+					PrintShaderLog(compile.vertex, "vertex");
+					PrintShaderLog(compile.fragment, "fragment");
+
+					char infoLog[512] = {};
+					glGetProgramInfoLog(compile.program, sizeof(infoLog), nullptr, infoLog);
+					std::cout << "Error: Reloading " << compile.name << " failed, keeping the previous program\n" << infoLog << "\n";
+					s_data->failures.fetch_add(1, std::memory_order_relaxed);
+				}
+
+				DeleteObjects(compile);
+				GLState::DeleteProgram(compile.program);
+				return;
+			}
+
+			DeleteObjects(compile);
+			ShaderCache::Store(compile.cacheKey, compile.program);
+			compile.shader->AdoptProgram(compile.program);
+			s_data->reloads.fetch_add(1, std::memory_order_relaxed);
+			std::cout << "Shader reloaded: " << compile.name << "\n";
+		}
+
+		void StartCompile(PendingCompile* compile)
+		{
+			JJ_PROFILE_FUNCTION();
+
+			// Only the newest reload of a shader may swap in
+			for(std::unique_ptr<PendingCompile>& other : s_data->compiles)
+			{
+				if(other->shader == compile->shader)
+					other->shader = nullptr;
+			}
+
+			compile->cacheKey = ShaderCache::ComputeKey(compile->sourceHash, compile->defines);
+
+			// Reverting an edit usually finds the old binary
+			GLuint program = glCreateProgram();
+			if(ShaderCache::Load(compile->cacheKey, program))
+			{
+				compile->shader->AdoptProgram(program);
+				s_data->reloads.fetch_add(1, std::memory_order_relaxed);
+				s_data->submittedCompiles.fetch_sub(1, std::memory_order_relaxed);
+				std::cout << "Shader reloaded from cache: " << compile->name << "\n";
+				delete compile;
+				return;
+			}
+			GLState::DeleteProgram(program);
+
+			if(s_data->mode == ShaderReloader::Mode::SharedContext)
+			{
+				std::lock_guard<std::mutex> lock(s_data->compileMutex);
+				s_data->compileQueue.push_back(compile);
+				s_data->compileCondition.notify_one();
+			}
+			else
+			{
+				BeginCompile(*compile);
+			}
+
+			s_data->compiles.emplace_back(compile);
+		}
+
+		void ProcessCompiles()
+		{
+			std::erase_if(s_data->compiles, [](std::unique_ptr<PendingCompile>& compile)
+			{
+				if(!IsCompiled(*compile))
+					return false;
+
+				FinishCompile(*compile);
+				s_data->submittedCompiles.fetch_sub(1, std::memory_order_relaxed);
+				return true;
+			});
+		}
+
+		void CompileThread()
+		{
+			Profiler::SetThreadName("Shader Compiler");
+			glfwMakeContextCurrent(s_data->compileWindow);
+
+			for(;;)
+			{
+				PendingCompile* compile;
+				{
+					std::unique_lock<std::mutex> lock(s_data->compileMutex);
+					s_data->compileCondition.wait(lock, []() { return s_data->stopping || !s_data->compileQueue.empty(); });
+					if(s_data->stopping)
+						break;
+
+					compile = s_data->compileQueue.front();
+					s_data->compileQueue.pop_front();
+				}
+
+				JJ_PROFILE_SCOPE("ShaderReloader::Compile");
+				BeginCompile(*compile);
+
+				// The program has to be complete before the render context may use it
+				glFinish();
+				compile->compiled.store(true, std::memory_order_release);
+			}
+
+			glfwMakeContextCurrent(nullptr);
+		}
+
+		bool UsesPath(const RegisteredShader& registered, const std::string& path)
+		{
+			return std::find(registered.dependencies.begin(), registered.dependencies.end(), path) != registered.dependencies.end();
+		}
+
+		RegisteredShader* FindShader(const Shader* shader)
+		{
+			auto it = std::find_if(s_data->shaders.begin(), s_data->shaders.end(), [shader](const RegisteredShader& registered) { return registered.shader == shader; });
+			return it != s_data->shaders.end() ? &*it : nullptr;
+		}
+
+		// Watches the new dependencies and stops watching files no registered shader uses anymore
+		void SetDependencies(RegisteredShader& registered, std::vector<std::string> dependencies)
+		{
+			std::swap(registered.dependencies, dependencies);
+			for(const std::string& path : registered.dependencies)
+				s_data->watcher.Watch(path);
+
+			for(const std::string& path : dependencies)
+			{
+				bool used = std::any_of(s_data->shaders.begin(), s_data->shaders.end(), [&path](const RegisteredShader& other) { return UsesPath(other, path); });
+				if(!used)
+					s_data->watcher.Unwatch(path);
+			}
+		}
+
+		void StartRead(Shader& shader)
+		{
+			auto read = std::make_unique<PendingRead>();
+			read->shader = &shader;
+			read->vertexPath = shader.GetVertexPath();
+			read->fragmentPath = shader.GetFragmentPath();
+			read->defines = shader.GetDefines();
+
+			PendingRead* pending = read.get();
+			auto readFiles = [pending]()
+			{
+				JJ_PROFILE_SCOPE("ShaderReloader::ReadFiles");
+				pending->vertex = ShaderPreprocessor::Process(pending->vertexPath);
+				pending->fragment = ShaderPreprocessor::Process(pending->fragmentPath);
+			};
+
+			if(s_data->jobSystem != nullptr)
+				s_data->jobSystem->Run(readFiles, &pending->counter);
+			else
+				readFiles();
+
+			s_data->reads.push_back(std::move(read));
+		}
+	}
+
+	void ShaderReloader::Init(GLFWwindow* window, JobSystem* jobSystem)
+	{
+		s_data = new ShaderReloaderData();
+		s_data->jobSystem = jobSystem;
+
+		if(glfwExtensionSupported("GL_KHR_parallel_shader_compile") || glfwExtensionSupported("GL_ARB_parallel_shader_compile"))
+		{
+			s_data->mode = Mode::ParallelCompile;
+
+			// Let the driver use as many compiler threads as it likes
+			auto maxThreads = (MaxShaderCompilerThreadsProc)glfwGetProcAddress("glMaxShaderCompilerThreadsKHR");
+			if(maxThreads == nullptr)
+				maxThreads = (MaxShaderCompilerThreadsProc)glfwGetProcAddress("glMaxShaderCompilerThreadsARB");
+			if(maxThreads != nullptr)
+				maxThreads(0xFFFFFFFF);
+			return;
+		}
+
+		// Created with the hints left over from the main window, so the context versions match
+		glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+		s_data->compileWindow = glfwCreateWindow(1, 1, "Shader Compiler", nullptr, window);
+		glfwWindowHint(GLFW_VISIBLE, GLFW_TRUE);
+
+		if(s_data->compileWindow != nullptr)
+		{
+			s_data->mode = Mode::SharedContext;
+			s_data->compileThread = std::thread(CompileThread);
+		}
+		else
+		{
+			s_data->mode = Mode::Synchronous;
+			std::cout << "Warning: No parallel shader compile or shared context, shader reloads will stall the frame\n";
+		}
+	}
+
+	void ShaderReloader::Shutdown()
+	{
+		if(s_data == nullptr)
+			return;
+
+		for(std::unique_ptr<PendingRead>& read : s_data->reads)
+		{
+			if(s_data->jobSystem != nullptr)
+				s_data->jobSystem->Wait(read->counter);
+		}
+
+		if(s_data->compileThread.joinable())
+		{
+			{
+				std::lock_guard<std::mutex> lock(s_data->compileMutex);
+				s_data->stopping = true;
+			}
+			s_data->compileCondition.notify_one();
+			s_data->compileThread.join();
+		}
+
+		if(s_data->compileWindow != nullptr)
+			glfwDestroyWindow(s_data->compileWindow);
+
+		// Called with the context back on this thread, compiles that never finished are dropped
+		RenderThread::Submit([]()
+		{
+			for(std::unique_ptr<PendingCompile>& compile : s_data->compiles)
+			{
+				DeleteObjects(*compile);
+				if(compile->program != 0)
+					GLState::DeleteProgram(compile->program);
+			}
+		});
+
+		delete s_data;
+		s_data = nullptr;
+	}
+
+	void ShaderReloader::SetEnabled(bool enabled)
+	{
+		if(s_data != nullptr)
+			s_data->enabled = enabled;
+	}
+
+	bool ShaderReloader::IsEnabled()
+	{
+		return s_data != nullptr && s_data->enabled;
+	}
+
+	void ShaderReloader::Register(Shader& shader, const std::vector<std::string>& dependencies)
+	{
+		if(s_data == nullptr)
+			return;
+
+		// Registered again when Load is called with new paths
+		RegisteredShader* registered = FindShader(&shader);
+		if(registered == nullptr)
+			registered = &s_data->shaders.emplace_back(RegisteredShader{ &shader, {} });
+
+		SetDependencies(*registered, dependencies);
+	}
+
+	void ShaderReloader::Unregister(Shader& shader)
+	{
+		if(s_data == nullptr)
+			return;
+
+		RegisteredShader* registered = FindShader(&shader);
+		if(registered == nullptr)
+			return;
+
+		SetDependencies(*registered, {});
+		s_data->shaders.erase(s_data->shaders.begin() + (registered - s_data->shaders.data()));
+
+		std::erase_if(s_data->reads, [&shader](std::unique_ptr<PendingRead>& read)
+		{
+			if(read->shader != &shader)
+				return false;
+
+			if(s_data->jobSystem != nullptr)
+				s_data->jobSystem->Wait(read->counter);
+			return true;
+		});
+
+
+		// Recorded after every command that could still draw with the shader
+		Shader* address = &shader;
+		RenderThread::Submit([address]()
+		{
+			for(std::unique_ptr<PendingCompile>& compile : s_data->compiles)
+			{
+				if(compile->shader == address)
+					compile->shader = nullptr;
+			}
+		});
+	}
+
+	void ShaderReloader::Update()
+	{
+		if(s_data == nullptr)
+			return;
+
+		JJ_PROFILE_FUNCTION();
+
+		if(s_data->enabled)
+		{
+			for(const std::string& path : s_data->watcher.Poll())
+			{
+				ShaderPreprocessor::Invalidate(path);
+
+				for(RegisteredShader& registered : s_data->shaders)
+				{
+					if(!UsesPath(registered, path))
+						continue;
+
+					// One read per shader at a time, editing several of its files at once gives one reload
+					Shader* shader = registered.shader;
+					bool reading = std::any_of(s_data->reads.begin(), s_data->reads.end(), [shader](const std::unique_ptr<PendingRead>& read) { return read->shader == shader; });
+					if(!reading)
+						StartRead(*shader);
+				}
+			}
+		}
+
+		std::erase_if(s_data->reads, [](std::unique_ptr<PendingRead>& read)
+		{
+			if(!read->counter.IsDone())
+				return false;
+
+			// Includes may have been added or removed, watched even if the read failed so
+			// creating a missing file triggers the next reload
+			std::vector<std::string> dependencies = read->vertex.dependencies;
+			for(const std::string& path : read->fragment.dependencies)
+			{
+				if(std::find(dependencies.begin(), dependencies.end(), path) == dependencies.end())
+					dependencies.push_back(path);
+			}
+			SetDependencies(*FindShader(read->shader), std::move(dependencies));
+
+			if(!read->vertex.succeeded || !read->fragment.succeeded || read->vertex.source.empty() || read->fragment.source.empty())
+			{
+				// Editors may truncate before writing, the next change event retries
+				std::cout << "Warning: Shader file empty or missing, skipping reload of " << read->vertexPath << "\n";
+				return true;
+			}
+
+			PendingCompile* compile = new PendingCompile();
+			compile->shader = read->shader;
+			compile->name = read->vertexPath + " + " + read->fragmentPath;
+			compile->vertexSource = std::move(read->vertex.source);
+			compile->fragmentSource = std::move(read->fragment.source);
+			compile->defines = std::move(read->defines);
+			compile->sourceHash = HashCombine64(read->vertex.hash, read->fragment.hash);
+
+			s_data->submittedCompiles.fetch_add(1, std::memory_order_relaxed);
+			RenderThread::Submit([compile]() { StartCompile(compile); });
+			return true;
+		});
+
+		if(s_data->submittedCompiles.load(std::memory_order_relaxed) > 0)
+			RenderThread::Submit([]() { ProcessCompiles(); });
+	}
+
+	ShaderReloader::Mode ShaderReloader::GetMode()
+	{
+		return s_data != nullptr ? s_data->mode : Mode::Disabled;
+	}
+
+	ShaderReloader::Statistics ShaderReloader::GetStats()
+	{
+		Statistics stats;
+		if(s_data == nullptr)
+			return stats;
+
+		stats.reloads = s_data->reloads.load(std::memory_order_relaxed);
+		stats.failures = s_data->failures.load(std::memory_order_relaxed);
+		stats.pending = (uint32_t)s_data->reads.size() + s_data->submittedCompiles.load(std::memory_order_relaxed);
+		return stats;
+	}
+}
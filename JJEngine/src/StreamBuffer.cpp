@@ -0,0 +1,95 @@
+#include <chrono>
+#include <stdexcept>
+
+#include "JJEngine/StreamBuffer.h"
+#include "JJEngine/Profiler.h"
+#include "JJEngine/GLState.h"
+
+namespace JJEngine {
+	StreamBuffer::StreamBuffer(size_t regionSize) : m_regionSize(regionSize)
+	{
+		GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+		glCreateBuffers(1, &m_rendererID);
+		glNamedBufferStorage(m_rendererID, m_regionSize * RegionCount, nullptr, flags);
+
+		m_mappedData = (uint8_t*)glMapNamedBufferRange(m_rendererID, 0, m_regionSize * RegionCount, flags);
+		if(m_mappedData == nullptr)
+		{
+			GLState::DeleteBuffer(m_rendererID);
+			throw std::runtime_error("Failed to map stream buffer");
+		}
+	}
+
+	StreamBuffer::~StreamBuffer()
+	{
+		for(GLsync fence : m_fences)
+		{
+			if(fence != nullptr)
+				glDeleteSync(fence);
+		}
+
+		glUnmapNamedBuffer(m_rendererID);
+		GLState::DeleteBuffer(m_rendererID);
+	}
+
+	StreamBuffer::Allocation StreamBuffer::Allocate(size_t size, size_t alignment)
+	{
+		if(size > m_regionSize)
+			return {};
+
+		// Alignment is not required to be a power of two, vertex strides often aren't
+		size_t offset = (m_regionOffset + alignment - 1) / alignment * alignment;
+		if(offset + size > m_regionSize)
+		{
+			NextRegion();
+			offset = 0;
+		}
+
+		m_regionOffset = offset + size;
+		m_frameStats.bytesStreamed += size;
+
+		GLintptr bufferOffset = (GLintptr)(m_region * m_regionSize + offset);
+		return { m_mappedData + bufferOffset, bufferOffset };
+	}
+
+	void StreamBuffer::EndFrame()
+	{
+		NextRegion();
+
+		m_lastFrameStats = m_frameStats;
+		m_frameStats = Statistics();
+	}
+
+	void StreamBuffer::NextRegion()
+	{
+		m_fences[m_region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+		m_region = (m_region + 1) % RegionCount;
+		m_regionOffset = 0;
+
+		GLsync fence = m_fences[m_region];
+		if(fence == nullptr)
+			return;
+
+		// Fast path: the GPU is usually done with a region two frames old
+		GLenum result = glClientWaitSync(fence, 0, 0);
+		if(result != GL_ALREADY_SIGNALED && result != GL_CONDITION_SATISFIED)
+		{
+			JJ_PROFILE_SCOPE("StreamBuffer fence wait");
+
+			auto start = std::chrono::high_resolution_clock::now();
+			do
+			{
+				result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+			} while(result == GL_TIMEOUT_EXPIRED);
+			auto end = std::chrono::high_resolution_clock::now();
+
+			m_frameStats.fenceWaits++;
+			m_frameStats.fenceWaitTime += std::chrono::duration<double, std::milli>(end - start).count();
+		}
+
+		glDeleteSync(fence);
+		m_fences[m_region] = nullptr;
+	}
+}
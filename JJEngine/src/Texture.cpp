@@ -0,0 +1,372 @@
+#include <bit>
+#include <cstring>
+#include <iostream>
+#include <algorithm>
+#include <stdexcept>
+
+#include <GLFW/glfw3.h>
+
+#include "JJEngine/Texture.h"
+#include "JJEngine/StreamBuffer.h"
+#include "JJEngine/RenderThread.h"
+#include "JJEngine/GLState.h"
+#include "JJEngine/Profiler.h"
+
+namespace JJEngine {
+	namespace {
+		// ARB_bindless_texture isn't in the core-only glad headers
+		using GetTextureHandleProc = GLuint64 (APIENTRYP)(GLuint texture);
+		using TextureHandleResidencyProc = void (APIENTRYP)(GLuint64 handle);
+		using ProgramUniformHandlesProc = void (APIENTRYP)(GLuint program, GLint location, GLsizei count, const GLuint64* values);
+
+		// Uploads within the default AssetManager byte budget fit one region, so streaming never
+		// has to wait for the GPU to release a region in the middle of a frame
+		constexpr size_t StagingRegionSize = 8 * 1024 * 1024;
+
+		struct FormatInfo {
+			GLenum internalFormat;
+			GLenum format;
+			uint32_t bytesPerPixel;
+		};
+
+		const FormatInfo& GetFormatInfo(TextureFormat format)
+		{
+			static const FormatInfo formats[] = {
+				{ GL_RGBA8, GL_RGBA, 4 },
+				{ GL_SRGB8_ALPHA8, GL_RGBA, 4 },
+				{ GL_RG8, GL_RG, 2 },
+				{ GL_R8, GL_RED, 1 }
+			};
+			return formats[(int)format];
+		}
+
+		struct TextureData {
+			std::unique_ptr<StreamBuffer> staging;
+			bool staged = false; // Since the last EndFrame
+
+			GetTextureHandleProc getTextureHandle = nullptr;
+			TextureHandleResidencyProc makeResident = nullptr;
+			TextureHandleResidencyProc makeNonResident = nullptr;
+			ProgramUniformHandlesProc programUniformHandles = nullptr;
+		};
+
+		TextureData s_data;
+	}
+
+	void Texture::Init()
+	{
+		s_data.staging = std::make_unique<StreamBuffer>(StagingRegionSize);
+
+		if(glfwExtensionSupported("GL_ARB_bindless_texture"))
+		{
+			s_data.getTextureHandle = (GetTextureHandleProc)glfwGetProcAddress("glGetTextureHandleARB");
+			s_data.makeResident = (TextureHandleResidencyProc)glfwGetProcAddress("glMakeTextureHandleResidentARB");
+			s_data.makeNonResident = (TextureHandleResidencyProc)glfwGetProcAddress("glMakeTextureHandleNonResidentARB");
+			s_data.programUniformHandles = (ProgramUniformHandlesProc)glfwGetProcAddress("glProgramUniformHandleui64vARB");
+		}
+	}
+
+	void Texture::Shutdown()
+	{
+		s_data.staging.reset();
+		s_data.staged = false;
+	}
+
+	void Texture::EndFrame()
+	{
+		if(s_data.staging != nullptr && s_data.staged)
+		{
+			s_data.staging->EndFrame();
+			s_data.staged = false;
+		}
+	}
+
+	bool Texture::IsBindlessSupported()
+	{
+		return s_data.getTextureHandle != nullptr && s_data.makeResident != nullptr && s_data.makeNonResident != nullptr
+			&& s_data.programUniformHandles != nullptr;
+	}
+
+	void Texture::SetSamplerHandles(GLuint program, GLint location, uint32_t count, const uint64_t* handles)
+	{
+		s_data.programUniformHandles(program, location, (GLsizei)count, handles);
+	}
+
+	uint32_t Texture::GetBytesPerPixel(TextureFormat format)
+	{
+		return GetFormatInfo(format).bytesPerPixel;
+	}
+
+	uint32_t Texture::GetFullMipCount(uint32_t width, uint32_t height)
+	{
+		return (uint32_t)std::bit_width(std::max(width, height));
+	}
+
+	Texture::Texture(GLenum target, uint32_t width, uint32_t height, uint32_t layers, TextureFormat format, uint32_t levels)
+		: m_target(target), m_format(format), m_width(width), m_height(height), m_layers(layers)
+	{
+		if(width == 0 || height == 0 || layers == 0)
+			throw std::runtime_error("Texture dimensions must not be zero");
+
+		uint32_t fullMipCount = GetFullMipCount(width, height);
+		m_levels = levels == 0 ? fullMipCount : std::min(levels, fullMipCount);
+
+		const FormatInfo& info = GetFormatInfo(format);
+		glCreateTextures(target, 1, &m_rendererID);
+		if(target == GL_TEXTURE_2D_ARRAY)
+			glTextureStorage3D(m_rendererID, m_levels, info.internalFormat, width, height, layers);
+		else
+			glTextureStorage2D(m_rendererID, m_levels, info.internalFormat, width, height);
+
+		glTextureParameteri(m_rendererID, GL_TEXTURE_MIN_FILTER, m_levels > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+		glTextureParameteri(m_rendererID, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTextureParameteri(m_rendererID, GL_TEXTURE_WRAP_S, GL_REPEAT);
+		glTextureParameteri(m_rendererID, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	}
+
+	Texture::~Texture()
+	{
+		if(m_bindlessHandle != 0)
+			s_data.makeNonResident(m_bindlessHandle);
+		GLState::DeleteTexture(m_rendererID);
+	}
+
+	void Texture::UploadRows(uint32_t level, uint32_t layer, uint32_t y, uint32_t rowCount, const void* pixels)
+	{
+		JJ_PROFILE_FUNCTION();
+
+		const FormatInfo& info = GetFormatInfo(m_format);
+		uint32_t width = std::max(1u, m_width >> level);
+		size_t rowSize = (size_t)width * info.bytesPerPixel;
+		const std::byte* source = (const std::byte*)pixels;
+
+		// Without Init, or for a row wider than a staging region, the driver reads client memory
+		StreamBuffer* staging = s_data.staging.get();
+		uint32_t rowsPerBand = rowCount;
+		if(staging != nullptr)
+		{
+			rowsPerBand = (uint32_t)std::min<size_t>(rowCount, staging->GetRegionSize() / rowSize);
+			if(rowsPerBand == 0)
+			{
+				staging = nullptr;
+				rowsPerBand = rowCount;
+			}
+		}
+
+		GLState::BindBuffer(GL_PIXEL_UNPACK_BUFFER, staging != nullptr ? staging->GetRendererID() : 0);
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+		for(uint32_t band = 0; band < rowCount; band += rowsPerBand)
+		{
+			uint32_t rows = std::min(rowsPerBand, rowCount - band);
+			const void* data = source + (size_t)band * rowSize;
+			if(staging != nullptr)
+			{
+				size_t size = (size_t)rows * rowSize;
+				StreamBuffer::Allocation allocation = staging->Allocate(size, info.bytesPerPixel);
+				std::memcpy(allocation.data, data, size);
+				data = (const void*)allocation.offset;
+				s_data.staged = true;
+			}
+
+			if(m_target == GL_TEXTURE_2D_ARRAY)
+				glTextureSubImage3D(m_rendererID, level, 0, y + band, layer, width, rows, 1, info.format, GL_UNSIGNED_BYTE, data);
+			else
+				glTextureSubImage2D(m_rendererID, level, 0, y + band, width, rows, info.format, GL_UNSIGNED_BYTE, data);
+		}
+
+		GLState::BindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	}
+
+	void Texture::SubmitUpload(uint32_t level, uint32_t layer, const void* pixels)
+	{
+		uint32_t height = std::max(1u, m_height >> level);
+		if(!RenderThread::IsRunning() || RenderThread::IsRenderThread())
+		{
+			UploadRows(level, layer, 0, height, pixels);
+			return;
+		}
+
+		// The caller's pixels may be gone by the time the render thread gets to the upload
+		size_t size = (size_t)std::max(1u, m_width >> level) * height * GetBytesPerPixel(m_format);
+		std::vector<std::byte> copy((const std::byte*)pixels, (const std::byte*)pixels + size);
+		RenderThread::Submit([this, level, layer, height, copy = std::move(copy)]()
+		{
+			UploadRows(level, layer, 0, height, copy.data());
+		});
+	}
+
+	void Texture::GenerateMipmaps()
+	{
+		if(m_levels > 1)
+			glGenerateTextureMipmap(m_rendererID);
+	}
+
+	void Texture::Bind(uint32_t unit) const
+	{
+		RenderThread::Submit([unit, texture = m_rendererID]() { GLState::BindTextureUnit(unit, texture); });
+	}
+
+	uint64_t Texture::GetBindlessHandle()
+	{
+		if(m_bindlessHandle == 0 && IsBindlessSupported())
+		{
+			m_bindlessHandle = s_data.getTextureHandle(m_rendererID);
+			if(m_bindlessHandle != 0)
+				s_data.makeResident(m_bindlessHandle);
+		}
+		return m_bindlessHandle;
+	}
+
+	Texture2D::Texture2D(uint32_t width, uint32_t height, TextureFormat format, uint32_t levels)
+		: Texture(GL_TEXTURE_2D, width, height, 1, format, levels)
+	{
+	}
+
+	TextureArray::TextureArray(uint32_t width, uint32_t height, uint32_t layers, TextureFormat format, uint32_t levels)
+		: Texture(GL_TEXTURE_2D_ARRAY, width, height, layers, format, levels)
+	{
+	}
+
+	TextureAsset::~TextureAsset()
+	{
+		// Released on the main thread, the texture may still be used by recorded commands
+		if(m_texture != nullptr)
+			RenderThread::Submit([texture = std::move(m_texture)]() mutable { texture.reset(); });
+	}
+
+	bool TextureAsset::Decode(std::vector<std::byte>& data)
+	{
+		constexpr size_t HeaderSize = 18;
+		auto byteAt = [&data](size_t offset) { return (uint8_t)data[offset]; };
+
+		if(data.size() < HeaderSize)
+			return false;
+
+		uint8_t idLength = byteAt(0);
+		uint8_t colorMapType = byteAt(1);
+		uint8_t imageType = byteAt(2);
+		uint32_t width = byteAt(12) | (byteAt(13) << 8);
+		uint32_t height = byteAt(14) | (byteAt(15) << 8);
+		uint8_t bitsPerPixel = byteAt(16);
+		uint8_t descriptor = byteAt(17);
+
+		bool grayscale = imageType == 3 || imageType == 11;
+		bool trueColor = imageType == 2 || imageType == 10;
+		bool rle = imageType >= 9;
+		bool supported = colorMapType == 0 && width > 0 && height > 0
+			&& ((grayscale && bitsPerPixel == 8) || (trueColor && (bitsPerPixel == 24 || bitsPerPixel == 32)));
+		if(!supported)
+		{
+			std::cout << "Error: " << GetPath() << " is not an uncompressed or RLE true-color or 8-bit grayscale TGA\n";
+			return false;
+		}
+
+		// Expand RLE packets so both encodings continue as one stream of source pixels
+		uint32_t sourceBytes = bitsPerPixel / 8;
+		size_t pixelCount = (size_t)width * height;
+		size_t position = HeaderSize + idLength;
+		std::vector<std::byte> expanded;
+		const std::byte* source;
+		if(rle)
+		{
+			expanded.resize(pixelCount * sourceBytes);
+			size_t written = 0;
+			while(written < expanded.size())
+			{
+				if(position >= data.size())
+					return false;
+
+				uint8_t packet = byteAt(position++);
+				size_t count = (size_t)(packet & 0x7f) + 1;
+				size_t bytes = std::min(count * sourceBytes, expanded.size() - written);
+				if(packet & 0x80)
+				{
+					if(position + sourceBytes > data.size())
+						return false;
+					for(size_t i = 0; i < bytes; i += sourceBytes)
+						std::memcpy(expanded.data() + written + i, data.data() + position, sourceBytes);
+					position += sourceBytes;
+				}
+				else
+				{
+					if(position + bytes > data.size())
+						return false;
+					std::memcpy(expanded.data() + written, data.data() + position, bytes);
+					position += bytes;
+				}
+				written += bytes;
+			}
+			source = expanded.data();
+		}
+		else
+		{
+			if(data.size() - position < pixelCount * sourceBytes)
+				return false;
+			source = data.data() + position;
+		}
+
+		m_width = width;
+		m_height = height;
+		m_format = grayscale ? TextureFormat::R8 : m_srgb ? TextureFormat::SRGB8Alpha8 : TextureFormat::RGBA8;
+
+		// TGA rows run bottom to top unless the descriptor says otherwise, GL wants bottom to top
+		uint32_t targetBytes = Texture::GetBytesPerPixel(m_format);
+		bool topToBottom = descriptor & 0x20;
+		m_pixels.resize(pixelCount * targetBytes);
+		for(uint32_t y = 0; y < height; y++)
+		{
+			const std::byte* sourceRow = source + (size_t)(topToBottom ? height - 1 - y : y) * width * sourceBytes;
+			std::byte* targetRow = m_pixels.data() + (size_t)y * width * targetBytes;
+
+			if(grayscale)
+			{
+				std::memcpy(targetRow, sourceRow, width);
+				continue;
+			}
+
+			for(uint32_t x = 0; x < width; x++)
+			{
+				const std::byte* bgra = sourceRow + (size_t)x * sourceBytes;
+				std::byte* rgba = targetRow + (size_t)x * 4;
+				rgba[0] = bgra[2];
+				rgba[1] = bgra[1];
+				rgba[2] = bgra[0];
+				rgba[3] = sourceBytes == 4 ? bgra[3] : std::byte{ 0xff };
+			}
+		}
+		return true;
+	}
+
+	uint32_t TextureAsset::GetRowsPerSlice() const
+	{
+		size_t rowSize = (size_t)m_width * Texture::GetBytesPerPixel(m_format);
+		return (uint32_t)std::max<size_t>(1, UploadSliceSize / rowSize);
+	}
+
+	size_t TextureAsset::GetNextUploadSize() const
+	{
+		uint32_t rows = std::min(GetRowsPerSlice(), m_height - m_uploadedRows);
+		return (size_t)rows * m_width * Texture::GetBytesPerPixel(m_format);
+	}
+
+	bool TextureAsset::Upload()
+	{
+		if(m_texture == nullptr)
+			m_texture = std::make_unique<Texture2D>(m_width, m_height, m_format);
+
+		if(m_uploadedRows < m_height)
+		{
+			size_t rowSize = (size_t)m_width * Texture::GetBytesPerPixel(m_format);
+			uint32_t rows = std::min(GetRowsPerSlice(), m_height - m_uploadedRows);
+			m_texture->UploadRows(0, 0, m_uploadedRows, rows, m_pixels.data() + m_uploadedRows * rowSize);
+			m_uploadedRows += rows;
+			if(m_uploadedRows < m_height)
+				return false;
+		}
+
+		m_texture->GenerateMipmaps();
+		m_pixels = {};
+		return true;
+	}
+}
@@ -0,0 +1,58 @@
+#include <string>
+#include <stdexcept>
+#include <unordered_map>
+
+#include "JJEngine/UniformBuffer.h"
+
+namespace JJEngine {
+	namespace {
+		struct BlockInfo {
+			GLuint bindingPoint;
+			size_t size;
+		};
+
+		struct BindingTable {
+			std::unordered_map<std::string, BlockInfo> blocks;
+			GLuint nextBindingPoint = 0;
+		};
+
+		BindingTable& GetTable(GLenum target)
+		{
+			static BindingTable uniformBlocks;
+			static BindingTable storageBlocks;
+			return target == GL_UNIFORM_BUFFER ? uniformBlocks : storageBlocks;
+		}
+
+		BlockInfo& GetBlock(std::string_view blockName, GLenum target)
+		{
+			BindingTable& table = GetTable(target);
+
+			auto it = table.blocks.find(std::string(blockName));
+			if(it != table.blocks.end())
+				return it->second;
+
+			GLint maxBindings = 0;
+			glGetIntegerv(target == GL_UNIFORM_BUFFER ? GL_MAX_UNIFORM_BUFFER_BINDINGS : GL_MAX_SHADER_STORAGE_BUFFER_BINDINGS, &maxBindings);
+			// Handing the binding out anyway would only fail later, in glBindBufferBase
+			if(table.nextBindingPoint >= (GLuint)maxBindings)
+				throw std::runtime_error("Out of buffer binding points for block '" + std::string(blockName) + "', the driver has " + std::to_string(maxBindings));
+
+			return table.blocks.emplace(std::string(blockName), BlockInfo{ table.nextBindingPoint++, 0 }).first->second;
+		}
+	}
+
+	GLuint BufferBindings::GetBindingPoint(std::string_view blockName, GLenum target)
+	{
+		return GetBlock(blockName, target).bindingPoint;
+	}
+
+	size_t BufferBindings::GetBlockSize(std::string_view blockName, GLenum target)
+	{
+		return GetBlock(blockName, target).size;
+	}
+
+	void BufferBindings::SetBlockSize(std::string_view blockName, GLenum target, size_t size)
+	{
+		GetBlock(blockName, target).size = size;
+	}
+}
@@ -1,3 +1,6 @@
+#include <cstdlib>
+#include <algorithm>
+#include <fstream>
 #include <stdexcept>
 #include <iostream>
 
@@ -5,12 +8,42 @@
 #include <GLFW/glfw3.h>
 
 #include "JJEngine/Window.h"
+#include "JJEngine/Profiler.h"
+#include "JJEngine/GpuProfiler.h"
+#include "JJEngine/RenderThread.h"
+#include "JJEngine/GLState.h"
 
 namespace JJEngine {
+	namespace {
+		bool HasDisplay()
+		{
+#if defined(_WIN32) || defined(__APPLE__)
+			return true;
+#else
+			return std::getenv("DISPLAY") != nullptr || std::getenv("WAYLAND_DISPLAY") != nullptr;
+#endif
+		}
+
+		// Mesa's software rasterizers may stop at 4.5, so headless falls back to it
+		GLFWwindow* CreateContextWindow(int width, int height, const char* title, WindowMode mode)
+		{
+			for(int minorVersion : { 6, 5 })
+			{
+				glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, minorVersion);
+				if(GLFWwindow* window = glfwCreateWindow(width, height, title, nullptr, nullptr))
+					return window;
+
+				if(mode != WindowMode::Headless)
+					break;
+			}
+			return nullptr;
+		}
+	}
+
 	Window* Window::s_instance = nullptr;
 
-	Window::Window(const char* title, int width, int height, glm::vec4 backgroundColor)
-		: m_title(title), m_width(width), m_height(height), m_clearColor(backgroundColor)
+	Window::Window(const char* title, int width, int height, glm::vec4 backgroundColor, WindowMode mode)
+		: m_title(title), m_width(width), m_height(height), m_clearColor(backgroundColor), m_mode(mode)
 	{
 		if(s_instance!=nullptr)
 		{
@@ -18,6 +51,15 @@ namespace JJEngine {
 			return;
 		}
 
+		bool nullPlatform = false;
+#ifdef GLFW_PLATFORM_NULL
+		if(mode == WindowMode::Headless && !HasDisplay())
+		{
+			glfwInitHint(GLFW_PLATFORM, GLFW_PLATFORM_NULL);
+			nullPlatform = true;
+		}
+#endif
+
 		if(!glfwInit())
 		{
 			throw std::runtime_error("Failed to initialize GLFW");
@@ -30,14 +72,34 @@ namespace JJEngine {
 		});
 
 		glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
-		glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 6);
 		glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
 
 #ifdef _DEBUG
 		glfwWindowHint(GLFW_OPENGL_DEBUG_CONTEXT, GLFW_TRUE);
 #endif
 
-		m_glfwWindow = glfwCreateWindow(width, height, title, nullptr, nullptr);
+		if(mode == WindowMode::Headless)
+		{
+			glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+			m_vsync = false;
+		}
+
+		if(nullPlatform)
+		{
+			// Surfaceless EGL first, OSMesa for Mesa builds without it
+			glfwWindowHint(GLFW_CONTEXT_CREATION_API, GLFW_EGL_CONTEXT_API);
+			m_glfwWindow = CreateContextWindow(width, height, title, mode);
+			if(!m_glfwWindow)
+			{
+				glfwWindowHint(GLFW_CONTEXT_CREATION_API, GLFW_OSMESA_CONTEXT_API);
+				m_glfwWindow = CreateContextWindow(width, height, title, mode);
+			}
+		}
+		else
+		{
+			m_glfwWindow = CreateContextWindow(width, height, title, mode);
+		}
+
 		if(!m_glfwWindow)
 		{
 			throw std::runtime_error("Failed to create GLFW window");
@@ -58,24 +120,28 @@ namespace JJEngine {
 
 		glfwSetFramebufferSizeCallback(m_glfwWindow, [](GLFWwindow* glfwWindow, int width, int height)
 		{
-			if(Window::s_instance->m_glfwWindow == glfwWindow)
+			// Headless viewports follow the offscreen target instead
+			if(Window::s_instance->m_glfwWindow == glfwWindow && !Window::s_instance->IsHeadless())
 			{
-				glViewport(0, 0, width, height);
+				RenderThread::Submit([width, height]() { GLState::SetViewport(0, 0, width, height); });
 			}
 		});
 
 		int status = gladLoadGLLoader((GLADloadproc)glfwGetProcAddress);
-		glfwSwapInterval(1);
+		glfwSwapInterval(m_vsync ? 1 : 0);
 
 		std::cout << "OpenGL version: " << glGetString(GL_VERSION) << std::endl;
 		std::cout << "GLSL version: " << glGetString(GL_SHADING_LANGUAGE_VERSION) << std::endl;
 		std::cout << "Vendor: " << glGetString(GL_VENDOR) << std::endl;
 		std::cout << "Renderer: " << glGetString(GL_RENDERER) << std::endl;
 
+		if(mode == WindowMode::Headless)
+			CreateOffscreenTarget();
+
 		glClearDepth(1.0f);
-		glEnable(GL_DEPTH_TEST);
+		GLState::SetDepthTest(true);
 
-		glClearColor(backgroundColor.x, backgroundColor.y, backgroundColor.z, backgroundColor.w);
+		GLState::SetClearColor(backgroundColor);
 
 		s_instance = this;
 	}
@@ -84,6 +150,8 @@ namespace JJEngine {
 	{
 		std::cout << "Destroying window" << std::endl;
 
+		DestroyOffscreenTarget();
+
 		glfwDestroyWindow(m_glfwWindow);
 
 		glfwTerminate();
@@ -94,12 +162,26 @@ namespace JJEngine {
 
 	void Window::Clear()
 	{
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+		GpuProfileScope gpuScope("Clear");
+		RenderThread::Submit([]() { glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT); });
 	}
 
 	void Window::Update()
 	{
-		glfwSwapBuffers(m_glfwWindow);
+		JJ_PROFILE_FUNCTION();
+
+		if(m_mode == WindowMode::Headless)
+		{
+			// Nothing is presented, just hand the frame to the driver
+			RenderThread::Submit([]() { glFlush(); });
+		}
+		else
+		{
+			GpuProfileScope gpuScope("Present");
+			RenderThread::Submit([window = m_glfwWindow]() { glfwSwapBuffers(window); });
+		}
+
+		// Events are always pumped on the main thread, only the context moves to the render thread
 		glfwPollEvents();
 	}
 
@@ -114,12 +196,21 @@ namespace JJEngine {
 		glfwSetWindowSize(m_glfwWindow, width, height);
 		m_width = width;
 		m_height = height;
+
+		if(m_mode == WindowMode::Headless)
+		{
+			RenderThread::Submit([this]()
+			{
+				DestroyOffscreenTarget();
+				CreateOffscreenTarget();
+			});
+		}
 	}
 
 	void Window::SetClearColor(glm::vec4 color)
 	{
 		m_clearColor = color;
-		glClearColor(color.x, color.y, color.z, color.w);
+		RenderThread::Submit([color]() { GLState::SetClearColor(color); });
 	}
 
 	void Window::SetClearColor(float r, float g, float b, float a)
@@ -127,9 +218,104 @@ namespace JJEngine {
 		SetClearColor(glm::vec4(r, g, b, a));
 	}
 
+	void Window::SetVSync(bool enabled)
+	{
+		// Headless frames are never presented, there is nothing to sync to
+		if(m_mode == WindowMode::Headless)
+			return;
+
+		RenderThread::Submit([enabled]() { glfwSwapInterval(enabled ? 1 : 0); });
+		m_vsync = enabled;
+	}
+
 	bool Window::ShouldClose() const
 	{
 		return glfwWindowShouldClose(m_glfwWindow);
 	}
 
+	void Window::ReadPixels(std::vector<uint8_t>& pixels) const
+	{
+		size_t rowSize = (size_t)m_width * 4;
+		pixels.resize(rowSize * m_height);
+
+		GLState::BindFramebuffer(GL_READ_FRAMEBUFFER, m_framebuffer);
+		glPixelStorei(GL_PACK_ALIGNMENT, 1);
+		glReadPixels(0, 0, m_width, m_height, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+
+		// GL returns the bottom row first
+		std::vector<uint8_t> row(rowSize);
+		for(int y = 0; y < m_height / 2; y++)
+		{
+			uint8_t* top = pixels.data() + y * rowSize;
+			uint8_t* bottom = pixels.data() + (m_height - 1 - y) * rowSize;
+			std::copy(top, top + rowSize, row.data());
+			std::copy(bottom, bottom + rowSize, top);
+			std::copy(row.data(), row.data() + rowSize, bottom);
+		}
+	}
+
+	bool Window::SaveFrame(const std::string& filePath) const
+	{
+		std::vector<uint8_t> pixels;
+		ReadPixels(pixels);
+
+		std::ofstream out(filePath, std::ios::binary);
+		if(!out)
+		{
+			std::cout << "Error: Failed to write frame " << filePath << "\n";
+			return false;
+		}
+
+		// Uncompressed 32-bit TGA, top-left origin, BGRA
+		uint8_t header[18] = {};
+		header[2] = 2;
+		header[12] = (uint8_t)(m_width & 0xFF);
+		header[13] = (uint8_t)(m_width >> 8);
+		header[14] = (uint8_t)(m_height & 0xFF);
+		header[15] = (uint8_t)(m_height >> 8);
+		header[16] = 32;
+		header[17] = 0x28;
+		out.write((const char*)header, sizeof(header));
+
+		for(size_t i = 0; i < pixels.size(); i += 4)
+			std::swap(pixels[i], pixels[i + 2]);
+		out.write((const char*)pixels.data(), pixels.size());
+
+		return (bool)out;
+	}
+
+	void Window::CreateOffscreenTarget()
+	{
+		glCreateRenderbuffers(1, &m_colorAttachment);
+		glNamedRenderbufferStorage(m_colorAttachment, GL_RGBA8, m_width, m_height);
+
+		glCreateRenderbuffers(1, &m_depthAttachment);
+		glNamedRenderbufferStorage(m_depthAttachment, GL_DEPTH24_STENCIL8, m_width, m_height);
+
+		glCreateFramebuffers(1, &m_framebuffer);
+		glNamedFramebufferRenderbuffer(m_framebuffer, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, m_colorAttachment);
+		glNamedFramebufferRenderbuffer(m_framebuffer, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, m_depthAttachment);
+
+		if(glCheckNamedFramebufferStatus(m_framebuffer, GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+		{
+			DestroyOffscreenTarget();
+			throw std::runtime_error("Failed to create offscreen framebuffer");
+		}
+
+		GLState::BindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+		GLState::SetViewport(0, 0, m_width, m_height);
+	}
+
+	void Window::DestroyOffscreenTarget()
+	{
+		if(m_framebuffer == 0)
+			return;
+
+		GLState::BindFramebuffer(GL_FRAMEBUFFER, 0);
+		GLState::DeleteFramebuffer(m_framebuffer);
+		glDeleteRenderbuffers(1, &m_colorAttachment);
+		glDeleteRenderbuffers(1, &m_depthAttachment);
+		m_framebuffer = m_colorAttachment = m_depthAttachment = 0;
+	}
+
 }
@@ -0,0 +1,253 @@
+// Exercises the frame, linear and pool allocators directly and as std::pmr resources: alignment,
+// reuse after Reset and Free, and what happens once an arena or pool is exhausted. A counting
+// upstream resource checks that overflow goes upstream and is handed back. CPU only.
+
+#include <set>
+#include <thread>
+#include <vector>
+#include <string>
+#include <cstring>
+#include <iostream>
+
+#include "JJEngine/Allocators.h"
+
+using namespace JJEngine;
+
+namespace {
+	uint32_t s_failures = 0;
+
+	void Check(bool condition, const std::string& what)
+	{
+		if(!condition)
+		{
+			std::cout << "Error: " << what << "\n";
+			s_failures++;
+		}
+	}
+
+	bool IsAligned(const void* pointer, size_t alignment)
+	{
+		return ((uintptr_t)pointer & (alignment - 1)) == 0;
+	}
+
+	// Counts what reaches the upstream resource, so overflow can be told apart from arena memory
+	class CountingResource : public std::pmr::memory_resource {
+	public:
+		size_t allocations = 0;
+		size_t deallocations = 0;
+		size_t liveBytes = 0;
+
+	protected:
+		void* do_allocate(size_t bytes, size_t alignment) override
+		{
+			allocations++;
+			liveBytes += bytes;
+			return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+		}
+
+		void do_deallocate(void* pointer, size_t bytes, size_t alignment) override
+		{
+			deallocations++;
+			liveBytes -= bytes;
+			std::pmr::new_delete_resource()->deallocate(pointer, bytes, alignment);
+		}
+
+		bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+	};
+
+	struct Tracked {
+		static inline int live = 0;
+
+		alignas(32) uint64_t value;
+
+		Tracked(uint64_t value) : value(value) { live++; }
+		~Tracked() { live--; }
+	};
+
+	void TestLinearAllocator()
+	{
+		CountingResource upstream;
+		{
+			LinearAllocator arena(4096, &upstream);
+
+			std::byte* first = (std::byte*)arena.Allocate(1, 1);
+			for(size_t alignment = 1; alignment <= 256; alignment *= 2)
+			{
+				void* pointer = arena.Allocate(3, alignment);
+				Check(IsAligned(pointer, alignment), "LinearAllocator ignored alignment " + std::to_string(alignment));
+				Check((std::byte*)pointer >= first && (std::byte*)pointer + 3 <= first + arena.GetCapacity(), "LinearAllocator allocated outside its block");
+			}
+			Check(upstream.allocations == 0, "LinearAllocator overflowed before it was full");
+			Check(arena.GetStats().allocations == 10, "LinearAllocator counted " + std::to_string(arena.GetStats().allocations) + " allocations, expected 10");
+
+			// Past the end of the block requests are served upstream and stay valid until Reset
+			void* overflow = arena.Allocate(8192, 64);
+			Check(overflow != nullptr && IsAligned(overflow, 64), "LinearAllocator returned a bad overflow block");
+			std::memset(overflow, 0xAB, 8192);
+			Check(upstream.allocations == 1 && arena.GetStats().overflowBytes == 8192, "LinearAllocator did not take the overflow from upstream");
+
+			arena.Reset();
+			Check(upstream.liveBytes == 0, "LinearAllocator::Reset kept overflow blocks");
+			Check(arena.GetStats().bytes == 0 && arena.GetStats().allocations == 0, "LinearAllocator::Reset kept its statistics");
+			Check(arena.Allocate(1, 1) == first, "LinearAllocator::Reset did not rewind to the start of the block");
+
+			// As a pmr resource, growth leaves the old buffers behind until Reset
+			arena.Reset();
+			{
+				std::pmr::vector<uint32_t> values(&arena);
+				for(uint32_t i = 0; i < 256; i++)
+					values.push_back(i);
+				bool intact = true;
+				for(uint32_t i = 0; i < 256; i++)
+					intact &= values[i] == i;
+				Check(intact, "std::pmr::vector on a LinearAllocator lost values");
+			}
+			Check(upstream.allocations == 1, "std::pmr::vector overflowed a LinearAllocator that had room");
+
+			// Allocation is a single atomic add, concurrent allocations must never overlap
+			arena.Reset();
+			constexpr int ThreadCount = 4;
+			constexpr int PerThread = 32; // Fits the block, the counting upstream is not thread safe
+			std::vector<std::vector<std::byte*>> pointers(ThreadCount);
+			std::vector<std::thread> threads;
+			for(int t = 0; t < ThreadCount; t++)
+			{
+				threads.emplace_back([&arena, &pointers, t]()
+				{
+					for(int i = 0; i < PerThread; i++)
+					{
+						std::byte* pointer = (std::byte*)arena.Allocate(16, 16);
+						std::memset(pointer, t, 16);
+						pointers[t].push_back(pointer);
+					}
+				});
+			}
+			for(std::thread& thread : threads)
+				thread.join();
+
+			std::set<std::byte*> unique;
+			bool untouched = true;
+			for(int t = 0; t < ThreadCount; t++)
+			{
+				for(std::byte* pointer : pointers[t])
+				{
+					unique.insert(pointer);
+					for(int i = 0; i < 16; i++)
+						untouched &= pointer[i] == (std::byte)t;
+				}
+			}
+			Check(unique.size() == ThreadCount * PerThread && untouched, "Concurrent LinearAllocator allocations overlapped");
+		}
+		Check(upstream.liveBytes == 0 && upstream.allocations == upstream.deallocations, "LinearAllocator leaked upstream memory");
+	}
+
+	void TestFrameAllocator()
+	{
+		FrameAllocator frames(1024);
+
+		frames.BeginFrame();
+		uint64_t* previous = frames.New<uint64_t>(0x1234);
+		frames.Allocate(100);
+
+		// Frame N's data is still readable during frame N+1, when a render thread consumes it
+		frames.BeginFrame();
+		Check(*previous == 0x1234, "FrameAllocator reset the previous frame's arena");
+		Check(frames.GetLastFrameStats().allocations == 2, "FrameAllocator reported " + std::to_string(frames.GetLastFrameStats().allocations) + " allocations for the last frame, expected 2");
+		Check(frames.GetCurrent().GetStats().allocations == 0, "FrameAllocator started a frame with a used arena");
+
+		// Two frames later the arena comes round again, empty
+		frames.BeginFrame();
+		uint64_t* reused = frames.New<uint64_t>(0x5678);
+		Check(reused == previous, "FrameAllocator did not reuse the arena from two frames ago");
+		Check(frames.GetLastFrameStats().allocations == 0, "FrameAllocator reported allocations for an empty frame");
+	}
+
+	void TestPoolAllocator()
+	{
+		constexpr size_t BlockCount = 8;
+
+		CountingResource upstream;
+		{
+			PoolAllocator pool(40, BlockCount, 16, &upstream);
+			Check(pool.GetBlockSize() == 48, "PoolAllocator rounded a 40 byte block to " + std::to_string(pool.GetBlockSize()) + ", expected 48");
+
+			std::set<void*> blocks;
+			for(size_t i = 0; i < BlockCount; i++)
+			{
+				void* block = pool.Allocate();
+				Check(block != nullptr && IsAligned(block, 16), "PoolAllocator returned a bad block");
+				blocks.insert(block);
+			}
+			Check(blocks.size() == BlockCount && pool.GetUsedBlocks() == BlockCount, "PoolAllocator handed out a block twice");
+			Check(pool.Allocate() == nullptr, "PoolAllocator allocated past its block count");
+
+			// Freed blocks go to the front of the free list
+			void* freed = *blocks.begin();
+			pool.Free(freed);
+			Check(pool.GetUsedBlocks() == BlockCount - 1, "PoolAllocator::Free did not release the block");
+			Check(pool.Allocate() == freed, "PoolAllocator did not reuse a freed block");
+
+			// Through the pmr interface an exhausted pool and oversized requests fall back to upstream
+			pool.ResetStats();
+			void* exhausted = pool.allocate(16, 8);
+			void* oversized = pool.allocate(64, 8);
+			void* overaligned = pool.allocate(16, 64);
+			Check(upstream.allocations == 3 && pool.GetStats().overflowBytes == 96, "PoolAllocator did not send overflow upstream");
+			Check(IsAligned(overaligned, 64), "PoolAllocator overflow ignored alignment");
+			pool.deallocate(exhausted, 16, 8);
+			pool.deallocate(oversized, 64, 8);
+			pool.deallocate(overaligned, 16, 64);
+			Check(upstream.liveBytes == 0 && pool.GetUsedBlocks() == BlockCount, "PoolAllocator returned overflow to the pool");
+
+			for(void* block : blocks)
+				pool.Free(block);
+			Check(pool.GetUsedBlocks() == 0, "PoolAllocator still has blocks in use after freeing all of them");
+
+			// Node containers are what the pool is for, every node fits a block
+			{
+				std::pmr::set<uint32_t> values(&pool);
+				for(uint32_t i = 0; i < BlockCount; i++)
+					values.insert(i);
+				Check(pool.GetUsedBlocks() == BlockCount && upstream.allocations == 3, "std::pmr::set nodes did not come from the pool");
+			}
+			Check(pool.GetUsedBlocks() == 0, "std::pmr::set did not return its nodes to the pool");
+		}
+		Check(upstream.liveBytes == 0 && upstream.allocations == upstream.deallocations, "PoolAllocator leaked upstream memory");
+	}
+
+	void TestObjectPool()
+	{
+		ObjectPool<Tracked> pool(4);
+
+		std::vector<Tracked*> objects;
+		for(uint64_t i = 0; i < 6; i++)
+			objects.push_back(pool.New(i));
+
+		bool aligned = true;
+		bool intact = true;
+		for(uint64_t i = 0; i < objects.size(); i++)
+		{
+			aligned &= IsAligned(objects[i], alignof(Tracked));
+			intact &= objects[i]->value == i;
+		}
+		Check(aligned && intact, "ObjectPool returned misaligned or overlapping objects");
+		Check(Tracked::live == 6 && pool.GetAllocator().GetUsedBlocks() == 4, "ObjectPool did not fill the pool before overflowing");
+
+		for(Tracked* object : objects)
+			pool.Delete(object);
+		pool.Delete(nullptr);
+		Check(Tracked::live == 0, "ObjectPool::Delete did not destroy every object");
+		Check(pool.GetAllocator().GetUsedBlocks() == 0, "ObjectPool::Delete did not return every block");
+	}
+}
+
+int main()
+{
+	TestLinearAllocator();
+	TestFrameAllocator();
+	TestPoolAllocator();
+	TestObjectPool();
+
+	std::cout << (s_failures == 0 ? "All allocator checks passed\n" : std::to_string(s_failures) + " allocator checks failed\n");
+	return s_failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,108 @@
+// Runs the GPU profiler headless with a render thread and checks that pass timings arrive within
+// the profiler's readback latency, without a result ever being read before the driver reports it
+// available. Needs a GL 4.5 driver, Mesa llvmpipe in CI.
+
+#include <atomic>
+#include <iostream>
+#include <algorithm>
+
+#include "JJEngine/JJEngine.h"
+
+using namespace JJEngine;
+
+namespace {
+	constexpr uint32_t FrameCount = 32;
+
+	// Frame 1's queries are read FramesInFlight frames later on the render thread, which runs one
+	// frame behind, and the main thread sees them the frame after that
+	constexpr uint32_t MaxResultLatency = 1 + GpuProfiler::FramesInFlight + 2;
+
+	PFNGLGETQUERYOBJECTUI64VPROC s_getQueryResult = nullptr;
+	std::atomic<uint32_t> s_resultReads = 0;
+	std::atomic<uint32_t> s_blockingReads = 0;
+
+	// Stands in for glGetQueryObjectui64v and counts reads that would have waited on the GPU
+	void APIENTRY GetQueryResultChecked(GLuint query, GLenum name, GLuint64* value)
+	{
+		if(name == GL_QUERY_RESULT)
+		{
+			GLint available = GL_FALSE;
+			glGetQueryObjectiv(query, GL_QUERY_RESULT_AVAILABLE, &available);
+			s_resultReads++;
+			if(!available)
+				s_blockingReads++;
+		}
+		s_getQueryResult(query, name, value);
+	}
+
+	class GpuProfilerTest : public Application {
+	public:
+		GpuProfilerTest() : Application("GpuProfilerTest", false, WindowMode::Headless)
+		{
+			s_getQueryResult = glad_glGetQueryObjectui64v;
+			glad_glGetQueryObjectui64v = GetQueryResultChecked;
+			SetFramesInFlight(1);
+		}
+
+		uint32_t GetFirstResultFrame() const { return m_firstResultFrame; }
+
+	protected:
+		void OnRender(double /*alpha*/) override
+		{
+			m_frame++;
+			{
+				GpuProfileScope scope("Test");
+				RenderThread::Submit([]() { glClear(GL_COLOR_BUFFER_BIT); });
+			}
+
+			std::vector<GpuProfiler::PassTiming> timings = GpuProfiler::GetPassTimings();
+			bool arrived = std::any_of(timings.begin(), timings.end(), [](const GpuProfiler::PassTiming& timing) { return timing.name == "Test"; });
+			if(arrived && m_firstResultFrame == 0)
+				m_firstResultFrame = m_frame;
+
+			if(m_frame >= FrameCount)
+				Close();
+		}
+
+	private:
+		uint32_t m_frame = 0;
+		uint32_t m_firstResultFrame = 0;
+	};
+}
+
+int main()
+{
+	uint32_t firstResultFrame;
+	uint32_t droppedFrames;
+	double frameTime, testTime;
+	{
+		GpuProfilerTest test;
+		test.Run();
+
+		firstResultFrame = test.GetFirstResultFrame();
+		droppedFrames = GpuProfiler::GetDroppedFrames();
+		frameTime = GpuProfiler::GetPassTime("Frame");
+		testTime = GpuProfiler::GetPassTime("Test");
+	}
+
+	std::cout << "First results in frame " << firstResultFrame << ", " << s_resultReads << " result reads, "
+		<< droppedFrames << " dropped frames, Frame " << frameTime << " ms, Test " << testTime << " ms\n";
+
+	bool passed = true;
+	if(firstResultFrame == 0 || firstResultFrame > MaxResultLatency)
+	{
+		std::cout << "Error: pass timings should arrive by frame " << MaxResultLatency << "\n";
+		passed = false;
+	}
+	if(s_blockingReads > 0)
+	{
+		std::cout << "Error: " << s_blockingReads << " query results were read before they were available\n";
+		passed = false;
+	}
+	if(frameTime < testTime)
+	{
+		std::cout << "Error: the Test pass is nested in Frame but took longer\n";
+		passed = false;
+	}
+	return passed ? 0 : 1;
+}
@@ -0,0 +1,163 @@
+// Culls small objects against a Hi-Z pyramid of an odd sized depth buffer with a near occluder in one
+// corner, then checks every object that overlaps a far texel was drawn and that most of the objects
+// fully behind the occluder were culled. Needs a GL 4.5 driver, Mesa llvmpipe in CI.
+
+#include <cmath>
+#include <algorithm>
+#include <iostream>
+
+#include "JJEngine/JJEngine.h"
+
+using namespace JJEngine;
+
+namespace {
+	// Odd in both directions, so every level folds leftover texels into its last row and column
+	constexpr int Width = 61;
+	constexpr int Height = 37;
+
+	// Depth is near inside [0, OccluderWidth) x [0, OccluderHeight) texels and far elsewhere
+	constexpr int OccluderWidth = 41;
+	constexpr int OccluderHeight = 23;
+	constexpr float OccluderDepth = 0.2f;
+
+	struct ObjectData {
+		glm::vec4 offsetScale;
+		glm::vec4 color;
+	};
+
+	const char* VertexSource = R"(#version 450 core
+#extension GL_ARB_shader_draw_parameters : enable
+layout (location = 0) in vec2 aPosition;
+layout (location = 15) in uint aObjectIndex;
+
+struct ObjectData
+{
+    vec4 offsetScale;
+    vec4 color;
+};
+
+layout (std430) readonly buffer Objects
+{
+    ObjectData uObjects[];
+};
+
+void main()
+{
+#ifdef GL_ARB_shader_draw_parameters
+    uint objectIndex = gl_BaseInstanceARB;
+#else
+    uint objectIndex = aObjectIndex;
+#endif
+    ObjectData object = uObjects[objectIndex];
+    gl_Position = vec4(aPosition * object.offsetScale.z + object.offsetScale.xy, 0.0, 1.0);
+}
+)";
+
+	const char* FragmentSource = R"(#version 450 core
+out vec4 oColor;
+
+void main()
+{
+    oColor = vec4(1.0);
+}
+)";
+
+	// Base texels covered by the screen space box of a sphere at depth 0 under an identity view projection
+	bool OverlapsFarTexel(const glm::vec4& sphere)
+	{
+		// The occluder sits in the lower left corner, so only the upper bounds matter
+		int maxX = std::clamp((int)((sphere.x + sphere.w) * 0.5f * Width + Width * 0.5f), 0, Width - 1);
+		int maxY = std::clamp((int)((sphere.y + sphere.w) * 0.5f * Height + Height * 0.5f), 0, Height - 1);
+		return maxX >= OccluderWidth || maxY >= OccluderHeight;
+	}
+}
+
+int main()
+{
+	Window window("HiZCullingTest", Width, Height, glm::vec4(0, 0, 0, 1), WindowMode::Headless);
+	RenderThread::Init(window.GetGLFWWindow());
+
+	bool passed = true;
+	{
+		GLuint depthTexture;
+		glCreateTextures(GL_TEXTURE_2D, 1, &depthTexture);
+		glTextureStorage2D(depthTexture, 1, GL_DEPTH_COMPONENT32F, Width, Height);
+		float farDepth = 1.0f;
+		glClearTexImage(depthTexture, 0, GL_DEPTH_COMPONENT, GL_FLOAT, &farDepth);
+		glClearTexSubImage(depthTexture, 0, 0, 0, 0, OccluderWidth, OccluderHeight, 1, GL_DEPTH_COMPONENT, GL_FLOAT, &OccluderDepth);
+
+		HiZPyramid hiZ(Width, Height);
+		hiZ.Build(depthTexture);
+
+		const glm::vec2 quadPositions[4] = { { -1.0f, -1.0f }, { 1.0f, -1.0f }, { 1.0f, 1.0f }, { -1.0f, 1.0f } };
+		const uint32_t quadIndices[6] = { 0, 1, 2, 2, 3, 0 };
+		GeometryPool pool(VertexLayout({ VertexAttribute::Float2 }), 4, 6);
+		GeometryPool::MeshRange quad = pool.Add(quadPositions, 4, quadIndices, 6);
+
+		// Sweeps boxes of a few texels across the occluder edges at sub-texel steps. Each object draws
+		// a dot on its own pixel, in index order, so the image shows which ones survived.
+		IndirectDrawList drawList(pool, sizeof(ObjectData));
+		std::vector<glm::vec4> spheres;
+		for(float y = -0.9f; y < 0.9f; y += 0.045f)
+		{
+			for(float x = -0.9f; x < 0.9f; x += 0.037f)
+			{
+				float radius = 0.04f + 0.06f * (0.5f + 0.5f * std::sin(x * 17.0f + y * 5.0f));
+				spheres.push_back(glm::vec4(x, y, 0.0f, radius));
+
+				uint32_t index = (uint32_t)spheres.size() - 1;
+				glm::vec2 dot((index % Width + 0.5f) / Width * 2.0f - 1.0f, (index / Width + 0.5f) / Height * 2.0f - 1.0f);
+				drawList.Add(quad, ObjectData{ glm::vec4(dot.x, dot.y, 0.9f / Width, 0.0f), glm::vec4(1.0f) });
+			}
+		}
+
+		Shader shader;
+		shader.LoadFromSource(VertexSource, FragmentSource);
+
+		GpuCuller culler;
+		culler.SetBounds(spheres.data(), (uint32_t)spheres.size());
+
+		window.Clear();
+		culler.CullAndDraw(drawList, shader, glm::mat4(1.0f), &hiZ);
+
+		std::vector<uint8_t> pixels;
+		window.ReadPixels(pixels);
+
+		uint32_t falselyCulled = 0, hidden = 0, culled = 0;
+		for(uint32_t i = 0; i < (uint32_t)spheres.size(); i++)
+		{
+			const glm::vec4& sphere = spheres[i];
+			bool drawn = pixels[((size_t)(Height - 1 - i / Width) * Width + i % Width) * 4] != 0;
+
+			if(OverlapsFarTexel(sphere))
+			{
+				if(!drawn)
+					falselyCulled++;
+			}
+			else
+			{
+				hidden++;
+				if(!drawn)
+					culled++;
+			}
+		}
+
+		std::cout << spheres.size() << " objects, " << culled << " of " << hidden << " hidden ones culled, " << falselyCulled << " visible ones culled\n";
+
+		if(falselyCulled > 0)
+		{
+			std::cout << "Error: objects overlapping far depth were culled\n";
+			passed = false;
+		}
+		if(culled * 2 < hidden)
+		{
+			std::cout << "Error: fewer than half of the hidden objects were culled\n";
+			passed = false;
+		}
+
+		GLState::DeleteTexture(depthTexture);
+	}
+
+	RenderThread::Shutdown();
+	return passed ? 0 : 1;
+}
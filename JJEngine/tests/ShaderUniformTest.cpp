@@ -0,0 +1,76 @@
+// Links a program with a large uniform array and checks that the reflected uniform table resolves
+// every element, the bare array name and the plain uniforms to the driver's locations, and that
+// names missing from the program come back as -1. Needs a GL 4.5 driver, Mesa llvmpipe in CI.
+
+#include <string>
+#include <iostream>
+
+#include "JJEngine/JJEngine.h"
+
+using namespace JJEngine;
+
+namespace {
+	constexpr int BoneCount = 200;
+
+	const char* VertexSource = R"(#version 450 core
+layout (location = 0) in vec3 aPosition;
+
+uniform mat4 uModel;
+uniform vec4 uBones[200];
+
+void main()
+{
+    gl_Position = uModel * vec4(aPosition + uBones[gl_VertexID % 200].xyz, 1.0);
+}
+)";
+
+	const char* FragmentSource = R"(#version 450 core
+uniform vec4 uColor;
+uniform float uScale;
+out vec4 oColor;
+
+void main()
+{
+    oColor = uColor * uScale;
+}
+)";
+}
+
+int main()
+{
+	Window window("ShaderUniformTest", 64, 64, glm::vec4(0, 0, 0, 1), WindowMode::Headless);
+	RenderThread::Init(window.GetGLFWWindow());
+
+	uint32_t wrong = 0;
+	{
+		Shader shader;
+		shader.LoadFromSource(VertexSource, FragmentSource);
+		GLuint program = shader.GetRendererID();
+
+		auto check = [&](const std::string& name, GLint expected)
+		{
+			GLint location = shader.GetUniformLocation(UniformName(name));
+			if(location != expected)
+			{
+				std::cout << "Error: " << name << " resolved to " << location << ", expected " << expected << "\n";
+				wrong++;
+			}
+		};
+
+		for(const char* name : { "uModel", "uColor", "uScale", "uBones" })
+			check(name, glGetUniformLocation(program, name));
+		for(int i = 0; i < BoneCount; i++)
+		{
+			std::string name = "uBones[" + std::to_string(i) + "]";
+			check(name, glGetUniformLocation(program, name.c_str()));
+		}
+
+		for(const char* name : { "uView", "uBones[200]", "uColour", "" })
+			check(name, -1);
+
+		std::cout << BoneCount + 4 << " uniforms resolved, " << wrong << " wrong\n";
+	}
+
+	RenderThread::Shutdown();
+	return wrong == 0 ? 0 : 1;
+}
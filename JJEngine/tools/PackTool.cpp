@@ -0,0 +1,255 @@
+// JJPack: packs a directory into a single pack file for JJEngine::PackFile.
+//
+//   JJPack <input directory> <output file> [--align <bytes>] [--compress auto|none|lz4|zstd]
+//
+// auto picks LZ4 when it was found at build time, then Zstd, then none. Entries are only stored
+// compressed if that saves at least an eighth, already compressed formats stay as they are.
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <iostream>
+#include <algorithm>
+#include <filesystem>
+
+#include "JJEngine/PackFile.h"
+#include "JJEngine/MappedFile.h"
+
+#if defined(JJ_PACK_LZ4)
+#include <lz4hc.h>
+#endif
+#if defined(JJ_PACK_ZSTD)
+#include <zstd.h>
+#endif
+
+using namespace JJEngine;
+
+namespace {
+	struct Options {
+		std::filesystem::path input;
+		std::filesystem::path output;
+		uint32_t alignment = 64;
+		PackFormat::Compression compression = PackFormat::Compression::None;
+	};
+
+	PackFormat::Compression GetDefaultCompression()
+	{
+		if(PackFormat::IsSupported(PackFormat::Compression::LZ4))
+			return PackFormat::Compression::LZ4;
+		if(PackFormat::IsSupported(PackFormat::Compression::Zstd))
+			return PackFormat::Compression::Zstd;
+		return PackFormat::Compression::None;
+	}
+
+	bool ParseOptions(int argc, char** argv, Options& options)
+	{
+		if(argc < 3)
+			return false;
+
+		options.input = argv[1];
+		options.output = argv[2];
+		options.compression = GetDefaultCompression();
+
+		for(int i = 3; i + 1 < argc; i += 2)
+		{
+			std::string_view option = argv[i];
+			std::string_view value = argv[i + 1];
+			if(option == "--align")
+			{
+				options.alignment = (uint32_t)std::stoul(std::string(value));
+				if(options.alignment == 0 || (options.alignment & (options.alignment - 1)) != 0)
+				{
+					std::cerr << "Error: --align must be a power of two\n";
+					return false;
+				}
+			}
+			else if(option == "--compress")
+			{
+				if(value == "auto")
+					options.compression = GetDefaultCompression();
+				else if(value == "none")
+					options.compression = PackFormat::Compression::None;
+				else if(value == "lz4")
+					options.compression = PackFormat::Compression::LZ4;
+				else if(value == "zstd")
+					options.compression = PackFormat::Compression::Zstd;
+				else
+					return false;
+
+				if(!PackFormat::IsSupported(options.compression))
+				{
+					std::cerr << "Error: JJPack was built without " << value << "\n";
+					return false;
+				}
+			}
+			else
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	// Returns an empty vector if compression isn't worth it
+	std::vector<std::byte> Compress(std::span<const std::byte> data, PackFormat::Compression compression)
+	{
+		std::vector<std::byte> compressed;
+		size_t size = 0;
+
+		switch(compression)
+		{
+#if defined(JJ_PACK_LZ4)
+		case PackFormat::Compression::LZ4:
+			compressed.resize(LZ4_compressBound((int)data.size()));
+			size = (size_t)LZ4_compress_HC((const char*)data.data(), (char*)compressed.data(), (int)data.size(), (int)compressed.size(), LZ4HC_CLEVEL_DEFAULT);
+			break;
+#endif
+#if defined(JJ_PACK_ZSTD)
+		case PackFormat::Compression::Zstd:
+		{
+			compressed.resize(ZSTD_compressBound(data.size()));
+			size_t result = ZSTD_compress(compressed.data(), compressed.size(), data.data(), data.size(), 12);
+			size = ZSTD_isError(result) ? 0 : result;
+			break;
+		}
+#endif
+		default:
+			break;
+		}
+
+		if(size == 0 || size > data.size() - data.size() / 8)
+			return {};
+
+		compressed.resize(size);
+		return compressed;
+	}
+
+	void Pad(std::ofstream& out, uint64_t alignment)
+	{
+		static const char zeros[4096] = {};
+		uint64_t position = (uint64_t)out.tellp();
+		uint64_t padding = (alignment - position % alignment) % alignment;
+		while(padding > 0)
+		{
+			uint64_t chunk = std::min<uint64_t>(padding, sizeof(zeros));
+			out.write(zeros, (std::streamsize)chunk);
+			padding -= chunk;
+		}
+	}
+}
+
+int main(int argc, char** argv)
+{
+	Options options;
+	if(!ParseOptions(argc, argv, options))
+	{
+		std::cerr << "Usage: JJPack <input directory> <output file> [--align <bytes>] [--compress auto|none|lz4|zstd]\n";
+		return 1;
+	}
+
+	std::error_code error;
+	if(!std::filesystem::is_directory(options.input, error))
+	{
+		std::cerr << "Error: " << options.input << " is not a directory\n";
+		return 1;
+	}
+
+	// Sorted by path, so a directory's files end up next to each other in the pack
+	std::vector<std::string> paths;
+	for(const auto& file : std::filesystem::recursive_directory_iterator(options.input))
+	{
+		if(file.is_regular_file())
+			paths.push_back(file.path().lexically_relative(options.input).generic_string());
+	}
+	std::sort(paths.begin(), paths.end());
+
+	std::filesystem::path temporary = options.output;
+	temporary += ".tmp";
+	std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+	if(!out)
+	{
+		std::cerr << "Error: Can't write " << temporary << "\n";
+		return 1;
+	}
+
+	PackFormat::Header header{};
+	out.write((const char*)&header, sizeof(header));
+
+	std::vector<PackFormat::Entry> entries;
+	std::string names;
+	uint64_t originalBytes = 0, storedBytes = 0;
+
+	for(const std::string& path : paths)
+	{
+		MappedFile file((options.input / path).string());
+		if(!file.IsOpen())
+		{
+			std::cerr << "Error: Can't read " << path << "\n";
+			return 1;
+		}
+
+		std::span<const std::byte> data = file.GetData();
+		std::vector<std::byte> compressed = Compress(data, options.compression);
+		std::span<const std::byte> stored = compressed.empty() ? data : std::span<const std::byte>(compressed);
+
+		Pad(out, options.alignment);
+
+		PackFormat::Entry entry{};
+		entry.pathHash = PackFormat::HashPath(path);
+		entry.offset = (uint64_t)out.tellp();
+		entry.size = stored.size();
+		entry.originalSize = data.size();
+		entry.nameOffset = (uint32_t)names.size();
+		entry.nameLength = (uint32_t)path.size();
+		entry.compression = compressed.empty() ? PackFormat::Compression::None : options.compression;
+		entries.push_back(entry);
+
+		names += path;
+		out.write((const char*)stored.data(), (std::streamsize)stored.size());
+		originalBytes += data.size();
+		storedBytes += stored.size();
+	}
+
+	std::sort(entries.begin(), entries.end(), [](const PackFormat::Entry& a, const PackFormat::Entry& b) { return a.pathHash < b.pathHash; });
+	for(size_t i = 1; i < entries.size(); i++)
+	{
+		if(entries[i].pathHash == entries[i - 1].pathHash)
+		{
+			std::cerr << "Error: " << names.substr(entries[i].nameOffset, entries[i].nameLength) << " and "
+				<< names.substr(entries[i - 1].nameOffset, entries[i - 1].nameLength) << " have the same path hash, rename one\n";
+			return 1;
+		}
+	}
+
+	Pad(out, alignof(PackFormat::Entry));
+	header.magic = PackFormat::Magic;
+	header.version = PackFormat::Version;
+	header.entryCount = (uint32_t)entries.size();
+	header.alignment = options.alignment;
+	header.tocOffset = (uint64_t)out.tellp();
+	out.write((const char*)entries.data(), (std::streamsize)(entries.size() * sizeof(PackFormat::Entry)));
+
+	header.namesOffset = (uint64_t)out.tellp();
+	header.namesSize = names.size();
+	out.write(names.data(), (std::streamsize)names.size());
+
+	out.seekp(0);
+	out.write((const char*)&header, sizeof(header));
+	out.close();
+	if(!out)
+	{
+		std::cerr << "Error: Failed writing " << temporary << "\n";
+		return 1;
+	}
+
+	// Replaced in one step, a running game never maps a half written pack
+	std::filesystem::rename(temporary, options.output, error);
+	if(error)
+	{
+		std::cerr << "Error: Can't replace " << options.output << ": " << error.message() << "\n";
+		return 1;
+	}
+
+	std::cout << "Packed " << entries.size() << " files, " << originalBytes << " bytes into " << storedBytes << " bytes\n";
+	return 0;
+}
@@ -1,12 +1,20 @@
 #version 330 core
 layout (location = 0) in vec3 aPos;
+#ifdef VERTEX_COLOR
+layout (location = 1) in vec3 aColor;
+#endif
   
 out vec4 oVertexColor;
 
 uniform vec4 uColor;
+uniform mat4 uModel;
 
 void main()
 {
+#ifdef VERTEX_COLOR
+    oVertexColor = uColor * vec4(aColor, 1.0);
+#else
     oVertexColor = uColor;
-    gl_Position = vec4(aPos, 1.0);
+#endif
+    gl_Position = uModel * vec4(aPos, 1.0);
 }
\ No newline at end of file
@@ -0,0 +1,33 @@
+#version 450 core
+#extension GL_ARB_shader_draw_parameters : enable
+layout (location = 0) in vec3 aPos;
+// GeometryPool::ObjectIndexLocation, for drivers without shader draw parameters
+layout (location = 15) in uint aObjectIndex;
+
+struct ObjectData
+{
+    vec4 offsetScale;
+    vec4 color;
+};
+
+layout (std430) readonly buffer Objects
+{
+    ObjectData uObjects[];
+};
+
+uniform mat4 uViewProjection;
+
+out vec4 vColor;
+
+void main()
+{
+    // baseInstance holds the object index, gl_DrawID changes when GPU culling compacts the draws
+#ifdef GL_ARB_shader_draw_parameters
+    uint objectIndex = gl_BaseInstanceARB;
+#else
+    uint objectIndex = aObjectIndex;
+#endif
+    ObjectData object = uObjects[objectIndex];
+    vColor = object.color;
+    gl_Position = uViewProjection * vec4(aPos.xy * object.offsetScale.z + object.offsetScale.xy, 0.0, 1.0);
+}
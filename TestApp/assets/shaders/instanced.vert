@@ -0,0 +1,16 @@
+#version 450 core
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aVertexColor;
+
+// Per instance
+layout (location = 2) in vec2 aOffset;
+layout (location = 3) in float aScale;
+layout (location = 4) in vec4 aColor;
+
+out vec4 vColor;
+
+void main()
+{
+    vColor = aColor;
+    gl_Position = vec4(aPos.xy * aScale + aOffset, 0.0, 1.0);
+}
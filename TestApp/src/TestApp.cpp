@@ -1,5 +1,14 @@
+#ifdef _WIN32
 #include <windows.h>
+#endif
 #include <iostream>
+#include <string>
+#include <cstring>
+#include <cstdlib>
+#include <vector>
+#include <cmath>
+
+#include <glm/gtc/matrix_transform.hpp>
 
 #include "JJEngine/JJEngine.h"
 
@@ -9,43 +18,276 @@ float vertices[] = {
     // positions         // colors
      0.5f, -0.5f, 0.0f,  1.0f, 0.0f, 0.0f,   // bottom right
     -0.5f, -0.5f, 0.0f,  0.0f, 1.0f, 0.0f,   // bottom left
-     0.0f,  0.5f, 0.0f,  0.0f, 0.0f, 1.0f    // top 
-};    
+     0.0f,  0.5f, 0.0f,  0.0f, 0.0f, 1.0f    // top
+};
 
-int APIENTRY WinMain(HINSTANCE hInst, HINSTANCE hInstPrev, PSTR cmdline, int cmdshow)
-{
-	Application app("Test App");
-	Window& window = app.GetWindow();
+constexpr int quadGridSize = 100;
+constexpr int triangleCount = 8;
+constexpr int instancedTriangleCount = 20000;
+
+constexpr int indirectObjectCount = 64;
+
+// Matches ObjectData in indirect.vert
+struct IndirectObject {
+	glm::vec4 offsetScale;
+	glm::vec4 color;
+};
+
+struct TriangleInstance {
+	glm::vec2 offset;
+	float scale;
+	uint32_t color;
+};
+
+// --headless renders offscreen with vsync off, --frames N exits after N frames,
+// --capture path.tga saves the last frame for golden-image comparison,
+// --frames-in-flight 0|1|2 sets how far the main thread may run ahead of the render thread,
+// --offset X freezes the animation at X so captures are reproducible,
+// --no-culling draws the indirect row without GpuCuller, a capture must match the culled one
+struct TestAppOptions {
+	bool headless = false;
+	int frames = 0;
+	std::string capturePath;
+	uint32_t framesInFlight = 1;
+	bool frozen = false;
+	float offset = 0.0f;
+	bool culling = true;
+};
+
+class TestApp : public Application {
+public:
+	TestApp(const TestAppOptions& options)
+		: Application("Test App", true, options.headless ? WindowMode::Headless : WindowMode::Windowed),
+		m_options(options), m_flatColorShaders("assets/shaders/flatColor.vert", "assets/shaders/flatColor.frag", { "VERTEX_COLOR" }),
+		m_instancedShader("assets/shaders/instanced.vert", "assets/shaders/instanced.frag"),
+		m_indirectShader("assets/shaders/indirect.vert", "assets/shaders/instanced.frag"),
+		m_triangle(TriangleLayout, vertices, 3), m_instancedTriangle(TriangleLayout, vertices, 3),
+		m_geometryPool(VertexLayout({ VertexAttribute::Float3 }), 1024, 1024), m_indirectDraws(m_geometryPool, sizeof(IndirectObject))
+	{
+		m_instancedTriangle.SetInstanceLayout({ VertexAttribute::Float2, VertexAttribute::Float, VertexAttribute::UByte4Norm }, instancedTriangleCount);
+		m_instances.resize(instancedTriangleCount);
+
+		// Two distinct meshes in one pool, drawn in a single call
+		const float trianglePositions[] = { -0.5f, -0.5f, 0.0f, 0.5f, -0.5f, 0.0f, 0.0f, 0.5f, 0.0f };
+		const uint32_t triangleIndices[] = { 0, 1, 2 };
+		const float quadPositions[] = { -0.5f, -0.5f, 0.0f, 0.5f, -0.5f, 0.0f, 0.5f, 0.5f, 0.0f, -0.5f, 0.5f, 0.0f };
+		const uint32_t quadIndices[] = { 0, 1, 2, 2, 3, 0 };
+		GeometryPool::MeshRange triangleMesh = m_geometryPool.Add(trianglePositions, 3, triangleIndices, 3);
+		GeometryPool::MeshRange quadMesh = m_geometryPool.Add(quadPositions, 4, quadIndices, 6);
+
+		std::vector<glm::vec4> bounds;
+		for(int i = 0; i < indirectObjectCount; i++)
+		{
+			float t = (float)i / (indirectObjectCount - 1);
+			IndirectObject object = { glm::vec4(-0.95f + 1.9f * t, 0.9f, 0.025f, 0.0f), glm::vec4(t, 1.0f - t, 0.5f, 1.0f) };
+			m_indirectDraws.Add(i % 2 == 0 ? triangleMesh : quadMesh, object);
 
-	Shader basicShader("assets/shaders/flatColor.vert", "assets/shaders/flatColor.frag");
+			// Both meshes fit in a unit square around the origin
+			bounds.push_back(glm::vec4(object.offsetScale.x, object.offsetScale.y, 0.0f, object.offsetScale.z * 0.71f));
+		}
+		m_culler.SetBounds(bounds.data(), (uint32_t)bounds.size());
 
-	unsigned int VBO, VAO;
-    glGenVertexArrays(1, &VAO);
-    glGenBuffers(1, &VBO);
-    // bind the Vertex Array Object first, then bind and set vertex buffer(s), and then configure vertex attributes(s).
-    glBindVertexArray(VAO);
+		// Both variants are drawn every frame, compile them now rather than on the first frame
+		m_flatColorShaders.Prewarm({ 0, m_flatColorShaders.GetKey({ "VERTEX_COLOR" }) });
 
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+		SetFramesInFlight(options.framesInFlight);
 
-    // position attribute
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
-    // color attribute
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(3 * sizeof(float)));
+		// Built next to the executable from assets/. Loads through AssetManager come from the pack,
+		// shaders keep reading the loose copies so they can be hot reloaded. Only shaders are copied
+		// loose, so the texture fails to load if the pack does.
+		AssetManager::Mount("assets.pack", "assets");
+		m_checker = AssetManager::Load<TextureAsset>("assets/textures/checker.tga");
 
-	while(!window.ShouldClose())
+		m_blueMaterial.id = 1;
+		m_blueMaterial.color = glm::vec4(0.2f, 0.3f, 0.8f, 1.0f);
+		m_orangeMaterial.id = 2;
+		m_orangeMaterial.color = glm::vec4(0.9f, 0.5f, 0.1f, 1.0f);
+
+		m_offset = m_previousOffset = options.offset;
+	}
+
+protected:
+	void OnUpdate(double timestep) override
 	{
-		window.Clear();
+		if(!m_options.frozen)
+		{
+			m_previousOffset = m_offset;
+			m_offset += (float)timestep * m_direction * 0.5f;
+			if(m_offset > 1.0f || m_offset < -1.0f)
+				m_direction = -m_direction;
+		}
+
+		m_titleTimer += timestep;
+		if(m_titleTimer >= 1.0)
+		{
+			m_titleTimer = 0.0;
+			UpdateTitle();
+		}
+	}
+
+	void OnRender(double alpha) override
+	{
+		float offset = m_previousOffset + (m_offset - m_previousOffset) * (float)alpha;
+		float quadSize = 2.0f / quadGridSize;
+
+		Renderer2D::BeginScene(glm::ortho(-1.0f, 1.0f, -1.0f, 1.0f));
+		for(int y = 0; y < quadGridSize; y++)
+		{
+			for(int x = 0; x < quadGridSize; x++)
+			{
+				glm::vec3 position(-1.0f + (x + 0.5f) * quadSize, -1.0f + (y + 0.5f) * quadSize, -0.5f);
+				glm::vec4 color((float)x / quadGridSize, (float)y / quadGridSize, 0.5f, 1.0f);
+				Renderer2D::DrawQuad(position, glm::vec2(quadSize * 0.9f), color);
+			}
+		}
+		Renderer2D::DrawQuad(glm::vec3(offset, 0.0f, -0.25f), glm::vec2(0.2f), glm::vec4(1.0f));
+		// Inside the ring, streamed in from assets.pack and sampled through a bindless handle where the driver has them
+		if(TextureAsset* checker = m_checker.Get())
+			Renderer2D::DrawQuad(glm::vec3(0.0f, 0.0f, -0.2f), glm::vec2(0.36f), checker->GetTexture());
+		Renderer2D::EndScene();
+
+		// Alternating materials on purpose, the bucket sorts them back into two runs.
+		// Orange triangles also use the vertex color variant of the shader.
+		for(int i = 0; i < triangleCount; i++)
+		{
+			const Material& material = i % 2 == 0 ? m_blueMaterial : m_orangeMaterial;
+			Shader& shader = i % 2 == 0 ? m_flatColorShaders.Get(0) : m_flatColorShaders.Get({ "VERTEX_COLOR" });
+			float x = -0.75f + 1.5f * i / (triangleCount - 1);
+
+			CommandBucket::Draw draw;
+			draw.shader = &shader;
+			draw.material = &material;
+			draw.vertexArray = m_triangle.GetVertexArray();
+			draw.count = 3;
+			draw.transform = glm::scale(glm::translate(glm::mat4(1.0f), glm::vec3(x, -0.6f, 0.0f)), glm::vec3(0.25f));
+			m_bucket.Submit(CommandBucket::MakeKey(0, shader, &material, 0.0f), draw);
+		}
+		m_bucket.Dispatch();
+
+		// A ring of small triangles, one draw call for all of them
+		for(int i = 0; i < instancedTriangleCount; i++)
+		{
+			float angle = i * 0.01f + offset;
+			float radius = 0.3f + 0.6f * i / instancedTriangleCount;
+			uint32_t shade = (uint32_t)(255.0f * i / instancedTriangleCount);
+			m_instances[i] = { glm::vec2(std::cos(angle) * radius, std::sin(angle) * radius), 0.02f, 0xff000000u | (shade << 8) | (255 - shade) };
+		}
+		m_instancedTriangle.DrawInstanced(m_instancedShader, m_instances.data(), instancedTriangleCount);
 
-		basicShader.Use();
-		basicShader.SetUniform4f("uColor", 0.2f, 0.3f, 0.8f, 1.0f);
+		// The row scrolls with the moving quad, objects leaving the screen are culled on the GPU
+		glm::mat4 viewProjection = glm::translate(glm::mat4(1.0f), glm::vec3(offset, 0.0f, 0.0f));
+		RenderThread::Submit([this, viewProjection]()
+		{
+			m_indirectShader.Use();
+			m_indirectShader.SetUniformMat4("uViewProjection", viewProjection);
+		});
+		if(m_options.culling)
+			m_culler.CullAndDraw(m_indirectDraws, m_indirectShader, viewProjection);
+		else
+			m_indirectDraws.Draw(m_indirectShader);
 
-        glBindVertexArray(VAO);
-        glDrawArrays(GL_TRIANGLES, 0, 3);
+		// Captures must not depend on how fast the texture streams in, so frames count once it has
+		if(m_options.frames > 0 && m_checker.IsFailed())
+		{
+			std::cout << "Error: assets/textures/checker.tga did not load from assets.pack\n";
+			m_failed = true;
+			Close();
+		}
+		else if(m_options.frames > 0 && m_checker.IsReady() && ++m_frameCount >= m_options.frames)
+		{
+			if(!m_options.capturePath.empty())
+				RenderThread::Submit([this]() { GetWindow().SaveFrame(m_options.capturePath); });
 
-		window.Update();
+			const FrameStats& frameStats = GetFrameStats();
+			RenderThread::Statistics renderStats = RenderThread::GetStats();
+			std::cout << m_frameCount << " frames, " << frameStats.GetAverage() << " ms avg, " << frameStats.GetP99() << " ms p99, "
+				<< renderStats.commandBytes / 1024 << " KB of render commands (" << renderStats.overflowBytes / 1024 << " KB overflowed a "
+				<< renderStats.arenaCapacity / 1024 << " KB arena), " << AssetManager::GetStats().packLoads << " assets loaded from packs, textures "
+				<< (Texture::IsBindlessSupported() ? "bindless" : "bound to units") << "\n";
+			Close();
+		}
 	}
 
-	return 0;
-}
\ No newline at end of file
+public:
+	bool HasFailed() const { return m_failed; }
+
+private:
+	void UpdateTitle()
+	{
+		const Renderer2D::Statistics& stats = Renderer2D::GetStats();
+		const FrameStats& frameStats = GetFrameStats();
+
+		std::string title = "Test App - " + std::to_string(stats.quadCount) + " quads, " + std::to_string(stats.drawCalls) + " draw calls, "
+			+ std::to_string(frameStats.GetAverage()) + " ms avg, " + std::to_string(frameStats.GetP99()) + " ms p99, "
+			+ std::to_string(GpuProfiler::GetPassTime("Frame")) + " ms GPU, "
+			+ std::to_string(m_bucket.GetStats().stateChangesAvoided) + " state changes avoided, "
+			+ std::to_string(GLState::GetStats().filtered) + "/" + std::to_string(GLState::GetStats().issued + GLState::GetStats().filtered) + " GL calls filtered";
+		glfwSetWindowTitle(GetWindow().GetGLFWWindow(), title.c_str());
+	}
+
+	TestAppOptions m_options;
+	int m_frameCount = 0;
+	bool m_failed = false;
+
+	AssetHandle<TextureAsset> m_checker;
+
+	// Position and per-vertex color, as laid out in vertices
+	inline static const VertexLayout TriangleLayout = { VertexAttribute::Float3, VertexAttribute::Float3 };
+
+	ShaderLibrary m_flatColorShaders;
+	Shader m_instancedShader;
+	Shader m_indirectShader;
+	Mesh m_triangle;
+	Mesh m_instancedTriangle;
+	std::vector<TriangleInstance> m_instances;
+
+	GeometryPool m_geometryPool;
+	IndirectDrawList m_indirectDraws;
+	GpuCuller m_culler;
+
+	CommandBucket m_bucket;
+	Material m_blueMaterial, m_orangeMaterial;
+
+	float m_offset = 0.0f, m_previousOffset = 0.0f, m_direction = 1.0f;
+	double m_titleTimer = 0.0;
+};
+
+int RunTestApp(int argc, char** argv)
+{
+	TestAppOptions options;
+	for(int i = 1; i < argc; i++)
+	{
+		if(std::strcmp(argv[i], "--headless") == 0)
+			options.headless = true;
+		else if(std::strcmp(argv[i], "--frames") == 0 && i + 1 < argc)
+			options.frames = std::atoi(argv[++i]);
+		else if(std::strcmp(argv[i], "--capture") == 0 && i + 1 < argc)
+			options.capturePath = argv[++i];
+		else if(std::strcmp(argv[i], "--frames-in-flight") == 0 && i + 1 < argc)
+			options.framesInFlight = (uint32_t)std::atoi(argv[++i]);
+		else if(std::strcmp(argv[i], "--offset") == 0 && i + 1 < argc)
+		{
+			options.frozen = true;
+			options.offset = (float)std::atof(argv[++i]);
+		}
+		else if(std::strcmp(argv[i], "--no-culling") == 0)
+			options.culling = false;
+	}
+
+	TestApp app(options);
+	app.Run();
+
+	return app.HasFailed() ? 1 : 0;
+}
+
+#ifdef _WIN32
+int APIENTRY WinMain(HINSTANCE hInst, HINSTANCE hInstPrev, PSTR cmdline, int cmdshow)
+{
+	return RunTestApp(__argc, __argv);
+}
+#else
+int main(int argc, char** argv)
+{
+	return RunTestApp(argc, argv);
+}
+#endif